@@ -1,12 +1,15 @@
 #!/bin/bash
 
-# Number of dataset to produce
+# Number of dataset to produce, and of trajectories per dataset
 BATCHES=25
+ITER=1
 
 cd bin/
 
+# Every batch is a shard of the same run: batches never share a path.
 for ((i = 1; i <= BATCHES; i++))
 do
-    ./compute_approximation.exe
+    ./compute_approximation.exe --iter $((ITER * BATCHES)) \
+				--shard "$i/$BATCHES" --output "data/"
     mv "data/" "dataset_$i/"
 done
@@ -0,0 +1,643 @@
+/*
+ * Filename: bench.c
+ *
+ * Summary: benchmark the stages of compute_approximation, on their
+ * own (micro benchmarks) and end to end.
+ *
+ * Usage: bench.exe [-o DIR] [-e EXE] [-k FINEST] [-b BUDGET] [-j THREADS]
+ *
+ *   -o DIR      directory of written files (default: ./bench_data)
+ *   -e EXE      compute_approximation executable run end to end
+ *               (default: ./compute_approximation.exe)
+ *   -k FINEST   finest grid 2^-FINEST (default: 20); grids go from
+ *               2^-7 to 2^-FINEST
+ *   -b BUDGET   about 2^BUDGET steps per measurement (default: 21)
+ *   -j THREADS  largest thread count of the end to end runs (default:
+ *               every core); thread counts are the powers of 2 below
+ *
+ * Stages use the model and the output format of config.h. Results are
+ * printed on the standard output as CSV, one line per (benchmark,
+ * step, threads):
+ *
+ *   benchmark,step,threads,paths,steps,seconds,ns_per_step,
+ *   paths_per_s,bytes_per_s
+ *
+ * 'steps' is the number of steps (or rows, or normal numbers) of a
+ * path, 'seconds' the best time of BENCH_REPEAT runs. Progress is
+ * printed on the standard error.
+ *
+ * Single precision (see PRECISION) is validated first: the strong
+ * error at time T of the Euler-Maruyama scheme, on the coarsest grid,
+ * is estimated in both precisions on the same paths, and must not
+ * move by more than the half width of its confidence interval.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include "config.h"
+#include "monte_carlo.h"
+#include "statistics.h"
+
+
+#ifndef PRNG_SEED
+#define PRNG_SEED 37
+#endif
+
+#ifndef FLOAT_PREC
+#define FLOAT_PREC 10
+#endif
+
+#ifndef TIME_BOUND
+#define TIME_BOUND 1.0
+#endif
+
+#ifndef CONFIDENCE
+#define CONFIDENCE 0.95
+#endif
+
+#define BENCH_REPEAT 3
+#define BENCH_COARSEST 7
+#define BENCH_REFINEMENT 3
+#define BENCH_MAX_PATH 4096
+#define BENCH_MAX_COMMAND 8192
+#define BENCH_BATCH 8
+
+/* The model of config.h, as specialized by compute_approximation. */
+EULER_MARUYAMA_STEP(euler_maruyama_step, deterministic_term,
+		    stochastic_term)
+SCHEME_KERNEL(euler_maruyama_model, euler_maruyama_step)
+EULER_MARUYAMA_STEP_OF(euler_maruyama_single, float, deterministic_term_f,
+		       stochastic_term_f)
+SCHEME_KERNEL_OF(euler_maruyama_single_model, float, euler_maruyama_single)
+
+struct bench
+{
+  /* Parameters and scratch arrays shared by the micro benchmarks. */
+
+  const char *directory;
+  const char *executable;
+  unsigned int finest;
+  unsigned int budget;
+  unsigned int threads;
+  prng_state rng;
+  double *brownian_motion;
+  double *path;
+  double *values;
+  float *single_motion;
+  float *single_path;
+  double *batch_motion;     /* BENCH_BATCH paths, step by step */
+  double *batch_path;
+  float *batch_single_motion;
+  float *batch_single_path;
+};
+
+
+static double
+now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+} /* end of now function */
+
+
+static void
+report(const char *benchmark, double step, unsigned int threads,
+       unsigned long long paths, unsigned long long steps, double seconds,
+       unsigned long long bytes)
+{
+  /* Print a line of results, see the summary above. */
+
+  printf("%s,%.10g,%u,%llu,%llu,%.6f,%.3f,%.3f,%.1f\n", benchmark, step,
+	 threads, paths, steps, seconds, 1e9 * seconds / (paths * steps),
+	 paths / seconds, bytes / seconds);
+  fflush(stdout);
+} /* end of report function */
+
+
+static unsigned long long
+repetitions(const struct bench *bench, unsigned long long steps)
+{
+  /* Number of paths of 'steps' steps giving about 2^budget steps. */
+
+  const unsigned long long total = 1ULL << bench->budget;
+
+  return steps < total ? total / steps : 1;
+} /* end of repetitions function */
+
+
+static void
+bench_rand_normal(struct bench *bench)
+{
+  const unsigned long long count = 1ULL << bench->budget;
+  double best = -1, start, sum = 0;
+
+  for (unsigned int r = 0; r < BENCH_REPEAT; ++r)
+  {
+    start = now();
+    for (unsigned long long j = 0; j < count; ++j)
+    {
+      sum += rand_normal(&bench->rng);
+    }
+    start = now() - start;
+    best = best < 0 || start < best ? start : best;
+  }
+
+  /* Keep 'sum' alive. */
+  fprintf(stderr, "Bench:   rand_normal (mean %.3f)\n", sum
+	  / (BENCH_REPEAT * count));
+  report("rand_normal", 0, 1, 1, count, best, 0);
+} /* end of bench_rand_normal function */
+
+
+static void
+bench_stages(struct bench *bench, unsigned int k)
+{
+  /*
+   * Micro benchmarks on the grid 2^-k: every stage of a path,
+   * repeated on as many paths as the budget allows.
+   */
+
+  const double step = ldexp(1.0, -(int)k);
+  const unsigned int steps = floor(TIME_BOUND / step);
+  const unsigned long long paths = repetitions(bench, steps);
+  const unsigned int coarse = floor(TIME_BOUND
+				    / ldexp(1.0, -BENCH_COARSEST));
+  const unsigned int factor = 1U << (k - BENCH_COARSEST);
+  double best[11] = {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1}, start;
+  double inits[BENCH_BATCH], terms[2 * BENCH_BATCH];
+  float single_inits[BENCH_BATCH], single_terms[2 * BENCH_BATCH];
+  double state[REFERENCE_STATE];
+  const double init = initial_condition();
+  reference_plan plan;
+  unsigned long long bytes[2] = {0, 0};
+  char filename[BENCH_MAX_PATH];
+  double *allocated;
+  csv_writer *writer = init_csv_writer(FORMAT, FLOAT_PREC);
+  sds *atom = init_sds();
+  FILE *output;
+
+  snprintf(filename, sizeof filename, "%s/bench.csv", bench->directory);
+  reference_plan_init(&plan, &REFERENCE_SDE, step);
+  sds_store_precision(atom, FLOAT_PREC);
+  for (unsigned int q = 0; q < BENCH_BATCH; ++q)
+  {
+    inits[q] = init;
+    single_inits[q] = init;
+  }
+
+  for (unsigned int r = 0; r < BENCH_REPEAT; ++r)
+  {
+    double times[11];
+
+    start = now();
+    for (unsigned long long p = 0; p < paths; ++p)
+    {
+      brownian_path_into(&bench->rng, TIME_BOUND, step,
+			 bench->brownian_motion);
+    }
+    times[0] = now() - start;
+
+    start = now();
+    for (unsigned long long p = 0; p < paths; ++p)
+    {
+      allocated = euler_maruyama_method(TIME_BOUND, step,
+					initial_condition(),
+					bench->brownian_motion,
+					&deterministic_term,
+					&stochastic_term);
+      free(allocated);
+    }
+    times[1] = now() - start;
+
+    start = now();
+    for (unsigned long long p = 0; p < paths; ++p)
+    {
+      euler_maruyama_model(TIME_BOUND, step, initial_condition(),
+			   bench->brownian_motion, 1, bench->path);
+    }
+    times[2] = now() - start;
+
+    for (unsigned int j = 0; j <= steps; ++j)
+    {
+      bench->single_motion[j] = bench->brownian_motion[j];
+    }
+    start = now();
+    for (unsigned long long p = 0; p < paths; ++p)
+    {
+      euler_maruyama_single_model(TIME_BOUND, step, initial_condition(),
+				  bench->single_motion, 1,
+				  bench->single_path);
+    }
+    times[8] = now() - start;
+
+    /* The same paths, BENCH_BATCH at a time, in lockstep. */
+    for (unsigned int j = 0; j <= steps; ++j)
+    {
+      for (unsigned int q = 0; q < BENCH_BATCH; ++q)
+      {
+	bench->batch_motion[(size_t)j * BENCH_BATCH + q]
+	  = bench->brownian_motion[j];
+      }
+    }
+    start = now();
+    for (unsigned long long p = 0; p < paths; p += BENCH_BATCH)
+    {
+      euler_maruyama_batch_into(TIME_BOUND, step, BENCH_BATCH, inits,
+				bench->batch_motion,
+				&deterministic_term_batch,
+				&stochastic_term_batch, bench->batch_path,
+				terms);
+    }
+    times[9] = now() - start;
+
+    /* The same batch in single precision. */
+    for (size_t j = 0; j <= (size_t)steps * BENCH_BATCH; ++j)
+    {
+      bench->batch_single_motion[j] = bench->batch_motion[j];
+    }
+    start = now();
+    for (unsigned long long p = 0; p < paths; p += BENCH_BATCH)
+    {
+      euler_maruyama_batch_into_f(TIME_BOUND, step, BENCH_BATCH,
+				  single_inits, bench->batch_single_motion,
+				  &deterministic_term_batch_f,
+				  &stochastic_term_batch_f,
+				  bench->batch_single_path, single_terms);
+    }
+    times[10] = now() - start;
+
+    /* From the coarsest grid to the grid 2^-k, as with COMPARE. */
+    start = now();
+    for (unsigned long long p = 0; p < paths; ++p)
+    {
+      linear_interpolation_into(bench->path, coarse + 1, factor,
+				bench->values);
+    }
+    times[3] = now() - start;
+
+    start = now();
+    for (unsigned long long p = 0; p < paths; ++p)
+    {
+      reference_start(state);
+      bench->values[0] = reference_value(state, 0);
+      for (unsigned int j = 1; j <= steps; ++j)
+      {
+	reference_update(state, (j - 1) * step, bench->brownian_motion[j]
+			 - bench->brownian_motion[j - 1]);
+	bench->values[j] = reference_value(state, j * step);
+      }
+    }
+    times[4] = now() - start;
+
+    start = now();
+    for (unsigned long long p = 0; p < paths; ++p)
+    {
+      reference_linear_batch(&plan, steps, 1, &init, bench->brownian_motion,
+			     bench->values);
+    }
+    times[7] = now() - start;
+
+    /* Output stages write every row of one path (time, X, Y). */
+    output = fopen(filename, "w");
+    start = now();
+    for (unsigned int j = 0; output != NULL && j <= steps; ++j)
+    {
+      double row[3] = {j * step, bench->path[j], bench->values[j]};
+
+      sds_store_array_double(atom, row, 3);
+      print_sds_in_csv(output, FORMAT, atom);
+    }
+    if (output != NULL)
+    {
+      bytes[0] = ftell(output);
+      fclose(output);
+    }
+    times[5] = now() - start;
+
+    output = fopen(filename, "w");
+    start = now();
+    if (output != NULL && writer != NULL)
+    {
+      csv_begin(writer, output);
+      for (unsigned int j = 0; j <= steps; ++j)
+      {
+	double row[3] = {j * step, bench->path[j], bench->values[j]};
+
+	csv_write_row(writer, row, 3);
+      }
+      csv_end(writer);
+      bytes[1] = ftell(output);
+      fclose(output);
+    }
+    times[6] = now() - start;
+
+    for (unsigned int s = 0; s < 11; ++s)
+    {
+      best[s] = best[s] < 0 || times[s] < best[s] ? times[s] : best[s];
+    }
+  }
+
+  remove(filename);
+  free_csv_writer(writer);
+
+  report("brownian_path", step, 1, paths, steps, best[0], 0);
+  report("euler_maruyama_method", step, 1, paths, steps, best[1], 0);
+  report("euler_maruyama_model", step, 1, paths, steps, best[2], 0);
+  report("euler_maruyama_single", step, 1, paths, steps, best[8], 0);
+  report("euler_maruyama_batch", step, 1,
+	 (paths + BENCH_BATCH - 1) / BENCH_BATCH * BENCH_BATCH, steps, best[9],
+	 0);
+  report("euler_maruyama_batch_single", step, 1,
+	 (paths + BENCH_BATCH - 1) / BENCH_BATCH * BENCH_BATCH, steps,
+	 best[10], 0);
+  report("linear_interpolation", step, 1, paths, steps, best[3], 0);
+  report("reference_process", step, 1, paths, steps, best[4], 0);
+  report("reference_linear", step, 1, paths, steps, best[7], 0);
+  report("print_sds_in_csv", step, 1, 1, steps + 1, best[5], bytes[0]);
+  report("csv_write_row", step, 1, 1, steps + 1, best[6], bytes[1]);
+} /* end of bench_stages function */
+
+
+static double
+terminal_reference(const reference_plan *plan, unsigned int steps,
+		   double step, const double *brownian_motion, double *values)
+{
+  /* Reference process at time T (see REFERENCE), on 'steps' steps. */
+
+  const double init = initial_condition();
+  double state[REFERENCE_STATE];
+
+  if (REFERENCE == REFERENCE_LINEAR)
+  {
+    reference_linear_batch(plan, steps, 1, &init, brownian_motion, values);
+    return values[steps];
+  }
+
+  reference_start(state);
+  for (unsigned int j = 1; j <= steps; ++j)
+  {
+    reference_update(state, (j - 1) * step, brownian_motion[j]
+		     - brownian_motion[j - 1]);
+  }
+
+  return reference_value(state, steps * step);
+} /* end of terminal_reference function */
+
+
+static int
+bench_precision(struct bench *bench)
+{
+  /*
+   * Validate single precision (see the summary above): the strong
+   * error E|X_T - Y_T| on the coarsest grid, from a Brownian motion
+   * 2^BENCH_REFINEMENT times finer, estimated in both precisions on
+   * as many paths as the budget allows.
+   */
+
+  const double step = ldexp(1.0, -BENCH_COARSEST);
+  const double fine = ldexp(1.0, -(BENCH_COARSEST + BENCH_REFINEMENT));
+  const unsigned int coarse = floor(TIME_BOUND / step);
+  const unsigned int steps = floor(TIME_BOUND / fine);
+  const unsigned int factor = 1U << BENCH_REFINEMENT;
+  const unsigned long long paths = repetitions(bench, steps);
+  double seconds[2] = {0, 0}, start, exact, width;
+  accumulator error[2];
+  reference_plan plan;
+  prng_state rng;
+
+  if (REFERENCE == REFERENCE_LINEAR
+      && reference_plan_init(&plan, &REFERENCE_SDE, fine) != 0)
+  {
+    fprintf(stderr, "Fatal:   REFERENCE_SDE has no closed form.\n");
+    return EXIT_FAILURE;
+  }
+
+  acc_init(&error[0]);
+  acc_init(&error[1]);
+  for (unsigned long long p = 0; p < paths; ++p)
+  {
+    prng_init(&rng, GENERATOR, PRNG_SEED, p);
+    brownian_path_into(&rng, TIME_BOUND, fine, bench->brownian_motion);
+    for (unsigned int j = 0; j <= steps; ++j)
+    {
+      bench->single_motion[j] = bench->brownian_motion[j];
+    }
+    exact = terminal_reference(&plan, steps, fine, bench->brownian_motion,
+			       bench->values);
+
+    start = now();
+    euler_maruyama_model(TIME_BOUND, step, initial_condition(),
+			 bench->brownian_motion, factor, bench->path);
+    seconds[0] += now() - start;
+    start = now();
+    euler_maruyama_single_model(TIME_BOUND, step, initial_condition(),
+				bench->single_motion, factor,
+				bench->single_path);
+    seconds[1] += now() - start;
+
+    acc_push(&error[0], fabs(bench->path[coarse] - exact));
+    acc_push(&error[1], fabs(bench->single_path[coarse] - exact));
+  }
+
+  width = acc_half_width(&error[0], CONFIDENCE);
+  fprintf(stderr, "Bench:   strong error on 2^-%d (%llu paths): double "
+	  "%.6e +- %.1e, single %.6e +- %.1e\n", BENCH_COARSEST, paths,
+	  error[0].mean, width, error[1].mean,
+	  acc_half_width(&error[1], CONFIDENCE));
+  report("strong_error_double", step, 1, paths, coarse, seconds[0], 0);
+  report("strong_error_single", step, 1, paths, coarse, seconds[1], 0);
+
+  if (fabs(error[1].mean - error[0].mean) > width)
+  {
+    fprintf(stderr, "Fatal:   Single precision moves the strong error "
+	    "out of its confidence interval.\n");
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+} /* end of bench_precision function */
+
+
+static int
+bench_end_to_end(struct bench *bench, unsigned int k, unsigned int threads)
+{
+  /*
+   * Run the executable on the grid 2^-k (approximation and Brownian
+   * motion), with 'threads' threads and at least as many paths, and
+   * measure the size of the written files, removed afterwards.
+   */
+
+  const double step = ldexp(1.0, -(int)k);
+  const unsigned int steps = floor(TIME_BOUND / step);
+  unsigned long long paths = repetitions(bench, steps);
+  char command[BENCH_MAX_COMMAND];
+  char filename[BENCH_MAX_PATH];
+  unsigned long long bytes = 0;
+  double best = -1, start;
+  struct stat st;
+  int status = 0;
+
+  paths = paths < threads ? threads : paths;
+  snprintf(command, sizeof command, "%s -o %s -n %llu -j %u "
+	   "--step-precision 2^-%u --brownian-precision 2^-%u > /dev/null",
+	   bench->executable, bench->directory, paths, threads, k, k);
+
+  for (unsigned int r = 0; r < BENCH_REPEAT && status == 0; ++r)
+  {
+    start = now();
+    status = system(command);
+    start = now() - start;
+    best = best < 0 || start < best ? start : best;
+
+    bytes = 0;
+    for (unsigned long long i = 1; i <= paths; ++i)
+    {
+      snprintf(filename, sizeof filename, "%s/data_%llu.%s",
+	       bench->directory, i, OUTPUT == BINARY ? "bin" : "csv");
+      if (stat(filename, &st) == 0)
+      {
+	bytes += st.st_size;
+	remove(filename);
+      }
+    }
+  }
+
+  if (status != 0)
+  {
+    fprintf(stderr, "Fatal:   '%s' failed.\n", command);
+    return EXIT_FAILURE;
+  }
+
+  report("end_to_end", step, threads, paths, steps, best, bytes);
+
+  return 0;
+} /* end of bench_end_to_end function */
+
+
+int
+main(int argc, char **argv)
+{
+  struct bench bench = {"./bench_data", "./compute_approximation.exe", 20,
+    21, 0, {0}, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL};
+  size_t length;
+  struct stat st;
+  int status = EXIT_SUCCESS;
+
+  for (int i = 1; i + 1 < argc; i += 2)
+  {
+    if (strcmp(argv[i], "-o") == 0)
+    {
+      bench.directory = argv[i + 1];
+    }
+    else if (strcmp(argv[i], "-e") == 0)
+    {
+      bench.executable = argv[i + 1];
+    }
+    else if (strcmp(argv[i], "-k") == 0)
+    {
+      bench.finest = atoi(argv[i + 1]);
+    }
+    else if (strcmp(argv[i], "-b") == 0)
+    {
+      bench.budget = atoi(argv[i + 1]);
+    }
+    else if (strcmp(argv[i], "-j") == 0)
+    {
+      bench.threads = atoi(argv[i + 1]);
+    }
+  }
+
+  if (argc % 2 == 0 || bench.finest < BENCH_COARSEST || bench.finest > 30
+      || bench.budget > 40)
+  {
+    fprintf(stderr, "Usage: %s [-o DIR] [-e EXE] [-k FINEST] [-b BUDGET] "
+	    "[-j THREADS]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (bench.threads == 0)
+  {
+    bench.threads = mc_available_threads();
+  }
+
+  if (stat(bench.directory, &st) == -1 && mkdir(bench.directory, 0700) == -1)
+  {
+    fprintf(stderr, "Fatal:   Cannot create directory %s.\n",
+	    bench.directory);
+    return EXIT_FAILURE;
+  }
+
+  /* The finest grid, or the one of bench_precision. */
+  length = bench.finest > BENCH_COARSEST + BENCH_REFINEMENT ? bench.finest
+    : BENCH_COARSEST + BENCH_REFINEMENT;
+  length = (size_t)floor(TIME_BOUND / ldexp(1.0, -(int)length)) + 1;
+  bench.brownian_motion = malloc(length * sizeof *bench.brownian_motion);
+  bench.path = malloc(length * sizeof *bench.path);
+  bench.values = malloc(length * sizeof *bench.values);
+  bench.single_motion = malloc(length * sizeof *bench.single_motion);
+  bench.single_path = malloc(length * sizeof *bench.single_path);
+  bench.batch_motion = malloc(length * BENCH_BATCH
+			      * sizeof *bench.batch_motion);
+  bench.batch_path = malloc(length * BENCH_BATCH * sizeof *bench.batch_path);
+  bench.batch_single_motion = malloc(length * BENCH_BATCH
+				     * sizeof *bench.batch_single_motion);
+  bench.batch_single_path = malloc(length * BENCH_BATCH
+				   * sizeof *bench.batch_single_path);
+  if (bench.brownian_motion == NULL || bench.path == NULL
+      || bench.values == NULL || bench.single_motion == NULL
+      || bench.single_path == NULL || bench.batch_motion == NULL
+      || bench.batch_path == NULL || bench.batch_single_motion == NULL
+      || bench.batch_single_path == NULL)
+  {
+    fprintf(stderr, "Fatal:   Not enough (heap) space.\n");
+    status = EXIT_FAILURE;
+  }
+
+  rand_normal_init();
+  prng_init(&bench.rng, GENERATOR, PRNG_SEED, 0);
+
+  if (status == EXIT_SUCCESS)
+  {
+    printf("benchmark,step,threads,paths,steps,seconds,ns_per_step,"
+	   "paths_per_s,bytes_per_s\n");
+    bench_rand_normal(&bench);
+    status = bench_precision(&bench);
+  }
+
+  for (unsigned int k = BENCH_COARSEST; status == EXIT_SUCCESS
+	 && k <= bench.finest; ++k)
+  {
+    fprintf(stderr, "Bench:   grid 2^-%u\n", k);
+    bench_stages(&bench, k);
+    for (unsigned int t = 1; status == EXIT_SUCCESS && t <= bench.threads;
+	 t *= 2)
+    {
+      status = bench_end_to_end(&bench, k, t);
+    }
+  }
+
+  free(bench.brownian_motion);
+  free(bench.path);
+  free(bench.values);
+  free(bench.single_motion);
+  free(bench.single_path);
+  free(bench.batch_motion);
+  free(bench.batch_path);
+  free(bench.batch_single_motion);
+  free(bench.batch_single_path);
+
+  return status;
+} /* end of main */
@@ -0,0 +1,107 @@
+/*
+ * Filename: arena.c
+ *
+ * Summary: implements a bump allocator ("arena") holding the scratch
+ * buffers of a worker.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#include <stdlib.h>
+
+#include "arena.h"
+
+
+static size_t
+round_up(size_t size)
+{
+  return (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+} /* end of round_up function */
+
+
+int
+arena_init(arena *a, size_t size)
+{
+  /*
+   * Allocate 'size' bytes (rounded up to ARENA_ALIGN). Returns 0 on
+   * success, ARENA_ERR_ALLOC otherwise.
+   */
+
+  a->size = round_up(size);
+  a->used = 0;
+  a->base = a->size > 0 ? aligned_alloc(ARENA_ALIGN, a->size) : NULL;
+
+  if (a->base == NULL && a->size > 0)
+  {
+    a->size = 0;
+    return ARENA_ERR_ALLOC;
+  }
+  
+  return 0;
+} /* end of arena_init function */
+
+
+void *
+arena_alloc(arena *a, size_t size)
+{
+  /*
+   * Returns a slice of 'size' bytes aligned on ARENA_ALIGN, or NULL
+   * if the arena is too small. Slices live until arena_reset or
+   * arena_free.
+   */
+
+  void *slice;
+  
+  size = round_up(size);
+  if (size > a->size - a->used)
+  {
+    return NULL;
+  }
+
+  slice = a->base + a->used;
+  a->used += size;
+  
+  return slice;
+} /* end of arena_alloc function */
+
+
+double *
+arena_doubles(arena *a, size_t count)
+{
+  return arena_alloc(a, count * sizeof(double));
+} /* end of arena_doubles function */
+
+
+void
+arena_reset(arena *a)
+{
+  /* Every slice is given back at once. */
+  
+  a->used = 0;
+} /* end of arena_reset function */
+
+
+void
+arena_free(arena *a)
+{
+  free(a->base);
+  a->base = NULL;
+  a->size = 0;
+  a->used = 0;
+} /* end of arena_free function */
+
+
+size_t
+arena_size_of_doubles(size_t count)
+{
+  /*
+   * Number of bytes used by arena_doubles(a, count), to size an
+   * arena before allocating it.
+   */
+  
+  return round_up(count * sizeof(double));
+} /* end of arena_size_of_doubles function */
@@ -0,0 +1,57 @@
+/*
+ * Filename: arena.h
+ *
+ * Summary: defines a bump allocator ("arena") holding the scratch
+ * buffers of a worker.
+ *
+ * An arena is allocated once, sized from the number of steps of the
+ * simulation, and handed out in aligned slices; it is released as a
+ * whole. No allocation happens while paths are being computed.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+
+/* Slices are aligned on cache lines. */
+#define ARENA_ALIGN 64
+
+typedef enum {ARENA_ERR_ALLOC=-1536} arena_error_t;
+
+struct arena
+{
+  unsigned char *base;
+  size_t size;
+  size_t used;
+};
+
+typedef struct arena arena;
+
+extern int
+arena_init(arena *a, size_t size);
+
+extern void *
+arena_alloc(arena *a, size_t size);
+
+extern double *
+arena_doubles(arena *a, size_t count);
+
+extern void
+arena_reset(arena *a);
+
+extern void
+arena_free(arena *a);
+
+extern size_t
+arena_size_of_doubles(size_t count);
+
+
+#endif /* ARENA_H */
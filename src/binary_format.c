@@ -0,0 +1,749 @@
+/*
+ * Filename: binary_format.c
+ *
+ * Summary: implements a binary columnar format to store the data
+ * produced during the simulation.
+ *
+ * The file is sized once from its header, then mapped in memory:
+ * columns are written (resp. read) directly in the mapping, with
+ * neither text conversion nor intermediate copy. See binary_format.h
+ * for the layout.
+ *
+ * A dataset is written by chunks with plain writes, its header being
+ * completed when it is closed, and mapped in memory to be read: a
+ * path is then found through the index, without reading the others.
+ * Records hold their own path number and size, hence the index of a
+ * dataset which was not closed is rebuilt by walking through them
+ * (see bin_dataset_resume).
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "binary_format.h"
+
+
+static int
+host_is_little_endian(void)
+{
+  const uint16_t probe = 1;
+
+  return *(const unsigned char *)&probe == 1;
+} /* end of host_is_little_endian function */
+
+
+static void
+swap_words(unsigned char *data, size_t words)
+{
+  /* Reverse the bytes of every 64-bit word in 'data'. */
+  
+  unsigned char tmp;
+
+  for (size_t w = 0; w < words; ++w)
+  {
+    for (unsigned int k = 0; k < 4; ++k)
+    {
+      tmp = data[8 * w + k];
+      data[8 * w + k] = data[8 * w + 7 - k];
+      data[8 * w + 7 - k] = tmp;
+    }
+  }
+} /* end of swap_words function */
+
+
+static void
+store_le(unsigned char *dest, uint64_t value, unsigned int bytes)
+{
+  for (unsigned int k = 0; k < bytes; ++k)
+  {
+    dest[k] = (unsigned char)(value >> (8 * k));
+  }
+} /* end of store_le function */
+
+
+static uint64_t
+load_le(const unsigned char *src, unsigned int bytes)
+{
+  uint64_t value = 0;
+  
+  for (unsigned int k = 0; k < bytes; ++k)
+  {
+    value |= (uint64_t)src[k] << (8 * k);
+  }
+
+  return value;
+} /* end of load_le function */
+
+
+static uint64_t
+double_bits(double value)
+{
+  uint64_t bits;
+
+  memcpy(&bits, &value, sizeof bits);
+  return bits;
+} /* end of double_bits function */
+
+
+static double
+bits_double(uint64_t bits)
+{
+  double value;
+
+  memcpy(&value, &bits, sizeof value);
+  return value;
+} /* end of bits_double function */
+
+
+static void
+store_header(unsigned char *dest, const char *magic, const bin_header *header)
+{
+  /* The first BIN_HEADER_SIZE bytes of a file, see binary_format.h. */
+
+  memcpy(dest, magic, 8);
+  store_le(dest + 8, BIN_VERSION, 4);
+  store_le(dest + 12, header->columns, 4);
+  store_le(dest + 16, header->rows, 8);
+  store_le(dest + 24, double_bits(header->step), 8);
+  store_le(dest + 32, double_bits(header->time_bound), 8);
+  store_le(dest + 40, header->seed, 8);
+  store_le(dest + 48, header->path, 8);
+  store_le(dest + 56, 0, 8);
+} /* end of store_header function */
+
+
+static int
+write_all(int fd, const unsigned char *data, size_t size)
+{
+  ssize_t count;
+
+  while (size > 0)
+  {
+    count = write(fd, data, size);
+    if (count == -1 && errno == EINTR)
+    {
+      continue;
+    }
+    if (count <= 0)
+    {
+      return BIN_ERR_WRITE;
+    }
+    data += count;
+    size -= count;
+  } /* end of while-loop */
+
+  return 0;
+} /* end of write_all function */
+
+
+int
+bin_create(bin_file *file, const char *filename, const bin_header *header)
+{
+  /*
+   * Create (or truncate) 'filename', size it for 'header' and map it
+   * in memory. Columns are then filled through bin_column, and the
+   * file is written back by bin_close.
+   *
+   * Returns 0 on success, a negative error code otherwise.
+   */
+  
+  unsigned char *map;
+
+  file->header = *header;
+  file->size = BIN_HEADER_SIZE
+    + (size_t)header->columns * header->rows * sizeof(double);
+  file->writable = 1;
+  file->fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+  if (file->fd == -1)
+  {
+    return BIN_ERR_OPEN;
+  }
+
+  if (ftruncate(file->fd, file->size) == -1)
+  {
+    close(file->fd);
+    return BIN_ERR_MAP;
+  }
+
+  map = mmap(NULL, file->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+	     file->fd, 0);
+  if (map == MAP_FAILED)
+  {
+    close(file->fd);
+    return BIN_ERR_MAP;
+  }
+  file->map = map;
+  store_header(map, BIN_MAGIC, header);
+
+  return 0;
+} /* end of bin_create function */
+
+
+int
+bin_open(bin_file *file, const char *filename)
+{
+  /*
+   * Map 'filename' in memory, read-only. On a little-endian host
+   * (nearly every host), columns are read in place without any copy.
+   *
+   * Returns 0 on success, a negative error code otherwise.
+   */
+
+  struct stat st;
+  unsigned char *map;
+
+  file->writable = 0;
+  file->fd = open(filename, O_RDONLY);
+
+  if (file->fd == -1)
+  {
+    return BIN_ERR_OPEN;
+  }
+
+  if (fstat(file->fd, &st) == -1 || st.st_size < BIN_HEADER_SIZE)
+  {
+    close(file->fd);
+    return BIN_ERR_FORMAT;
+  }
+  file->size = st.st_size;
+
+  /* Private mapping: byte swapping on big-endian hosts stays local. */
+  map = mmap(NULL, file->size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+	     file->fd, 0);
+  if (map == MAP_FAILED)
+  {
+    close(file->fd);
+    return BIN_ERR_MAP;
+  }
+  file->map = map;
+
+  file->header.columns = load_le(map + 12, 4);
+  file->header.rows = load_le(map + 16, 8);
+  file->header.step = bits_double(load_le(map + 24, 8));
+  file->header.time_bound = bits_double(load_le(map + 32, 8));
+  file->header.seed = load_le(map + 40, 8);
+  file->header.path = load_le(map + 48, 8);
+
+  if (memcmp(map, BIN_MAGIC, 8) != 0 || load_le(map + 8, 4) != BIN_VERSION
+      || file->size < BIN_HEADER_SIZE + (size_t)file->header.columns
+      * file->header.rows * sizeof(double))
+  {
+    munmap(map, file->size);
+    close(file->fd);
+    return BIN_ERR_FORMAT;
+  }
+
+  if (!host_is_little_endian())
+  {
+    swap_words(map + BIN_HEADER_SIZE,
+	       (size_t)file->header.columns * file->header.rows);
+  }
+
+  return 0;
+} /* end of bin_open function */
+
+
+double *
+bin_column(bin_file *file, unsigned int column)
+{
+  /*
+   * Returns the 'rows' values of the column, in the mapping.
+   */
+  
+  if (column >= file->header.columns)
+  {
+    return NULL;
+  }
+
+  return (double *)(file->map + BIN_HEADER_SIZE)
+    + (size_t)column * file->header.rows;
+} /* end of bin_column function */
+
+
+int
+bin_close(bin_file *file)
+{
+  /*
+   * Unmap the file. A created file is written back on disk.
+   */
+
+  int status = 0;
+
+  if (file->writable && !host_is_little_endian())
+  {
+    swap_words(file->map + BIN_HEADER_SIZE,
+	       (size_t)file->header.columns * file->header.rows);
+  }
+
+  if (munmap(file->map, file->size) == -1)
+  {
+    status = BIN_ERR_MAP;
+  }
+
+  if (close(file->fd) == -1)
+  {
+    status = BIN_ERR_OPEN;
+  }
+  
+  return status;
+} /* end of bin_close function */
+
+
+int
+bin_dataset_create(bin_dataset *set, const char *filename,
+		   const bin_header *header)
+{
+  /*
+   * Create (or truncate) the dataset 'filename', whose records have
+   * the columns, step, time bound and seed of 'header'. Records are
+   * then added by bin_dataset_append, and the dataset completed by
+   * bin_dataset_close.
+   *
+   * Returns 0 on success, a negative error code otherwise.
+   */
+
+  unsigned char head[BIN_HEADER_SIZE];
+
+  memset(set, 0, sizeof *set);
+  set->header = *header;
+  set->header.rows = 0;
+  set->header.path = 0;
+  set->writable = 1;
+  set->offset = BIN_HEADER_SIZE;
+  set->capacity = BIN_CHUNK_SIZE;
+  set->chunk = malloc(set->capacity);
+  if (set->chunk == NULL)
+  {
+    return BIN_ERR_ALLOC;
+  }
+
+  set->fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (set->fd == -1)
+  {
+    free(set->chunk);
+    return BIN_ERR_OPEN;
+  }
+
+  /* Incomplete until closed: no path, no index. */
+  store_header(head, BIN_DATASET_MAGIC, &set->header);
+  if (write_all(set->fd, head, BIN_HEADER_SIZE) != 0)
+  {
+    free(set->chunk);
+    close(set->fd);
+    return BIN_ERR_WRITE;
+  }
+
+  return 0;
+} /* end of bin_dataset_create function */
+
+
+static int
+flush_chunk(bin_dataset *set)
+{
+  /* Write the records of the chunk, little-endian. */
+
+  const size_t used = set->used;
+  uint64_t rows;
+
+  if (!host_is_little_endian())
+  {
+    for (size_t at = 0; at < used; at += BIN_RECORD_SIZE
+	   + (size_t)set->header.columns * rows * sizeof(double))
+    {
+      rows = load_le(set->chunk + at + 8, 8);
+      swap_words(set->chunk + at + BIN_RECORD_SIZE,
+		 (size_t)set->header.columns * rows);
+    }
+  }
+
+  set->used = 0;
+  set->offset += used;
+
+  return write_all(set->fd, set->chunk, used);
+} /* end of flush_chunk function */
+
+
+double *
+bin_dataset_append(bin_dataset *set, uint64_t path, uint64_t rows)
+{
+  /*
+   * Add the record of a path of 'rows' rows to the dataset. Returns
+   * its columns, one after the other, to be filled before the next
+   * call to bin_dataset_append or bin_dataset_close; NULL if the
+   * record cannot be added.
+   *
+   * Paths should be appended by increasing number, so that
+   * bin_dataset_find finds them in constant time.
+   */
+
+  const size_t size = BIN_RECORD_SIZE
+    + (size_t)set->header.columns * rows * sizeof(double);
+  unsigned char *chunk;
+  uint64_t *index;
+  size_t capacity;
+
+  if (set->capacity - set->used < size)
+  {
+    if (flush_chunk(set) != 0)
+    {
+      return NULL;
+    }
+    
+    if (size > set->capacity)
+    {
+      chunk = realloc(set->chunk, size);
+      if (chunk == NULL)
+      {
+	return NULL;
+      }
+      set->chunk = chunk;
+      set->capacity = size;
+    }
+  }
+
+  if (set->count == set->index_capacity)
+  {
+    capacity = set->index_capacity > 0 ? 2 * set->index_capacity : 1024;
+    index = realloc(set->index, 3 * capacity * sizeof *index);
+    if (index == NULL)
+    {
+      return NULL;
+    }
+    set->index = index;
+    set->index_capacity = capacity;
+  }
+
+  set->index[3 * set->count] = path;
+  set->index[3 * set->count + 1] = set->offset + set->used;
+  set->index[3 * set->count + 2] = rows;
+  set->count++;
+
+  chunk = set->chunk + set->used;
+  store_le(chunk, path, 8);
+  store_le(chunk + 8, rows, 8);
+  set->used += size;
+
+  return (double *)(chunk + BIN_RECORD_SIZE);
+} /* end of bin_dataset_append function */
+
+
+int
+bin_dataset_sync(bin_dataset *set)
+{
+  /*
+   * Write the records appended so far and flush them to the disk:
+   * they are kept if the process stops before the dataset is closed
+   * (see bin_dataset_resume).
+   *
+   * Returns 0 on success, BIN_ERR_WRITE otherwise.
+   */
+
+  if (flush_chunk(set) != 0 || fsync(set->fd) == -1)
+  {
+    return BIN_ERR_WRITE;
+  }
+
+  return 0;
+} /* end of bin_dataset_sync function */
+
+
+int
+bin_dataset_resume(bin_dataset *set, const char *filename,
+		   const bin_header *header, uint64_t count)
+{
+  /*
+   * Reopen the dataset 'filename', created with 'header', to append
+   * records after its first 'count' ones (e.g. the
+   * records synced by bin_dataset_sync). Their index is rebuilt from
+   * the records themselves, and anything after them is discarded.
+   *
+   * Returns 0 on success, a negative error code otherwise
+   * (BIN_ERR_FORMAT if the header differs or records are missing).
+   */
+
+  unsigned char head[BIN_HEADER_SIZE];
+  unsigned char record[BIN_RECORD_SIZE];
+  struct stat st;
+  int status = 0;
+
+  memset(set, 0, sizeof *set);
+  set->header = *header;
+  set->header.rows = 0;
+  set->header.path = 0;
+  set->writable = 1;
+  set->offset = BIN_HEADER_SIZE;
+  set->capacity = BIN_CHUNK_SIZE;
+  set->index_capacity = count > 0 ? count : 1;
+  set->chunk = malloc(set->capacity);
+  set->index = malloc(3 * set->index_capacity * sizeof *set->index);
+  if (set->chunk == NULL || set->index == NULL)
+  {
+    free(set->chunk);
+    free(set->index);
+    return BIN_ERR_ALLOC;
+  }
+
+  set->fd = open(filename, O_RDWR);
+  if (set->fd == -1)
+  {
+    free(set->chunk);
+    free(set->index);
+    return BIN_ERR_OPEN;
+  }
+
+  /*
+   * Same header as a new dataset, but for the number of paths and
+   * the offset of the index, if it was closed on an error.
+   */
+  store_header(head, BIN_DATASET_MAGIC, &set->header);
+  if (fstat(set->fd, &st) == -1
+      || pread(set->fd, set->chunk, BIN_HEADER_SIZE, 0) != BIN_HEADER_SIZE
+      || memcmp(set->chunk, head, 16) != 0
+      || memcmp(set->chunk + 24, head + 24, 24) != 0)
+  {
+    status = BIN_ERR_FORMAT;
+  }
+
+  for (uint64_t k = 0; k < count && status == 0; ++k)
+  {
+    if (pread(set->fd, record, BIN_RECORD_SIZE, set->offset)
+	!= BIN_RECORD_SIZE)
+    {
+      status = BIN_ERR_FORMAT;
+      break;
+    }
+    set->index[3 * k] = load_le(record, 8);
+    set->index[3 * k + 1] = set->offset;
+    set->index[3 * k + 2] = load_le(record + 8, 8);
+    set->offset += BIN_RECORD_SIZE + (uint64_t)set->header.columns
+      * set->index[3 * k + 2] * sizeof(double);
+  }
+  set->count = count;
+
+  if (status == 0 && (set->offset > (uint64_t)st.st_size
+		      || ftruncate(set->fd, set->offset) == -1
+		      || lseek(set->fd, set->offset, SEEK_SET) == -1))
+  {
+    status = BIN_ERR_FORMAT;
+  }
+
+  if (status != 0)
+  {
+    close(set->fd);
+    free(set->chunk);
+    free(set->index);
+    set->chunk = NULL;
+    set->index = NULL;
+  }
+
+  return status;
+} /* end of bin_dataset_resume function */
+
+
+int
+bin_dataset_close(bin_dataset *set)
+{
+  /*
+   * Written dataset: write the last records and the index, then
+   * complete the header. Mapped dataset: unmap it.
+   *
+   * Returns 0 on success, a negative error code otherwise.
+   */
+
+  unsigned char head[BIN_HEADER_SIZE];
+  int status = 0;
+
+  if (!set->writable)
+  {
+    if (munmap(set->map, set->size) == -1)
+    {
+      status = BIN_ERR_MAP;
+    }
+    if (close(set->fd) == -1)
+    {
+      status = BIN_ERR_OPEN;
+    }
+    return status;
+  }
+
+  status = flush_chunk(set);
+
+  /* The index goes through the chunk, a word at a time. */
+  set->header.rows = set->count;
+  set->header.path = set->offset;
+  for (size_t k = 0; k < 3 * set->count && status == 0; ++k)
+  {
+    store_le(set->chunk + set->used, set->index[k], 8);
+    set->used += 8;
+    if (set->used + 8 > set->capacity || k + 1 == 3 * set->count)
+    {
+      status = write_all(set->fd, set->chunk, set->used);
+      set->used = 0;
+    }
+  }
+
+  store_header(head, BIN_DATASET_MAGIC, &set->header);
+  if (status == 0 && pwrite(set->fd, head, BIN_HEADER_SIZE, 0)
+      != BIN_HEADER_SIZE)
+  {
+    status = BIN_ERR_WRITE;
+  }
+
+  if (close(set->fd) == -1 && status == 0)
+  {
+    status = BIN_ERR_WRITE;
+  }
+  free(set->chunk);
+  free(set->index);
+  set->chunk = NULL;
+  set->index = NULL;
+
+  return status;
+} /* end of bin_dataset_close function */
+
+
+int
+bin_dataset_open(bin_dataset *set, const char *filename)
+{
+  /*
+   * Map the dataset 'filename' in memory, read-only, and check its
+   * index. Returns 0 on success, a negative error code otherwise
+   * (BIN_ERR_FORMAT for a dataset which was not closed).
+   */
+
+  struct stat st;
+  unsigned char *map;
+  uint64_t offset, rows;
+  size_t end;
+
+  memset(set, 0, sizeof *set);
+  set->fd = open(filename, O_RDONLY);
+  if (set->fd == -1)
+  {
+    return BIN_ERR_OPEN;
+  }
+
+  if (fstat(set->fd, &st) == -1 || st.st_size < BIN_HEADER_SIZE)
+  {
+    close(set->fd);
+    return BIN_ERR_FORMAT;
+  }
+  set->size = st.st_size;
+
+  /* Private mapping: byte swapping on big-endian hosts stays local. */
+  map = mmap(NULL, set->size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+	     set->fd, 0);
+  if (map == MAP_FAILED)
+  {
+    close(set->fd);
+    return BIN_ERR_MAP;
+  }
+  set->map = map;
+
+  set->header.columns = load_le(map + 12, 4);
+  set->count = load_le(map + 16, 8);
+  set->header.step = bits_double(load_le(map + 24, 8));
+  set->header.time_bound = bits_double(load_le(map + 32, 8));
+  set->header.seed = load_le(map + 40, 8);
+  set->offset = load_le(map + 48, 8);
+
+  if (memcmp(map, BIN_DATASET_MAGIC, 8) != 0
+      || load_le(map + 8, 4) != BIN_VERSION
+      || set->offset < BIN_HEADER_SIZE || set->offset > set->size
+      || (set->size - set->offset) / 24 < set->count)
+  {
+    bin_dataset_close(set);
+    return BIN_ERR_FORMAT;
+  }
+
+  for (uint64_t k = 0; k < set->count; ++k)
+  {
+    offset = load_le(map + set->offset + 24 * k + 8, 8);
+    rows = load_le(map + set->offset + 24 * k + 16, 8);
+    end = offset + BIN_RECORD_SIZE
+      + (size_t)set->header.columns * rows * sizeof(double);
+    
+    if (offset < BIN_HEADER_SIZE || offset % 8 != 0 || end > set->offset)
+    {
+      bin_dataset_close(set);
+      return BIN_ERR_FORMAT;
+    }
+
+    if (!host_is_little_endian())
+    {
+      swap_words(map + offset + BIN_RECORD_SIZE,
+		 (size_t)set->header.columns * rows);
+    }
+  }
+
+  return 0;
+} /* end of bin_dataset_open function */
+
+
+uint64_t
+bin_dataset_path(const bin_dataset *set, uint64_t entry)
+{
+  /* Number of the path of the entry 'entry' of the index. */
+
+  return load_le(set->map + set->offset + 24 * entry, 8);
+} /* end of bin_dataset_path function */
+
+
+const double *
+bin_dataset_find(const bin_dataset *set, uint64_t path, uint64_t *rows)
+{
+  /*
+   * Returns the columns of the path number 'path' (one after the
+   * other, '*rows' values each) in the mapping, NULL if there is
+   * none. In constant time if path number k is the entry k of the
+   * index, by bisection if paths were appended by increasing number.
+   */
+
+  const unsigned char *entry;
+  uint64_t low = 0, high = set->count, middle;
+
+  if (path < set->count && bin_dataset_path(set, path) == path)
+  {
+    low = path;
+  }
+  else
+  {
+    while (low < high)
+    {
+      middle = low + (high - low) / 2;
+      if (bin_dataset_path(set, middle) < path)
+      {
+	low = middle + 1;
+      }
+      else
+      {
+	high = middle;
+      }
+    }
+  }
+
+  if (low >= set->count || bin_dataset_path(set, low) != path)
+  {
+    return NULL;
+  }
+
+  entry = set->map + set->offset + 24 * low;
+  *rows = load_le(entry + 16, 8);
+
+  return (const double *)(set->map + load_le(entry + 8, 8)
+			  + BIN_RECORD_SIZE);
+} /* end of bin_dataset_find function */
@@ -0,0 +1,150 @@
+/*
+ * Filename: binary_format.h
+ *
+ * Summary: defines a binary columnar format to store the data
+ * produced during the simulation, with a memory-mapped writer and a
+ * zero-copy reader.
+ *
+ * Layout of a file (every number is little-endian):
+ *
+ *   offset  0: magic string "EDSBIN\0\0"     (8 bytes)
+ *   offset  8: version (1)                   (uint32)
+ *   offset 12: number of columns C           (uint32)
+ *   offset 16: number of rows R              (uint64)
+ *   offset 24: time step between two rows    (float64)
+ *   offset 32: time bound T                  (float64)
+ *   offset 40: seed of the generator         (uint64)
+ *   offset 48: path number                   (uint64)
+ *   offset 56: reserved                      (8 bytes)
+ *   offset 64: C columns of R float64 each, one after the other.
+ *
+ * A dataset holds every path of a run in a single file, with the
+ * same header (magic string "EDSSET\0\0"), except that offset 16
+ * holds the number of paths N and offset 48 the offset of the index
+ * (both 0 until the dataset is closed). Then, from offset 64, one
+ * record per path:
+ *
+ *   path number                              (uint64)
+ *   number of rows R                         (uint64)
+ *   C columns of R float64 each, one after the other.
+ *
+ * and the index: N entries (path number, offset of the record,
+ * number of rows), three uint64 each, in the order of the records.
+ * Records are appended by chunks of BIN_CHUNK_SIZE bytes. Until the
+ * dataset is closed, the records written so far are complete and may
+ * be appended to (see bin_dataset_resume).
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#ifndef BINARY_FORMAT_H
+#define BINARY_FORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define BIN_MAGIC "EDSBIN\0\0"
+#define BIN_VERSION 1
+#define BIN_HEADER_SIZE 64
+#define BIN_DATASET_MAGIC "EDSSET\0\0"
+#define BIN_RECORD_SIZE 16
+#define BIN_CHUNK_SIZE (1 << 20)
+
+typedef enum {BIN_ERR_OPEN=-768, BIN_ERR_MAP, BIN_ERR_FORMAT, BIN_ERR_WRITE,
+  BIN_ERR_ALLOC} bin_error_t;
+
+struct bin_header
+{
+  uint32_t columns;
+  uint64_t rows;
+  double step;
+  double time_bound;
+  uint64_t seed;
+  uint64_t path;
+};
+
+struct bin_file
+{
+  /*
+   * A mapped binary file. Columns point directly into the mapping;
+   * do not write in members manually.
+   */
+  
+  struct bin_header header;
+  unsigned char *map;
+  size_t size;
+  int fd;
+  int writable;
+};
+
+struct bin_dataset
+{
+  /*
+   * A dataset being written (see bin_dataset_create) or mapped (see
+   * bin_dataset_open). Only 'columns', 'step', 'time_bound' and
+   * 'seed' of the header are used. Do not write in members manually.
+   */
+
+  struct bin_header header;
+  uint64_t count;         /* number of paths */
+  uint64_t offset;        /* file offset of the chunk, of the index */
+  unsigned char *chunk;   /* writing: records not written yet */
+  size_t used;
+  size_t capacity;
+  uint64_t *index;        /* writing: three words per path */
+  size_t index_capacity;
+  unsigned char *map;     /* reading: the whole file */
+  size_t size;
+  int fd;
+  int writable;
+};
+
+typedef struct bin_header bin_header;
+typedef struct bin_file bin_file;
+typedef struct bin_dataset bin_dataset;
+
+extern int
+bin_create(bin_file *file, const char *filename, const bin_header *header);
+
+extern int
+bin_open(bin_file *file, const char *filename);
+
+extern double *
+bin_column(bin_file *file, unsigned int column);
+
+extern int
+bin_close(bin_file *file);
+
+extern int
+bin_dataset_create(bin_dataset *set, const char *filename,
+		   const bin_header *header);
+
+extern double *
+bin_dataset_append(bin_dataset *set, uint64_t path, uint64_t rows);
+
+extern int
+bin_dataset_sync(bin_dataset *set);
+
+extern int
+bin_dataset_resume(bin_dataset *set, const char *filename,
+		   const bin_header *header, uint64_t count);
+
+extern int
+bin_dataset_close(bin_dataset *set);
+
+extern int
+bin_dataset_open(bin_dataset *set, const char *filename);
+
+extern const double *
+bin_dataset_find(const bin_dataset *set, uint64_t path, uint64_t *rows);
+
+extern uint64_t
+bin_dataset_path(const bin_dataset *set, uint64_t entry);
+
+
+#endif /* BINARY_FORMAT_H */
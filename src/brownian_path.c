@@ -5,7 +5,7 @@
  * a brownian path. Since this construction needs standard normal
  * random variable, we define a function computing a random number
  * following a standardized normal distribution thanks to the
- * Box-Muller transform.
+ * Ziggurat method.
  *
  * Author: bdj <bdosse(at)student.uliege.be>
  *
@@ -18,49 +18,147 @@
 #include <math.h>
 
 #include "brownian_path.h"
-#include "config.h"
+#include "statistics.h"
 
-double
-rand_normal(void)
+/*
+ * Ziggurat with 128 layers, see Marsaglia and Tsang, "The Ziggurat
+ * method for generating random variables" (2000), and Doornik, "An
+ * improved Ziggurat method to generate normal random samples"
+ * (2005). ZIG_R is the start of the tail, ZIG_V the area of a layer.
+ */
+#define ZIG_LAYERS 128
+#define ZIG_R 3.442619855899
+#define ZIG_V 9.91256303526217e-3
+
+static double zig_x[ZIG_LAYERS + 1];
+static double zig_ratio[ZIG_LAYERS];
+static int zig_ready = 0;
+
+
+void
+rand_normal_init(void)
 {
-  /* 
-   * Thanks to https://stackoverflow.com/a/2325531 
-   * 
-   * Random number generator using Box-Muller transform.
+  /*
+   * Compute the Ziggurat tables. Must be called once before any
+   * thread calls rand_normal; it is otherwise called lazily.
    */
 
-  double U, X, Y;
-  double bmt;
+  double f = exp(-0.5 * ZIG_R * ZIG_R);
+
+  zig_x[0] = ZIG_V / f;
+  zig_x[1] = ZIG_R;
+  zig_x[ZIG_LAYERS] = 0.0;
+
+  for (unsigned int i = 2; i < ZIG_LAYERS; ++i)
+  {
+    zig_x[i] = sqrt(-2.0 * log(ZIG_V / zig_x[i - 1] + f));
+    f = exp(-0.5 * zig_x[i] * zig_x[i]);
+  } /* end of for-loop */
+
+  for (unsigned int i = 0; i < ZIG_LAYERS; ++i)
+  {
+    zig_ratio[i] = zig_x[i + 1] / zig_x[i];
+  } /* end of for-loop */
+
+  zig_ready = 1;
+} /* end of rand_normal_init function */
+
+
+static double
+rand_normal_tail(prng_state *rng, int negative)
+{
+  /* Marsaglia's method to sample the tail beyond ZIG_R. */
   
-  X = 0.0;
-  Y = 0.0;
-  U = 0.0;
+  double x, y;
 
-  while (U > 1 || X == 0 || Y == 0) {
-    X = 2.0 * (double)(rand()) / RAND_MAX - 1.0;
-    Y = 2.0 * (double)(rand()) / RAND_MAX - 1.0;
-    U = pow(X, 2) + pow(Y, 2);
-  } /* end while-loop */
+  do {
+    x = log(prng_uniform(rng)) / ZIG_R;
+    y = log(prng_uniform(rng));
+  } while (-2.0 * y < x * x); /* end while-loop */
 
-  bmt = X * sqrt(-2 * log(U) / U);
+  return negative ? x - ZIG_R : ZIG_R - x;
+} /* end of rand_normal_tail function */
 
-  return bmt;
+
+double
+rand_normal(prng_state *rng)
+{
+  /*
+   * Random number generator using the Ziggurat method.
+   *
+   * One 64-bit word gives both the layer (7 lower bits) and the
+   * abscissa (53 upper bits), so that most of the samples cost a
+   * single draw, a multiplication and a comparison.
+   */
+
+  uint64_t word;
+  double u, x, f0, f1;
+  unsigned int i;
+
+  if (!zig_ready) {
+    rand_normal_init();
+  }
+
+  for (;;) {
+    word = prng_next(rng);
+    i = word & (ZIG_LAYERS - 1);
+    u = 2.0 * ((double)(word >> 11) * 0x1.0p-53) - 1.0;
+
+    if (fabs(u) < zig_ratio[i]) {
+      return u * zig_x[i];
+    }
+
+    if (i == 0) {
+      return rand_normal_tail(rng, u < 0);
+    }
+
+    x = u * zig_x[i];
+    f0 = exp(-0.5 * (zig_x[i] * zig_x[i] - x * x));
+    f1 = exp(-0.5 * (zig_x[i + 1] * zig_x[i + 1] - x * x));
+
+    if (f1 + prng_uniform(rng) * (f0 - f1) < 1.0) {
+      return x;
+    }
+  } /* end of for-loop */
 } /* end of rand_normal function */
 
 
 double *
-brownian_path(double max_time, double brownian_prec)
+brownian_path(prng_state *rng, double max_time, double brownian_prec)
 {
   /*
    * The definition of a brownian motion gives a naive way to compute
    * a brownian path. We need numbers following a gaussian
    * distribution.
+   *
+   * The path contains floor(max_time / brownian_prec) + 1 values,
+   * the first one being B(0) = 0.
    */
   
-  double step = 0;
-  double length = max_time / brownian_prec;
+  const unsigned int length = floor(max_time / brownian_prec) + 1;
   double *path = malloc(length * sizeof *path);
 
+  if (path != NULL) {
+    brownian_path_into(rng, max_time, brownian_prec, path);
+  } /* end of if-condition */
+
+  return path;
+  
+} /* end of brownian_path function */
+
+
+double *
+brownian_path_into(prng_state *rng, double max_time, double brownian_prec,
+		   double *path)
+{
+  /*
+   * Same as brownian_path, the values being stored in 'path'.
+   * Returns 'path'.
+   */
+  
+  const unsigned int length = floor(max_time / brownian_prec) + 1;
+  const double scale = sqrt(brownian_prec);
+
   /*
    * Let h > 0, and denote the standard Brownian motion by B; since
    * B(t + h) - B(t) \sim N(0, h), it follows that B(t + h) = B(t) +
@@ -69,19 +167,182 @@ brownian_path(double max_time, double brownian_prec)
    * Implementation : \delta = \sqrt(h) * rand_normal
    */
   
-  if (path != NULL) {
+  path[0] = 0; 
+    
+  for (unsigned int i = 1; i < length; ++i) {
+    path[i] = path[i - 1] + scale * rand_normal(rng);
+  } /* end of for-loop */
+
+  return path;
+  
+} /* end of brownian_path_into function */
+
+
+void
+brownian_bridge_init(brownian_bridge *bridge, const prng_state *rng,
+		     double max_time, double coarse_prec)
+{
+  /*
+   * The bridge draws its random numbers from the stream of 'rng',
+   * which is copied. Since values are addressed by position,
+   * PRNG_PHILOX is much cheaper than PRNG_XOSHIRO here.
+   */
+
+  bridge->rng = *rng;
+  bridge->coarse_prec = coarse_prec;
+  bridge->intervals = floor(max_time / coarse_prec);
+  bridge->qmc = NULL;
+  bridge->strata = 0;
+} /* end of brownian_bridge_init function */
 
-    path[0] = 0; 
+
+void
+brownian_bridge_quasi(brownian_bridge *bridge, const sobol_sequence *qmc,
+		      unsigned int replicate, uint32_t point)
+{
+  /*
+   * Draw the path from the point 'point' of the replicate
+   * 'replicate' of 'qmc' (quasi-Monte Carlo), see brownian_bridge.
+   */
+
+  bridge->qmc = qmc;
+  bridge->replicate = replicate;
+  bridge->point = point;
+} /* end of brownian_bridge_quasi function */
+
+
+void
+brownian_bridge_stratify(brownian_bridge *bridge, unsigned int stratum,
+			 unsigned int strata)
+{
+  /*
+   * Draw the first coarse increment in the stratum 'stratum' (from 0)
+   * of 'strata' equally likely strata of the normal distribution,
+   * see brownian_bridge.
+   */
+
+  bridge->stratum = stratum;
+  bridge->strata = strata;
+} /* end of brownian_bridge_stratify function */
+
+
+static double
+bridge_normal(const brownian_bridge *bridge, unsigned int interval,
+	      uint64_t node)
+{
+  /*
+   * Standard normal number of the node 'node' of the interval:
+   * node 0 is the increment over the coarse interval, the midpoints
+   * of level l (from 1) are the nodes 2^(l-1) to 2^l - 1, left to
+   * right, as in a binary heap. The inverse of the normal cumulative
+   * distribution function keeps one uniform number per node.
+   */
+
+  uint64_t position = node * bridge->intervals + interval;
+
+  if (position == 0 && bridge->strata > 0)
+  {
+    return normal_quantile((bridge->stratum
+			    + prng_uniform_at(&bridge->rng, position))
+			   / bridge->strata);
+  }
+
+  if (bridge->qmc != NULL && position < bridge->qmc->dimension)
+  {
+    return normal_quantile(sobol_uniform(bridge->qmc, bridge->replicate,
+					 bridge->point, position));
+  }
+
+  return normal_quantile(prng_uniform_at(&bridge->rng, position));
+} /* end of bridge_normal function */
+
+
+double
+brownian_bridge_increment(const brownian_bridge *bridge, unsigned int interval)
+{
+  /* Increment of the path over the coarse interval 'interval'. */
+  
+  return sqrt(bridge->coarse_prec) * bridge_normal(bridge, interval, 0);
+} /* end of brownian_bridge_increment function */
+
+
+double *
+brownian_bridge_coarse(const brownian_bridge *bridge, double *path)
+{
+  /*
+   * Store the path at level 0 ('intervals + 1' values, from B(0) =
+   * 0) in 'path'. Returns 'path'.
+   */
+  
+  path[0] = 0;
+  
+  for (unsigned int i = 0; i < bridge->intervals; ++i) {
+    path[i + 1] = path[i] + brownian_bridge_increment(bridge, i);
+  } /* end of for-loop */
+
+  return path;
+} /* end of brownian_bridge_coarse function */
+
+
+double *
+brownian_bridge_segment(const brownian_bridge *bridge, unsigned int interval,
+			unsigned int level, double left, double right,
+			double *segment)
+{
+  /*
+   * Refine the coarse interval number 'interval', whose ends take the
+   * values 'left' and 'right', to the level 'level': the '2^level +
+   * 1' values are stored in 'segment'. Returns 'segment'.
+   *
+   * Knowing B(s) and B(u), B((s + u) / 2) \sim N((B(s) + B(u)) / 2,
+   * (u - s) / 4). Levels are filled one after the other, in place.
+   */
+
+  const unsigned int size = 1U << level;
+  double scale;
+
+  segment[0] = left;
+  segment[size] = right;
+
+  for (unsigned int l = 0; l < level; ++l) {
+    const unsigned int stride = size >> l;
+    const unsigned int nodes = 1U << l;
     
-    for (unsigned int i = 1; i < length; ++i) {
-      step = sqrt(brownian_prec) * rand_normal();
-      path[i] = path[i - 1] + step; 
+    scale = 0.5 * sqrt(ldexp(bridge->coarse_prec, -(int)l));
+    
+    for (unsigned int m = 0; m < nodes; ++m) {
+      double *mid = segment + m * stride + stride / 2;
+      
+      *mid = 0.5 * (mid[-(int)(stride / 2)] + mid[stride / 2]);
+      *mid += scale * bridge_normal(bridge, interval, nodes + m);
     } /* end of for-loop */
+  } /* end of for-loop */
 
-  } /* end of if-condition */
+  return segment;
+} /* end of brownian_bridge_segment function */
 
-  return path;
-  
-} /* end of brownian_path function */
 
+double *
+brownian_bridge_path(const brownian_bridge *bridge, unsigned int level,
+		     double *path)
+{
+  /*
+   * Store the whole path at level 'level' ('intervals * 2^level + 1'
+   * values) in 'path'. The coarse values are computed first, at
+   * their final place, then every interval is refined in place.
+   * Returns 'path'.
+   */
+
+  const unsigned int size = 1U << level;
+  double left = 0, right;
 
+  path[0] = 0;
+  
+  for (unsigned int i = 0; i < bridge->intervals; ++i) {
+    right = left + brownian_bridge_increment(bridge, i);
+    brownian_bridge_segment(bridge, i, level, left, right, path + i * size);
+    left = right;
+  } /* end of for-loop */
+
+  return path;
+} /* end of brownian_bridge_path function */
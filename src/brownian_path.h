@@ -14,12 +14,89 @@
 #ifndef BROWNIAN_PATH_H
 #define BROWNIAN_PATH_H
 
+#include "prng.h"
+#include "sobol.h"
+
+
+typedef enum {BROWNIAN_FORWARD=1, BROWNIAN_BRIDGE} brownian_method;
+
+struct brownian_bridge
+{
+  /*
+   * Levy construction of a Brownian path: the path is sampled every
+   * 'coarse_prec' over 'intervals' coarse intervals, then every
+   * interval may be refined by Brownian bridges to any dyadic level,
+   * level l having the step coarse_prec / 2^l.
+   *
+   * Every value uses a random number attached to its position on the
+   * dyadic grid (see prng_uniform_at), so a path does not depend on
+   * the order of the refinements: refining an interval to level l
+   * gives the values of the path at level l at every refinement.
+   *
+   * If 'qmc' is not NULL (see brownian_bridge_quasi), the random
+   * number of the position p is the coordinate p of the point 'point'
+   * of the replicate 'replicate' of the Sobol' sequence, hence the
+   * first coordinates go to the coarse increments then to the
+   * midpoints, level by level. Positions beyond the dimension of the
+   * sequence use 'rng'.
+   *
+   * If 'strata' > 0 (see brownian_bridge_stratify), the increment
+   * over the first coarse interval, i.e. W(T) if the bridge spans [0,
+   * T], is drawn in the stratum 'stratum' of 'strata' equally likely
+   * strata.
+   */
+  
+  prng_state rng;
+  double coarse_prec;
+  unsigned int intervals;
+  const sobol_sequence *qmc;
+  unsigned int replicate;
+  uint32_t point;
+  unsigned int stratum;
+  unsigned int strata;
+};
+
+typedef struct brownian_bridge brownian_bridge;
+
+extern void
+rand_normal_init(void);
+
+extern double
+rand_normal(prng_state *rng);
+
+extern double *
+brownian_path(prng_state *rng, double max_time, double brownian_prec);
+
+extern double *
+brownian_path_into(prng_state *rng, double max_time, double brownian_prec,
+		   double *path);
+
+extern void
+brownian_bridge_init(brownian_bridge *bridge, const prng_state *rng,
+		     double max_time, double coarse_prec);
+
+extern void
+brownian_bridge_quasi(brownian_bridge *bridge, const sobol_sequence *qmc,
+		      unsigned int replicate, uint32_t point);
+
+extern void
+brownian_bridge_stratify(brownian_bridge *bridge, unsigned int stratum,
+			 unsigned int strata);
 
 extern double
-rand_normal(void);
+brownian_bridge_increment(const brownian_bridge *bridge, unsigned int interval);
+
+extern double *
+brownian_bridge_coarse(const brownian_bridge *bridge, double *path);
+
+extern double *
+brownian_bridge_segment(const brownian_bridge *bridge, unsigned int interval,
+			unsigned int level, double left, double right,
+			double *segment);
 
 extern double *
-brownian_path(unsigned int);
+brownian_bridge_path(const brownian_bridge *bridge, unsigned int level,
+		     double *path);
 
 
 #endif /* BROWNIAN_PATH_H */
@@ -0,0 +1,174 @@
+/*
+ * Filename: checkpoint.c
+ *
+ * Summary: implements the checkpoints of a long simulation.
+ *
+ * A checkpoint is written in a temporary file, flushed to the disk,
+ * then renamed over the previous one: whenever the run stops, the
+ * file holds a whole checkpoint, the last one or the one before.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+
+
+int
+checkpoint_store(const char *filename, const checkpoint *point,
+		 const void *data)
+{
+  /*
+   * Replace the checkpoint 'filename' by 'point', followed by the
+   * 'point->size' bytes of 'data'.
+   *
+   * Returns 0 on success, a negative error code otherwise (the
+   * previous checkpoint is then left untouched).
+   */
+
+  char temporary[4096];
+  const uint32_t version[2] = {CHECKPOINT_VERSION, 0};
+  FILE *output;
+  int status = 0;
+
+  if (snprintf(temporary, sizeof temporary, "%s.tmp", filename)
+      >= (int)sizeof temporary)
+  {
+    return CHECKPOINT_ERR_OPEN;
+  }
+
+  output = fopen(temporary, "wb");
+  if (output == NULL)
+  {
+    return CHECKPOINT_ERR_OPEN;
+  }
+
+  if (fwrite(CHECKPOINT_MAGIC, 8, 1, output) != 1
+      || fwrite(version, sizeof version, 1, output) != 1
+      || fwrite(point, sizeof *point, 1, output) != 1
+      || (point->size > 0 && fwrite(data, point->size, 1, output) != 1)
+      || fflush(output) != 0 || fsync(fileno(output)) == -1)
+  {
+    status = CHECKPOINT_ERR_WRITE;
+  }
+
+  if (fclose(output) != 0 && status == 0)
+  {
+    status = CHECKPOINT_ERR_WRITE;
+  }
+
+  if (status == 0 && rename(temporary, filename) != 0)
+  {
+    status = CHECKPOINT_ERR_WRITE;
+  }
+
+  if (status != 0)
+  {
+    remove(temporary);
+  }
+
+  return status;
+} /* end of checkpoint_store function */
+
+
+int
+checkpoint_load(const char *filename, checkpoint *point, void *data,
+		size_t size)
+{
+  /*
+   * Read the checkpoint 'filename' in 'point', and its partial
+   * results in 'data' if 'size' is not 0.
+   *
+   * Returns 0 on success, CHECKPOINT_ERR_OPEN if there is no such
+   * file, CHECKPOINT_ERR_MISMATCH if the partial results do not have
+   * 'size' bytes, CHECKPOINT_ERR_FORMAT otherwise.
+   */
+
+  FILE *input = fopen(filename, "rb");
+  char magic[8];
+  uint32_t version[2];
+  int status = 0;
+
+  if (input == NULL)
+  {
+    return CHECKPOINT_ERR_OPEN;
+  }
+
+  if (fread(magic, sizeof magic, 1, input) != 1
+      || memcmp(magic, CHECKPOINT_MAGIC, sizeof magic) != 0
+      || fread(version, sizeof version, 1, input) != 1
+      || version[0] != CHECKPOINT_VERSION
+      || fread(point, sizeof *point, 1, input) != 1)
+  {
+    status = CHECKPOINT_ERR_FORMAT;
+  }
+  else if (size > 0 && point->size != size)
+  {
+    status = CHECKPOINT_ERR_MISMATCH;
+  }
+  else if (size > 0 && fread(data, size, 1, input) != 1)
+  {
+    status = CHECKPOINT_ERR_FORMAT;
+  }
+
+  fclose(input);
+
+  return status;
+} /* end of checkpoint_load function */
+
+
+int
+checkpoint_matches(const checkpoint *point, const checkpoint *run)
+{
+  /*
+   * Returns 1 if 'point' is a checkpoint of 'run', i.e. every member
+   * but 'done' is the same, 0 otherwise.
+   */
+
+  return point->seed == run->seed && point->iter == run->iter
+    && point->units == run->units && point->size == run->size
+    && point->observation == run->observation
+    && point->done <= point->units
+    && point->time_bound == run->time_bound
+    && point->step_precision == run->step_precision
+    && point->brownian_precision == run->brownian_precision
+    && point->mode == run->mode && point->scheme == run->scheme
+    && point->output == run->output && point->rows == run->rows
+    && point->rows_step == run->rows_step
+    && point->row_count == run->row_count
+    && point->columns == run->columns
+    && point->replicates == run->replicates
+    && point->shard == run->shard && point->shards == run->shards
+    && point->precision == run->precision
+    && point->antithetic == run->antithetic && point->strata == run->strata
+    && point->control == run->control;
+} /* end of checkpoint_matches function */
+
+
+uint64_t
+checkpoint_hash(const void *data, size_t size)
+{
+  /*
+   * Hash (64-bit FNV-1a) of the 'size' bytes of 'data', for the
+   * parameters of a run too long to be recorded in a checkpoint.
+   */
+
+  const unsigned char *bytes = data;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+
+  for (size_t k = 0; k < size; ++k)
+  {
+    hash = (hash ^ bytes[k]) * 0x100000001b3ULL;
+  }
+
+  return hash;
+} /* end of checkpoint_hash function */
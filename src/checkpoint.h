@@ -0,0 +1,97 @@
+/*
+ * Filename: checkpoint.h
+ *
+ * Summary: defines the checkpoints of a long simulation, from which
+ * an interrupted run is resumed.
+ *
+ * A run is split in units (trajectories, or blocks of them) computed
+ * in consecutive ranges. Once a range is complete and stored, a
+ * checkpoint records how many units are done, with the partial
+ * results which are not stored elsewhere (e.g. the estimators of
+ * STATISTICS). As every trajectory only depends on the seed and its
+ * number (see prng.h), the remaining units give, once resumed, the
+ * results of an uninterrupted run.
+ *
+ * Layout of a file (host byte order, since a checkpoint is resumed
+ * where it was written):
+ *
+ *   magic string "EDSCKPT\0"                 (8 bytes)
+ *   version (5)                              (uint32)
+ *   reserved                                 (uint32)
+ *   struct checkpoint
+ *   'size' bytes of partial results.
+ *
+ * The functions of the SDE are not recorded: a run is resumed by the
+ * same build of the program.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+#define CHECKPOINT_MAGIC "EDSCKPT\0"
+#define CHECKPOINT_VERSION 5
+
+typedef enum {CHECKPOINT_ERR_OPEN=-2816, CHECKPOINT_ERR_WRITE,
+  CHECKPOINT_ERR_FORMAT, CHECKPOINT_ERR_MISMATCH} checkpoint_error_t;
+
+struct checkpoint
+{
+  /*
+   * Progress of a run and the parameters its results depend on: a
+   * checkpoint only resumes a run with the same ones (see
+   * checkpoint_matches). Fill every member, 0 if unused.
+   */
+
+  uint64_t seed;
+  uint64_t iter;
+  uint64_t units;           /* units of the run */
+  uint64_t done;            /* units before 'done' are complete */
+  uint64_t size;            /* bytes of partial results */
+  uint64_t observation;     /* hash of the observation times, see ROWS */
+  double time_bound;
+  double step_precision;
+  double brownian_precision;
+  uint32_t mode;            /* what the units are, set by the caller */
+  uint32_t scheme;
+  uint32_t output;
+  uint32_t rows;
+  uint32_t row_count;
+  uint32_t columns;
+  uint32_t rows_step;
+  uint32_t replicates;
+  uint32_t shard;           /* shard 'shard' of 'shards' (see --shard) */
+  uint32_t shards;
+  uint32_t precision;       /* see precision_kind */
+  uint32_t antithetic;      /* variance reduction, see STATISTICS */
+  uint32_t strata;
+  uint32_t control;
+};
+
+typedef struct checkpoint checkpoint;
+
+extern int
+checkpoint_store(const char *filename, const checkpoint *point,
+		 const void *data);
+
+extern int
+checkpoint_load(const char *filename, checkpoint *point, void *data,
+		size_t size);
+
+extern int
+checkpoint_matches(const checkpoint *point, const checkpoint *run);
+
+extern uint64_t
+checkpoint_hash(const void *data, size_t size);
+
+
+#endif /* CHECKPOINT_H */
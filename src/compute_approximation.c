@@ -4,8 +4,9 @@
  * Summary: compute an approximation of an Ito process.
  *
  * The approximation is calculated thanks to the Euler-Maruyama
- * process. Configuration is done through the config.h file, following
- * an idea from the suckless.org community.
+ * process, or to a higher order scheme (see SCHEME). Configuration
+ * is done through the config.h file, following an idea from the
+ * suckless.org community.
  *
  * To configure this program, take a look at the config.h file.
  *
@@ -18,108 +19,3123 @@
  * License: see LICENSE file.
  */
 
+#include <stdarg.h>
+#include <string.h>
 #include <sys/stat.h>
 
+#include "arena.h"
+#include "checkpoint.h"
 #include "config.h"
+#include "metrics.h"
+#include "mlmc.h"
+#include "monte_carlo.h"
+#include "options.h"
+#include "statistics.h"
 
-#ifdef USE_TIME
 #include <time.h>
-#else
+
 #ifndef PRNG_SEED
 #define PRNG_SEED 37
 #endif
+
+#ifndef FILEPATH
+#define FILEPATH "./data"
+#endif
+
+#ifndef FLOAT_PREC
+#define FLOAT_PREC 10
+#endif
+
+#ifndef ITER
+#define ITER 1
+#endif
+
+#ifndef STEP_PRECISION
+#define STEP_PRECISION pow(2, -7)
+#endif
+
+#ifndef TIME_BOUND
+#define TIME_BOUND 1.0
+#endif
+
+#ifndef THREADS
+#define THREADS 0
+#endif
+
+#ifndef WRITERS
+#define WRITERS 0
+#endif
+
+#ifndef OUTPUT_QUEUE
+#define OUTPUT_QUEUE 4
+#endif
+
+#ifndef CHECKPOINT
+#define CHECKPOINT 0
+#endif
+
+#ifndef CONFIDENCE
+#define CONFIDENCE 0.95
+#endif
+
+#ifndef QMC_REPLICATES
+#define QMC_REPLICATES 0
+#endif
+
+#define STAT_BLOCKS 256
+
+/* Output filenames: the output directory, then a file name. */
+#define OUTPUT_NAME_SIZE (OPT_MAX_PATH + 32)
+
+#ifndef ROWS_STEP
+#define ROWS_STEP 1
+#endif
+
+/* Columns of a row: time, approximation (and reference). */
+#ifdef COMPARE
+#define PATH_COLUMNS 3
+#else
+#define PATH_COLUMNS 2
+#endif
+/* Columns of a summary (see ROWS): time, then 4 per other column. */
+#define SUMMARY_COLUMNS (1 + 4 * (PATH_COLUMNS - 1))
+
+/* Estimators at time T with STATISTICS, see struct stat_blocks. */
+#ifdef COMPARE
+#define QUANTITIES 4
+#else
+#define QUANTITIES 1
+#endif
+
+#ifndef BROWNIAN_PRECISION
+#define BROWNIAN_PRECISION STEP_PRECISION
+#endif
+
+#ifndef DIMENSION
+#define DIMENSION 1
+#endif
+
+#ifndef FACTORS
+#define FACTORS 1
+#endif
+
+#ifndef VECTOR_BATCH
+#define VECTOR_BATCH 16
+#endif
+
+#ifndef ADAPTIVE_TOLERANCE
+#define ADAPTIVE_TOLERANCE 1e-4
+#endif
+
+#ifndef INSTRUMENT_TRACE
+#define INSTRUMENT_TRACE 0
+#endif
+
+#ifndef STRATA
+#define STRATA 0
+#endif
+
+
+/* The model of config.h, inlined in every scheme (see SCHEME). */
+EULER_MARUYAMA_STEP(euler_maruyama_step, deterministic_term,
+		    stochastic_term)
+MILSTEIN_STEP(milstein_step, deterministic_term, stochastic_term,
+	      stochastic_term_derivative)
+RUNGE_KUTTA_STEP(runge_kutta_step, deterministic_term, stochastic_term)
+ADAPTIVE_STEP(adaptive_step, milstein_step, ADAPTIVE_TOLERANCE)
+
+SCHEME_KERNEL(euler_maruyama_model, euler_maruyama_step)
+SCHEME_KERNEL(milstein_model, milstein_step)
+SCHEME_KERNEL(runge_kutta_model, runge_kutta_step)
+SCHEME_KERNEL(adaptive_model, adaptive_step)
+
+static const scheme_kernel scheme_kernels[] = {
+  [SCHEME_EULER] = &euler_maruyama_model,
+  [SCHEME_MILSTEIN] = &milstein_model,
+  [SCHEME_RUNGE_KUTTA] = &runge_kutta_model,
+  [SCHEME_ADAPTIVE] = &adaptive_model};
+
+static const scheme_step scheme_steps[] = {
+  [SCHEME_EULER] = &euler_maruyama_step,
+  [SCHEME_MILSTEIN] = &milstein_step,
+  [SCHEME_RUNGE_KUTTA] = &runge_kutta_step,
+  [SCHEME_ADAPTIVE] = &adaptive_step};
+
+/* The same steps in single precision (see PRECISION). */
+EULER_MARUYAMA_STEP_OF(euler_maruyama_single, float, deterministic_term_f,
+		       stochastic_term_f)
+MILSTEIN_STEP_OF(milstein_single, float, deterministic_term_f,
+		 stochastic_term_f, stochastic_term_derivative_f)
+RUNGE_KUTTA_STEP_OF(runge_kutta_single, float, deterministic_term_f,
+		    stochastic_term_f)
+ADAPTIVE_STEP_OF(adaptive_single, float, milstein_single, ADAPTIVE_TOLERANCE)
+
+
+struct simulation
+{
+  /*
+   * Parameters shared (read-only) by every worker. Without COMPARE,
+   * the Brownian motion has the precision of the approximation,
+   * unless the scheme is adaptive. The k-th row stored is the row
+   * row_index[k] of the trajectory (k if row_index is NULL), and
+   * row_order sorts them along the trajectory. With
+   * variance reduction, the estimators of f(X_T) follow the first
+   * 'functional' quantities (see struct stat_blocks), 0 otherwise.
+   * If 'fused', paths are computed a step at a time and only their
+   * stored rows are kept (see fused_rows).
+   */
+  
+  const char *filepath;
+  uint64_t seed;
+  unsigned int iter;
+  unsigned int steps;
+  unsigned int float_prec;
+  double time_bound;
+  double step_precision;
+  double brownian_precision;
+  unsigned int factor;
+  unsigned int truncation;
+  scheme_kind scheme;
+  precision_kind precision;
+  double bridge_step;
+  unsigned int level;
+  const sobol_sequence *qmc;
+  unsigned int replicates;
+  int antithetic;
+  unsigned int strata;
+  unsigned int functional;
+  unsigned int block_size;
+  unsigned int profile_size;
+  struct estimators *blocks;
+  unsigned int sweep_size;
+  const double *sweep_steps;
+  const vector_sde *vector;
+  bin_dataset *dataset;
+  row_policy rows;
+  const unsigned int *row_index;
+  const unsigned int *row_order;
+  unsigned int row_count;
+  int fused;
+  reference_plan reference;
+};
+
+struct trajectory
+{
+  /*
+   * Arrays computed for a single path. They are slices of the arena
+   * of the worker and are overwritten by the next path.
+   */
+  
+  double *brownian_motion;
+  double *path;
+  #ifdef COMPARE
+  double *reference;
+  double *interpolation;
+  #endif
+  float *segment; /* Brownian motion over a step, see PRECISION */
+  double *stored; /* stored rows of a fused path, see fused_rows */
+  double *terms;
+};
+
+struct worker
+{
+  /*
+   * Scratch data owned by a single thread. The arena is sized once,
+   * from the largest number of steps, and reused by every path.
+   * Counters are only updated if INSTRUMENT is defined.
+   */
+  
+  const struct simulation *sim;
+  csv_writer *writer;
+  arena scratch;
+  struct trajectory traj;
+  metrics metrics;
+};
+
+struct output_slot
+{
+  /*
+   * A trajectory waiting for a writer thread (see WRITERS): its
+   * formatted text in CSV, its stored columns otherwise (see
+   * binary_columns). Slots are reused from a trajectory to the next.
+   */
+
+  arena scratch;
+  double *columns;
+  csv_buffer text;
+};
+
+typedef void (*fused_emit)(void *arg, unsigned int j, double approximation,
+			   double reference);
+
+struct estimators
+{
+  /*
+   * Accumulators filled by a block of consecutive paths. Blocks do
+   * not depend on the number of threads and are merged in order,
+   * hence the summary is bit-identical whatever the number of
+   * threads.
+   */
+  
+  accumulator approximation;
+  #ifdef COMPARE
+  accumulator reference;
+  accumulator strong_error;
+  accumulator weak_error;
+  #endif
+  #ifdef STATISTICS
+  accumulator reduced[STAT_REDUCED];
+  #endif
+  accumulator *profile;
+};
+
+/* Units of a run, between two checkpoints (see CHECKPOINT). */
+typedef enum {UNIT_PATH=1, UNIT_BATCH, UNIT_BLOCK} unit_kind;
+
+struct progress
+{
+  /*
+   * Checkpoints and shard of a run: 'point' describes the run, of
+   * which this process computes the units 'first' to 'last' - 1 (all
+   * of them, unless sharded), those before point.done being
+   * complete. A checkpoint is stored in 'filename' every 'every'
+   * units, never if 0.
+   */
+
+  char filename[OPT_MAX_PATH + 16];
+  checkpoint point;
+  unsigned int first;
+  unsigned int last;
+  unsigned int every;
+};
+
+
+static int
+init_worker(struct worker *worker, const struct simulation *sim,
+	    unsigned int capacity)
+{
+  /*
+   * Allocate the CSV writer and the arena of a worker, every array
+   * of the trajectory holding up to 'capacity' values (steps of a
+   * batch of VECTOR_BATCH paths for systems, see DIMENSION). Fused
+   * paths also need their stored rows.
+   */
+
+  #ifdef COMPARE
+  const size_t arrays = 4;
+  #else
+  const size_t arrays = 2;
+  #endif
+  struct trajectory *traj = &worker->traj;
+  const size_t terms = sim->vector != NULL
+    ? vector_scratch_size(sim->vector, VECTOR_BATCH)
+    + VECTOR_BATCH * DIMENSION : 0;
+  const size_t stored = !sim->fused ? 0 : (size_t)sim->row_count
+    * (sim->rows == ROWS_SUMMARY ? SUMMARY_COLUMNS : PATH_COLUMNS);
+  size_t size = arrays * arena_size_of_doubles(capacity)
+    + arena_size_of_doubles(terms) + arena_size_of_doubles(stored);
+  int traced = 0;
+
+  #ifdef STATISTICS
+  size += arena_size_of_doubles(capacity / 2 + 1);
+  #endif
+
+  if (sim->vector != NULL)
+  {
+    size = arena_size_of_doubles((size_t)capacity * VECTOR_BATCH * FACTORS)
+      + arena_size_of_doubles((size_t)capacity * VECTOR_BATCH * DIMENSION)
+      + (arrays - 2) * arena_size_of_doubles((size_t)capacity * DIMENSION)
+      + arena_size_of_doubles(terms);
+  }
+
+  worker->sim = sim;
+  worker->writer = init_csv_writer(FORMAT, sim->float_prec);
+  #ifdef INSTRUMENT
+  traced = metrics_init(&worker->metrics, INSTRUMENT_TRACE);
+  #endif
+  if (arena_init(&worker->scratch, size) != 0)
+  {
+    return CANNOT_ALLOCATE_SDS;
+  }
+
+  if (sim->vector != NULL)
+  {
+    traj->brownian_motion = arena_doubles(&worker->scratch, (size_t)capacity
+					  * VECTOR_BATCH * FACTORS);
+    traj->path = arena_doubles(&worker->scratch, (size_t)capacity
+			       * VECTOR_BATCH * DIMENSION);
+    capacity *= DIMENSION;
+  }
+  else
+  {
+    traj->brownian_motion = arena_doubles(&worker->scratch, capacity);
+    traj->path = arena_doubles(&worker->scratch, capacity);
+  }
+  #ifdef COMPARE
+  traj->reference = arena_doubles(&worker->scratch, capacity);
+  traj->interpolation = arena_doubles(&worker->scratch, capacity);
+  #endif
+  #ifdef STATISTICS
+  traj->segment = arena_alloc(&worker->scratch, capacity * sizeof(float));
+  #else
+  traj->segment = NULL;
+  #endif
+  traj->stored = arena_doubles(&worker->scratch, stored);
+  traj->terms = arena_doubles(&worker->scratch, terms);
+
+  /* The CSV writer and its buffer, the arena. */
+  METRIC_ADD(&worker->metrics, allocations, 3);
+  METRIC_ADD(&worker->metrics, scratch, worker->scratch.used);
+
+  return worker->writer == NULL || traced != 0 ? CANNOT_ALLOCATE_SDS
+    : SUCCESS;
+} /* end of init_worker function */
+
+
+#ifdef COMPARE
+static double *
+reference_process(const struct simulation *sim,
+		  const double *brownian_motion, double *path)
+{
+  /*
+   * Store the reference solution (see REFERENCE) on the grid of the
+   * Brownian motion in 'path' (floor(time_bound / brownian_precision)
+   * + 1 values). Returns 'path'.
+   */
+
+  const double brownian_prec = sim->brownian_precision;
+  const unsigned int steps = floor(sim->time_bound / brownian_prec) + 1;
+  const double init = initial_condition();
+  double state[REFERENCE_STATE];
+
+  if (REFERENCE == REFERENCE_LINEAR)
+  {
+    return reference_linear_batch(&sim->reference, steps - 1, 1, &init,
+				  brownian_motion, path);
+  }
+
+  reference_start(state);
+  path[0] = reference_value(state, 0);
+  
+  for (unsigned int j = 1; j < steps; ++j)
+  {
+    reference_update(state, (j - 1) * brownian_prec,
+		     brownian_motion[j] - brownian_motion[j - 1]);
+    path[j] = reference_value(state, j * brownian_prec);
+  }
+
+  return path;
+} /* end of reference_process function */
 #endif
 
-#ifndef FILEPATH
-#define FILEPATH "./data"
-#endif
 
-#ifndef FLOAT_PREC
-#define FLOAT_PREC 10
-#endif
+static int
+dyadic_level(double max_time, double coarse, double fine)
+{
+  /*
+   * Returns l such that the grid of step 'fine' over [0, max_time] is
+   * the grid of step 'coarse' refined l times (see BROWNIAN), -1 if
+   * there is none.
+   */
+
+  const unsigned long long coarse_steps = floor(max_time / coarse);
+  const unsigned long long fine_steps = floor(max_time / fine);
+
+  for (int l = 0; l < 32; ++l)
+  {
+    if (coarse_steps << l == fine_steps && ldexp(fine, l) == coarse)
+    {
+      return l;
+    }
+  }
+
+  return -1;
+} /* end of dyadic_level function */
+
+
+static void
+sample_brownian(const struct simulation *sim, prng_state *rng,
+		unsigned int i, double *brownian_motion)
+{
+  /*
+   * Brownian motion of the path i at the Brownian precision, see
+   * BROWNIAN, QMC_REPLICATES and STRATA.
+   */
+
+  brownian_bridge bridge;
+
+  if (sim->qmc != NULL)
+  {
+    brownian_bridge_init(&bridge, rng, sim->time_bound, sim->bridge_step);
+    brownian_bridge_quasi(&bridge, sim->qmc, i % sim->replicates,
+			  i / sim->replicates);
+    brownian_bridge_path(&bridge, sim->level, brownian_motion);
+  }
+  else if (sim->strata > 0)
+  {
+    brownian_bridge_init(&bridge, rng, sim->time_bound, sim->bridge_step);
+    brownian_bridge_stratify(&bridge, i % sim->strata, sim->strata);
+    brownian_bridge_path(&bridge, sim->level, brownian_motion);
+  }
+  else if (BROWNIAN == BROWNIAN_BRIDGE)
+  {
+    brownian_bridge_init(&bridge, rng, sim->time_bound, sim->bridge_step);
+    brownian_bridge_path(&bridge, sim->level, brownian_motion);
+  }
+  else
+  {
+    brownian_path_into(rng, sim->time_bound, sim->brownian_precision,
+		       brownian_motion);
+  }
+} /* end of sample_brownian function */
+
+
+static inline double
+model_step(scheme_kind scheme, double time, double d_time, double pos,
+	   const double *brownian_motion, unsigned int factor)
+{
+  /* A step of the scheme, inlined (see scheme_step). */
+  
+  switch (scheme)
+  {
+  case SCHEME_MILSTEIN:
+    return milstein_step(time, d_time, pos, brownian_motion, factor);
+  case SCHEME_RUNGE_KUTTA:
+    return runge_kutta_step(time, d_time, pos, brownian_motion, factor);
+  case SCHEME_ADAPTIVE:
+    return adaptive_step(time, d_time, pos, brownian_motion, factor);
+  default:
+    return euler_maruyama_step(time, d_time, pos, brownian_motion, factor);
+  }
+} /* end of model_step function */
+
+
+static inline float
+model_step_single(scheme_kind scheme, double time, float d_time, float pos,
+		  const float *brownian_motion, unsigned int factor)
+{
+  /* Same as model_step, in single precision (see PRECISION). */
+  
+  switch (scheme)
+  {
+  case SCHEME_MILSTEIN:
+    return milstein_single(time, d_time, pos, brownian_motion, factor);
+  case SCHEME_RUNGE_KUTTA:
+    return runge_kutta_single(time, d_time, pos, brownian_motion, factor);
+  case SCHEME_ADAPTIVE:
+    return adaptive_single(time, d_time, pos, brownian_motion, factor);
+  default:
+    return euler_maruyama_single(time, d_time, pos, brownian_motion,
+				 factor);
+  }
+} /* end of model_step_single function */
+
+
+static void
+simulate_fused(const struct simulation *sim, unsigned int i,
+	       const struct trajectory *traj, double *between,
+	       fused_emit emit, void *arg)
+{
+  /*
+   * Compute the trajectory number i in a single pass: every Brownian
+   * increment is drawn once and fed to the reference process and to
+   * the approximation, then forgotten. At every step j of the
+   * approximation, emit(arg, j, X_j, Y_j) receives the approximation
+   * and the reference (0 without COMPARE). If COMPARE is defined and
+   * 'between' is not NULL, it then holds the reference at the
+   * 'factor' points of the Brownian motion in ]t_{j - 1}, t_j].
+   *
+   * Values are bit-identical to simulate_path (in double precision).
+   * Memory does not grow with the number of steps: the Brownian
+   * motion over one step is stored in traj->brownian_motion ('factor
+   * + 1' values), refined by Brownian bridges with BROWNIAN_BRIDGE,
+   * and rounded in traj->segment for PRECISION_SINGLE. Not for
+   * quasi-Monte Carlo nor strata, whose bridge spans [0, T].
+   *
+   * With ANTITHETIC, the path 2k + 1 is driven by the opposite of the
+   * Brownian motion of the path 2k.
+   */
+
+  const int single = sim->precision == PRECISION_SINGLE;
+  const double sign = sim->antithetic && (i & 1) ? -1.0 : 1.0;
+  double *segment = traj->brownian_motion;
+  const double h = sim->step_precision;
+  const double scale = sqrt(sim->brownian_precision);
+  double x = single ? (float)initial_condition() : initial_condition();
+  float x_single = x;
+  double brownian = 0, next;
+  double reference = 0;
+  brownian_bridge bridge;
+  prng_state rng;
+  #ifdef COMPARE
+  double state[REFERENCE_STATE];
+  
+  reference_start(state);
+  reference = REFERENCE == REFERENCE_LINEAR ? initial_condition()
+    : reference_value(state, 0);
+  #endif
+
+  prng_init(&rng, GENERATOR, sim->seed, sim->antithetic ? i & ~1U : i);
+  if (BROWNIAN == BROWNIAN_BRIDGE)
+  {
+    brownian_bridge_init(&bridge, &rng, sim->time_bound, sim->bridge_step);
+  }
+  emit(arg, 0, x, reference);
+  
+  for (unsigned int j = 1; j < sim->truncation; ++j)
+  {
+    if (BROWNIAN == BROWNIAN_BRIDGE)
+    {
+      brownian_bridge_segment(&bridge, j - 1, sim->level, sign * brownian,
+			      sign * brownian
+			      + brownian_bridge_increment(&bridge, j - 1),
+			      segment);
+    }
+    
+    segment[0] = brownian;
+    if (single)
+    {
+      traj->segment[0] = brownian;
+    }
+    for (unsigned int k = 1; k <= sim->factor; ++k)
+    {
+      next = BROWNIAN == BROWNIAN_BRIDGE ? sign * segment[k]
+	: brownian + sign * scale * rand_normal(&rng);
+      #ifdef COMPARE
+      if (REFERENCE == REFERENCE_LINEAR)
+      {
+	reference = reference_linear_step(&sim->reference, reference,
+					  next - brownian);
+      }
+      else
+      {
+	reference_update(state, ((j - 1) * sim->factor + k - 1)
+			 * sim->brownian_precision, next - brownian);
+      }
+      if (between != NULL && k < sim->factor)
+      {
+	between[k - 1] = REFERENCE == REFERENCE_LINEAR ? reference
+	  : reference_value(state, ((j - 1) * sim->factor + k)
+			    * sim->brownian_precision);
+      }
+      #endif
+      segment[k] = next;
+      if (single)
+      {
+	traj->segment[k] = next;
+      }
+      brownian = next;
+    }
+
+    if (single)
+    {
+      x_single = model_step_single(sim->scheme, j * h, h, x_single,
+				   traj->segment, sim->factor);
+      x = x_single;
+    }
+    else
+    {
+      x = model_step(sim->scheme, j * h, h, x, segment, sim->factor);
+    }
+    
+    #ifdef COMPARE
+    if (REFERENCE != REFERENCE_LINEAR)
+    {
+      reference = reference_value(state, j * sim->factor
+				  * sim->brownian_precision);
+    }
+    if (between != NULL)
+    {
+      between[sim->factor - 1] = reference;
+    }
+    #else
+    dummy_array(between);
+    #endif
+    emit(arg, j, x, reference);
+  }
+} /* end of simulate_fused function */
+
+
+static void
+simulate_path(const struct simulation *sim, unsigned int i,
+	      struct trajectory *traj, metrics *metrics)
+{
+  /*
+   * Compute the trajectory number i in the arrays of 'traj'. The
+   * trajectory only depends on i, through the i-th stream of the
+   * generator.
+   */
+
+  prng_state rng;
+
+  METRIC_STAGE(metrics, METRIC_RNG,
+	       prng_init(&rng, GENERATOR, sim->seed, i);
+	       sample_brownian(sim, &rng, i, traj->brownian_motion));
+  METRIC_STAGE(metrics, METRIC_SCHEME,
+	       scheme_kernels[sim->scheme](sim->time_bound,
+					   sim->step_precision,
+					   initial_condition(),
+					   traj->brownian_motion,
+					   sim->factor, traj->path));
+  #ifdef COMPARE
+  METRIC_STAGE(metrics, METRIC_REFERENCE,
+	       reference_process(sim, traj->brownian_motion,
+				 traj->reference));
+  #endif
+} /* end of simulate_path function */
+
+
+static state
+output_name(char *filename, const char *directory, const char *format, ...)
+{
+  /*
+   * Store 'directory/format' (formatted as by printf) in 'filename',
+   * of OUTPUT_NAME_SIZE bytes. Returns IO_ERROR if it is truncated.
+   */
+
+  va_list args;
+  int length, written;
+
+  length = snprintf(filename, OUTPUT_NAME_SIZE, "%s/", directory);
+  if (length < 0 || length >= OUTPUT_NAME_SIZE)
+  {
+    return IO_ERROR;
+  }
+
+  va_start(args, format);
+  written = vsnprintf(filename + length, OUTPUT_NAME_SIZE - length, format,
+		      args);
+  va_end(args);
+
+  return written < 0 || written >= OUTPUT_NAME_SIZE - length ? IO_ERROR
+    : SUCCESS;
+} /* end of output_name function */
+
+
+static state
+driver_state(int status)
+{
+  /*
+   * State of a run of the Monte Carlo driver: its own errors (see
+   * monte_carlo.h) are allocation failures, the others are the states
+   * returned by the trajectories.
+   */
+
+  switch (status)
+  {
+  case MC_ERR_ALLOC:
+  case MC_ERR_THREAD:
+  case MC_ERR_VALUE:
+    return CANNOT_ALLOCATE_SDS;
+  default:
+    return status;
+  }
+} /* end of driver_state function */
+
+
+#ifndef STATISTICS
+#ifdef INSTRUMENT
+static uint64_t
+binary_size(const struct simulation *sim, unsigned int dimension)
+{
+  /* Size of the binary file of a path, see write_binary. */
+
+  #ifdef COMPARE
+  unsigned int columns = 1 + 2 * dimension;
+  #else
+  unsigned int columns = 1 + dimension;
+  #endif
+
+  if (sim->rows == ROWS_SUMMARY)
+  {
+    columns = 1 + 4 * (columns - 1);
+  }
+  
+  return BIN_HEADER_SIZE + (uint64_t)sim->row_count * columns
+    * sizeof(double);
+} /* end of binary_size function */
+#endif
+
+
+static unsigned int
+output_columns(const struct simulation *sim)
+{
+  /* Number of columns of a stored row, see ROWS. */
+  
+  return sim->rows == ROWS_SUMMARY ? SUMMARY_COLUMNS : PATH_COLUMNS;
+} /* end of output_columns function */
+
+
+static inline unsigned int
+stored_row(const struct simulation *sim, unsigned int k)
+{
+  /* Row of the trajectory stored k-th, see ROWS. */
+  
+  return sim->row_index != NULL ? sim->row_index[k] : k;
+} /* end of stored_row function */
+
+
+static void
+grid_row(const struct simulation *sim, const struct trajectory *traj,
+	 const double *interpolation, unsigned int j, double *row)
+{
+  /*
+   * Row j of the trajectory: the time, the approximation and the
+   * reference if COMPARE is defined. Without 'interpolation' (see
+   * compute_trajectory), the approximation is interpolated here, as
+   * by linear_interpolation (held after the last step).
+   */
+
+  #ifdef COMPARE
+  const unsigned int step = j / sim->factor, k = j % sim->factor;
+  double increment;
+
+  row[0] = j * sim->brownian_precision;
+  if (interpolation != NULL)
+  {
+    row[1] = interpolation[j];
+  }
+  else
+  {
+    row[1] = traj->path[step];
+    if (k > 0 && step + 1 < sim->truncation)
+    {
+      increment = traj->path[step + 1] - traj->path[step];
+      row[1] += (double)k / (double)sim->factor * increment;
+    }
+  }
+  row[2] = traj->reference[j];
+  #else
+  dummy_array((double *)interpolation);
+  row[0] = j * sim->step_precision;
+  row[1] = traj->path[j];
+  #endif
+} /* end of grid_row function */
+
+
+static inline unsigned int
+grid_rows(const struct simulation *sim)
+{
+  /* Number of rows of the trajectory, see ROWS. */
+
+  #ifdef COMPARE
+  return sim->steps;
+  #else
+  return sim->truncation;
+  #endif
+} /* end of grid_rows function */
+
+
+static void
+summary_push(const struct simulation *sim, unsigned int j,
+	     const double *value, double *row)
+{
+  /*
+   * Add the row j of the trajectory ('value') to its summary 'row':
+   * last value, minimum, maximum and mean of every column, see ROWS.
+   */
+
+  const unsigned int rows = grid_rows(sim);
+  double *summary;
+
+  for (unsigned int c = 1; c < PATH_COLUMNS; ++c)
+  {
+    summary = row + 1 + 4 * (c - 1);
+    if (j == 0)
+    {
+      summary[1] = summary[2] = value[c];
+      summary[3] = 0;
+    }
+    summary[0] = value[c];
+    summary[1] = value[c] < summary[1] ? value[c] : summary[1];
+    summary[2] = value[c] > summary[2] ? value[c] : summary[2];
+    summary[3] += value[c];
+  }
+
+  if (j == rows - 1)
+  {
+    row[0] = value[0];
+    for (unsigned int c = 1; c < PATH_COLUMNS; ++c)
+    {
+      row[4 * c] /= rows;
+    }
+  }
+} /* end of summary_push function */
+
+
+static void
+output_row(const struct simulation *sim, const struct trajectory *traj,
+	   const double *interpolation, unsigned int k, double *row)
+{
+  /*
+   * Row stored k-th (output_columns(sim) values, see ROWS): a row of
+   * the trajectory, or the summary of all of them. Fused paths have
+   * kept it already (see fused_rows).
+   */
+
+  double value[PATH_COLUMNS] = {0};
+
+  if (sim->fused)
+  {
+    for (unsigned int c = 0; c < output_columns(sim); ++c)
+    {
+      row[c] = traj->stored[c * sim->row_count + k];
+    }
+  }
+  else if (sim->rows != ROWS_SUMMARY)
+  {
+    grid_row(sim, traj, interpolation, stored_row(sim, k), row);
+  }
+  else
+  {
+    for (unsigned int j = 0; j < grid_rows(sim); ++j)
+    {
+      grid_row(sim, traj, interpolation, j, value);
+      summary_push(sim, j, value, row);
+    }
+  }
+} /* end of output_row function */
+
+
+struct row_target
+{
+  /*
+   * Rows of a fused path kept by keep_row: the stored rows, column
+   * after column (see binary_columns), in 'stored'. The stored rows
+   * order[0], order[1]... come in this order along the path, 'next'
+   * being the first one not kept yet. With COMPARE, 'previous' is the
+   * approximation at the previous step and 'between' the reference
+   * since then (see simulate_fused).
+   */
+
+  const struct simulation *sim;
+  double *stored;
+  const unsigned int *order;
+  unsigned int next;
+  double previous;
+  double *between;
+};
+
+
+static void
+keep_row(struct row_target *target, unsigned int j, const double *value)
+{
+  /* Keep the row j of the path ('value') if it is stored, see ROWS. */
+  
+  const struct simulation *sim = target->sim;
+  unsigned int k;
+
+  if (sim->rows == ROWS_SUMMARY)
+  {
+    summary_push(sim, j, value, target->stored);
+    return;
+  }
+  
+  while (target->next < sim->row_count
+	 && sim->row_index[target->order[target->next]] == j)
+  {
+    k = target->order[target->next++];
+    for (unsigned int c = 0; c < PATH_COLUMNS; ++c)
+    {
+      target->stored[c * sim->row_count + k] = value[c];
+    }
+  }
+} /* end of keep_row function */
+
+
+static void
+fused_rows(void *arg, unsigned int j, double approximation,
+	   double reference)
+{
+  /*
+   * Emitter of simulate_fused keeping the stored rows (see ROWS)
+   * of a path, as grid_row would compute them: with COMPARE, the
+   * rows on the grid of the Brownian motion in ]t_{j - 1}, t_j],
+   * the approximation being interpolated.
+   */
+  
+  struct row_target *target = arg;
+  const struct simulation *sim = target->sim;
+  double value[PATH_COLUMNS];
+  #ifdef COMPARE
+  const double increment = approximation - target->previous;
+  unsigned int row;
+
+  if (j == 0)
+  {
+    value[0] = 0;
+    value[1] = approximation;
+    value[2] = reference;
+    keep_row(target, 0, value);
+  }
+  
+  for (unsigned int k = 1; j > 0 && k <= sim->factor; ++k)
+  {
+    row = (j - 1) * sim->factor + k;
+    value[0] = row * sim->brownian_precision;
+    value[1] = k < sim->factor ? target->previous
+      + (double)k / (double)sim->factor * increment : approximation;
+    value[2] = target->between[k - 1];
+    keep_row(target, row, value);
+  }
+  target->previous = approximation;
+  #else
+  dummy(reference);
+  value[0] = j * sim->step_precision;
+  value[1] = approximation;
+  keep_row(target, j, value);
+  #endif
+} /* end of fused_rows function */
+
+
+static state
+write_csv_rows(const struct simulation *sim, csv_writer *writer,
+	       const struct trajectory *traj, const double *interpolation)
+{
+  /*
+   * Write the stored rows of the trajectory (see ROWS) through
+   * 'writer' (see csv_begin and csv_begin_buffer), then end it.
+   */
+
+  state status = SUCCESS;
+  const unsigned int columns = output_columns(sim);
+  double row[SUMMARY_COLUMNS];
+
+  for (unsigned int k = 0; k < sim->row_count; ++k)
+  {
+    output_row(sim, traj, interpolation, k, row);
+    if (csv_write_row(writer, row, columns) != 0)
+    {
+      status = IO_ERROR;
+    }
+  }
+
+  if (csv_end(writer) != 0)
+  {
+    status = IO_ERROR;
+  }
+  
+  return status;
+} /* end of write_csv_rows function */
+
+
+static state
+write_csv(const struct simulation *sim, csv_writer *writer,
+	  const char *filename, const struct trajectory *traj,
+	  const double *interpolation)
+{
+  /* Store the trajectory in a CSV file. */
+
+  FILE *output = fopen(filename, "w");
+  state status;
+
+  if (output == NULL)
+  {
+    return IO_ERROR;
+  }
+
+  csv_begin(writer, output);
+  status = write_csv_rows(sim, writer, traj, interpolation);
+  fclose(output);
+  
+  return status;
+} /* end of write_csv function */
+
+
+static void
+binary_header(const struct simulation *sim, unsigned int i,
+	      bin_header *header)
+{
+  /* Header of the binary file of the trajectory number i. */
+  
+  header->time_bound = sim->time_bound;
+  header->seed = sim->seed;
+  header->path = i;
+  header->rows = sim->row_count;
+  header->columns = output_columns(sim);
+  #ifdef COMPARE
+  header->step = sim->brownian_precision;
+  #else
+  header->step = sim->step_precision;
+  #endif
+} /* end of binary_header function */
+
+
+static void
+binary_columns(const struct simulation *sim, const bin_header *header,
+	       const struct trajectory *traj, const double *interpolation,
+	       double *columns)
+{
+  /*
+   * Store the columns of the stored rows, one after the other, in
+   * 'columns' (see output_row). Every row: time, then approximation
+   * (and reference if COMPARE is defined), copied at once.
+   */
+
+  double row[SUMMARY_COLUMNS];
+
+  if (sim->rows != ROWS_ALL)
+  {
+    for (unsigned int k = 0; k < header->rows; ++k)
+    {
+      output_row(sim, traj, interpolation, k, row);
+      for (unsigned int c = 0; c < header->columns; ++c)
+      {
+	columns[c * header->rows + k] = row[c];
+      }
+    }
+    return;
+  }
+  
+  for (unsigned int j = 0; j < header->rows; ++j)
+  {
+    columns[j] = j * header->step;
+  }
+  #ifdef COMPARE
+  memcpy(columns + header->rows, interpolation,
+	 header->rows * sizeof *interpolation);
+  memcpy(columns + 2 * header->rows, traj->reference,
+	 header->rows * sizeof *traj->reference);
+  #else
+  dummy_array((double *)interpolation);
+  memcpy(columns + header->rows, traj->path,
+	 header->rows * sizeof *traj->path);
+  #endif
+} /* end of binary_columns function */
+
+
+static state
+write_binary(const struct simulation *sim, unsigned int i,
+	     const char *filename, const struct trajectory *traj,
+	     const double *interpolation)
+{
+  /* Store the trajectory in a binary columnar file, see OUTPUT. */
+  
+  bin_file output;
+  bin_header header;
+
+  binary_header(sim, i, &header);
+  if (bin_create(&output, filename, &header) != 0)
+  {
+    return IO_ERROR;
+  }
+
+  binary_columns(sim, &header, traj, interpolation, bin_column(&output, 0));
+
+  return bin_close(&output) == 0 ? SUCCESS : IO_ERROR;
+} /* end of write_binary function */
+
+
+static state
+write_columns(const struct simulation *sim, unsigned int i,
+	      const char *filename, const double *columns)
+{
+  /* Same as write_binary, 'columns' coming from binary_columns. */
+  
+  bin_file output;
+  bin_header header;
+
+  binary_header(sim, i, &header);
+  if (bin_create(&output, filename, &header) != 0)
+  {
+    return IO_ERROR;
+  }
+
+  memcpy(bin_column(&output, 0), columns,
+	 header.rows * header.columns * sizeof *columns);
+
+  return bin_close(&output) == 0 ? SUCCESS : IO_ERROR;
+} /* end of write_columns function */
+
+
+static state
+write_record(const struct simulation *sim, unsigned int i,
+	     const double *columns)
+{
+  /*
+   * Append the trajectory number i, stored by binary_columns in
+   * 'columns', to the dataset (see OUTPUT). Trajectories must come in
+   * order (from a single writer thread).
+   */
+  
+  bin_header header;
+  double *record;
+
+  binary_header(sim, i, &header);
+  record = bin_dataset_append(sim->dataset, i, header.rows);
+  if (record == NULL)
+  {
+    return IO_ERROR;
+  }
+
+  memcpy(record, columns, header.rows * header.columns * sizeof *columns);
+
+  return SUCCESS;
+} /* end of write_record function */
+
+
+static double *
+compute_trajectory(struct worker *worker, unsigned int i,
+		   struct trajectory *traj)
+{
+  /*
+   * Compute the trajectory number i in the arrays of 'traj'. Returns
+   * the approximation interpolated at the Brownian precision if
+   * COMPARE is defined and every row is stored (see ROWS), NULL
+   * otherwise: stored rows are then interpolated by grid_row, or
+   * kept by fused_rows.
+   */
+  
+  const struct simulation *sim = worker->sim;
+  double *interpolation = NULL;
+  struct row_target target = {sim, traj->stored, sim->row_order, 0, 0,
+    NULL};
+
+  METRIC_PATH(&worker->metrics, i);
+  METRIC_ADD(&worker->metrics, paths, 1);
+  if (sim->fused)
+  {
+    #ifdef COMPARE
+    target.between = traj->reference;
+    #endif
+    METRIC_STAGE(&worker->metrics, METRIC_FUSED,
+		 simulate_fused(sim, i, traj, target.between, &fused_rows,
+				&target));
+    return NULL;
+  }
+  
+  simulate_path(sim, i, traj, &worker->metrics);
+  #ifdef COMPARE
+  if (sim->rows == ROWS_ALL)
+  {
+    METRIC_STAGE(&worker->metrics, METRIC_INTERPOLATION,
+		 interpolation = linear_interpolation_into(traj->path,
+							   sim->truncation,
+							   sim->factor,
+							   traj->interpolation));
+  }
+  #endif
+
+  return interpolation;
+} /* end of compute_trajectory function */
+
+
+static void
+report_path(const struct simulation *sim, unsigned int i,
+	    const char *filename, state status)
+{
+  #ifndef SILENT
+  if (status == SUCCESS)
+  {
+    printf("Success: Computation %d/%d terminated.\n", i + 1, sim->iter);
+    printf("         Results stored in '%s'\n", filename);
+  }
+  else
+  {
+    printf("Fatal:   Unable to print data in file (I/O error).\n");
+  }
+  #else
+  (void)sim;
+  (void)i;
+  (void)filename;
+  (void)status;
+  #endif
+} /* end of report_path function */
+
+
+static int
+compute_path(void *arg, unsigned int i)
+{
+  /*
+   * Compute the trajectory number i and store it in its own file.
+   */
+  
+  struct worker *worker = arg;
+  const struct simulation *sim = worker->sim;
+  const struct trajectory *traj = &worker->traj;
+  state status;
+  char filename[OUTPUT_NAME_SIZE];
+  double *interpolation;
+
+  interpolation = compute_trajectory(worker, i, &worker->traj);
+    
+  /* Now printing in file */
+  status = output_name(filename, sim->filepath, "data_%u.%s", i + 1,
+		       OUTPUT == BINARY ? "bin" : "csv");
+  if (status == SUCCESS && OUTPUT == BINARY)
+  {
+    METRIC_STAGE(&worker->metrics, METRIC_OUTPUT,
+		 status = write_binary(sim, i, filename, traj,
+				       interpolation));
+    METRIC_ADD(&worker->metrics, bytes, binary_size(sim, 1));
+  }
+  else if (status == SUCCESS)
+  {
+    METRIC_STAGE(&worker->metrics, METRIC_OUTPUT,
+		 status = write_csv(sim, worker->writer, filename, traj,
+				    interpolation));
+  }
+  METRIC_ADD(&worker->metrics, files, 1);
+  report_path(sim, i, filename, status);
+
+  return status;
+} /* end of compute_path function */
+
+
+static int
+init_slot(struct output_slot *slot, unsigned int capacity)
+{
+  /*
+   * Allocate the columns of a slot, 'capacity' values (not in CSV:
+   * the text grows with its first files).
+   */
+
+  memset(slot, 0, sizeof *slot);
+  if (OUTPUT == CSV)
+  {
+    return SUCCESS;
+  }
+  
+  if (arena_init(&slot->scratch, arena_size_of_doubles(capacity)) != 0)
+  {
+    return CANNOT_ALLOCATE_SDS;
+  }
+  slot->columns = arena_doubles(&slot->scratch, capacity);
+
+  return SUCCESS;
+} /* end of init_slot function */
+
+
+static int
+fill_slot(void *arg, void *slot_arg, unsigned int i)
+{
+  /*
+   * Compute the trajectory number i for the writer threads (see
+   * WRITERS): formatted in its text in CSV, its stored rows in its
+   * columns otherwise.
+   */
+  
+  struct worker *worker = arg;
+  const struct simulation *sim = worker->sim;
+  struct output_slot *slot = slot_arg;
+  bin_header header;
+  double *interpolation;
+  state status = SUCCESS;
+
+  interpolation = compute_trajectory(worker, i, &worker->traj);
+
+  if (OUTPUT == CSV)
+  {
+    csv_begin_buffer(worker->writer, &slot->text);
+    METRIC_STAGE(&worker->metrics, METRIC_OUTPUT,
+		 status = write_csv_rows(sim, worker->writer, &worker->traj,
+					 interpolation));
+  }
+  else
+  {
+    binary_header(sim, i, &header);
+    METRIC_STAGE(&worker->metrics, METRIC_OUTPUT,
+		 binary_columns(sim, &header, &worker->traj, interpolation,
+				slot->columns));
+  }
+
+  return status;
+} /* end of fill_slot function */
+
+
+static state
+write_text(const char *filename, const csv_buffer *text)
+{
+  /* Store a formatted CSV file. */
+
+  FILE *output = fopen(filename, "w");
+  state status = SUCCESS;
+
+  if (output == NULL)
+  {
+    return IO_ERROR;
+  }
+
+  if (fwrite(text->data, 1, text->size, output) != text->size)
+  {
+    status = IO_ERROR;
+  }
+  if (fclose(output) != 0)
+  {
+    status = IO_ERROR;
+  }
+
+  return status;
+} /* end of write_text function */
+
+
+static int
+write_slot(void *arg, void *slot_arg, unsigned int i)
+{
+  /*
+   * Store the trajectory number i, computed by fill_slot, in its own
+   * file or in the dataset. Called by a writer thread, in the order
+   * of trajectories.
+   */
+  
+  struct worker *writer = arg;
+  const struct simulation *sim = writer->sim;
+  struct output_slot *slot = slot_arg;
+  state status;
+  char filename[OUTPUT_NAME_SIZE];
+
+  METRIC_PATH(&writer->metrics, i);
+  status = output_name(filename, sim->filepath, OUTPUT == DATASET
+		       ? "dataset.bin" : "data_%u.%s", i + 1,
+		       OUTPUT == BINARY ? "bin" : "csv");
+  if (status == SUCCESS && OUTPUT == BINARY)
+  {
+    METRIC_STAGE(&writer->metrics, METRIC_WRITE,
+		 status = write_columns(sim, i, filename, slot->columns));
+    METRIC_ADD(&writer->metrics, bytes, binary_size(sim, 1));
+    METRIC_ADD(&writer->metrics, files, 1);
+  }
+  else if (status == SUCCESS && OUTPUT == DATASET)
+  {
+    METRIC_STAGE(&writer->metrics, METRIC_WRITE,
+		 status = write_record(sim, i, slot->columns));
+    METRIC_ADD(&writer->metrics, bytes,
+	       binary_size(sim, 1) - BIN_HEADER_SIZE + BIN_RECORD_SIZE);
+    METRIC_ADD(&writer->metrics, files, i == 0);
+  }
+  else if (status == SUCCESS)
+  {
+    METRIC_STAGE(&writer->metrics, METRIC_WRITE,
+		 status = write_text(filename, &slot->text));
+    METRIC_ADD(&writer->metrics, files, 1);
+  }
+  report_path(sim, i, filename, status);
+
+  return status;
+} /* end of write_slot function */
+
+
+static void
+vector_row(const struct simulation *sim, const struct trajectory *traj,
+	   unsigned int paths, unsigned int p, unsigned int j, double *row)
+{
+  /*
+   * Row j of the file of the path p of a batch (see DIMENSION): the
+   * time, the d values of the approximation, linearly interpolated
+   * at the Brownian precision as by linear_interpolation (held after
+   * the last step), and the d values of the reference process if
+   * COMPARE is defined.
+   */
+
+  const vector_sde *sde = sim->vector;
+  const size_t states = (size_t)paths * DIMENSION;
+  #ifdef COMPARE
+  const unsigned int step = j / sim->factor, k = j % sim->factor;
+  const double *cur = traj->path + step * states;
+  double increment;
+
+  row[0] = j * sim->brownian_precision;
+  for (unsigned int c = 0; c < DIMENSION; ++c)
+  {
+    const size_t at = vector_index(sde, paths, DIMENSION, p, c);
+
+    row[1 + c] = cur[at];
+    if (k > 0 && step + 1 < sim->truncation)
+    {
+      increment = cur[states + at] - cur[at];
+      row[1 + c] += (double)k / (double)sim->factor * increment;
+    }
+    row[1 + DIMENSION + c] = traj->reference[(size_t)j * DIMENSION + c];
+  }
+  #else
+  row[0] = j * sim->step_precision;
+  for (unsigned int c = 0; c < DIMENSION; ++c)
+  {
+    row[1 + c] = traj->path[j * states
+			    + vector_index(sde, paths, DIMENSION, p, c)];
+  }
+  #endif
+} /* end of vector_row function */
+
+
+static state
+write_vector(const struct simulation *sim, csv_writer *writer,
+	     unsigned int i, const char *filename,
+	     const struct trajectory *traj, unsigned int paths,
+	     unsigned int p)
+{
+  /*
+   * Store the path p of a batch, number i, in a CSV or binary file
+   * (see OUTPUT), one column per component. Only the stored rows are
+   * computed, see ROWS.
+   */
+
+  const unsigned int rows = sim->row_count;
+  #ifdef COMPARE
+  double row[1 + 2 * DIMENSION];
+  #else
+  double row[1 + DIMENSION];
+  #endif
+  const unsigned int columns = sizeof row / sizeof *row;
+  FILE *output;
+  bin_file binary;
+  bin_header header;
+  state status = SUCCESS;
+
+  if (OUTPUT == BINARY)
+  {
+    header.rows = rows;
+    header.columns = columns;
+    header.time_bound = sim->time_bound;
+    header.seed = sim->seed;
+    header.path = i;
+    #ifdef COMPARE
+    header.step = sim->brownian_precision;
+    #else
+    header.step = sim->step_precision;
+    #endif
+    
+    if (bin_create(&binary, filename, &header) != 0)
+    {
+      return IO_ERROR;
+    }
+
+    for (unsigned int k = 0; k < rows; ++k)
+    {
+      vector_row(sim, traj, paths, p, stored_row(sim, k), row);
+      for (unsigned int c = 0; c < columns; ++c)
+      {
+	bin_column(&binary, c)[k] = row[c];
+      }
+    }
+
+    return bin_close(&binary) == 0 ? SUCCESS : IO_ERROR;
+  }
+
+  output = fopen(filename, "w");
+  if (output == NULL)
+  {
+    return IO_ERROR;
+  }
+
+  csv_begin(writer, output);
+  for (unsigned int k = 0; k < rows; ++k)
+  {
+    vector_row(sim, traj, paths, p, stored_row(sim, k), row);
+    if (csv_write_row(writer, row, columns) != 0)
+    {
+      status = IO_ERROR;
+    }
+  }
+
+  if (csv_end(writer) != 0)
+  {
+    status = IO_ERROR;
+  }
+  fclose(output);
+  
+  return status;
+} /* end of write_vector function */
+
+
+#ifdef COMPARE
+static void
+reference_vector_path(const struct simulation *sim, struct trajectory *traj,
+		      unsigned int paths, unsigned int p)
+{
+  /*
+   * Store the reference process of the path p of a batch in
+   * 'traj->reference', at the Brownian precision (see
+   * REFERENCE_VECTOR_STATE).
+   */
+
+  const vector_sde *sde = sim->vector;
+  const size_t noises = (size_t)paths * FACTORS;
+  double d_brownian[FACTORS];
+  double reference[REFERENCE_VECTOR_STATE];
+
+  reference_vector_start(reference);
+  reference_vector_value(reference, 0, traj->reference);
+  for (unsigned int j = 1; j < sim->steps; ++j)
+  {
+    for (unsigned int f = 0; f < FACTORS; ++f)
+    {
+      const size_t at = vector_index(sde, paths, FACTORS, p, f);
+      
+      d_brownian[f] = traj->brownian_motion[j * noises + at]
+	- traj->brownian_motion[(j - 1) * noises + at];
+    }
+    reference_vector_update(reference, (j - 1) * sim->brownian_precision,
+			    d_brownian);
+    reference_vector_value(reference, j * sim->brownian_precision,
+			   traj->reference + (size_t)j * DIMENSION);
+  }
+} /* end of reference_vector_path function */
+#endif
+
+
+static int
+compute_vector_block(void *arg, unsigned int b)
+{
+  /*
+   * Compute the paths of the batch b of a system (see DIMENSION) in
+   * lockstep, then store each of them in its own file. Path i only
+   * depends on i, through the i-th stream of the generator.
+   */
+  
+  struct worker *worker = arg;
+  const struct simulation *sim = worker->sim;
+  const vector_sde *sde = sim->vector;
+  struct trajectory *traj = &worker->traj;
+  const unsigned int first = b * VECTOR_BATCH;
+  const unsigned int paths = sim->iter - first < VECTOR_BATCH
+    ? sim->iter - first : VECTOR_BATCH;
+  double *init = traj->terms;
+  double value[DIMENSION];
+  prng_state rng;
+  char filename[OUTPUT_NAME_SIZE];
+  state status = SUCCESS;
+
+  METRIC_ADD(&worker->metrics, paths, paths);
+  for (unsigned int p = 0; p < paths; ++p)
+  {
+    METRIC_PATH(&worker->metrics, first + p);
+    METRIC_STAGE(&worker->metrics, METRIC_RNG,
+		 prng_init(&rng, GENERATOR, sim->seed, first + p);
+		 vector_brownian_into(sde, &rng, sim->time_bound,
+				      sim->brownian_precision, paths, p,
+				      traj->brownian_motion));
+    initial_vector(value);
+    for (unsigned int c = 0; c < DIMENSION; ++c)
+    {
+      init[vector_index(sde, paths, DIMENSION, p, c)] = value[c];
+    }
+  }
+  
+  METRIC_PATH(&worker->metrics, first);
+  METRIC_STAGE(&worker->metrics, METRIC_SCHEME,
+	       vector_euler_maruyama_into(sde, sim->time_bound,
+					  sim->step_precision, paths, init,
+					  traj->brownian_motion, sim->factor,
+					  traj->path,
+					  init + (size_t)paths * DIMENSION));
+
+  for (unsigned int p = 0; p < paths && status == SUCCESS; ++p)
+  {
+    METRIC_PATH(&worker->metrics, first + p);
+    #ifdef COMPARE
+    METRIC_STAGE(&worker->metrics, METRIC_REFERENCE,
+		 reference_vector_path(sim, traj, paths, p));
+    #endif
+
+    status = output_name(filename, sim->filepath, "data_%u.%s",
+			 first + p + 1, OUTPUT == BINARY ? "bin" : "csv");
+    if (status == SUCCESS)
+    {
+      METRIC_STAGE(&worker->metrics, METRIC_OUTPUT,
+		   status = write_vector(sim, worker->writer, first + p,
+					 filename, traj, paths, p));
+    }
+    METRIC_ADD(&worker->metrics, files, 1);
+    METRIC_ADD(&worker->metrics, bytes, OUTPUT == BINARY
+	       ? binary_size(sim, DIMENSION) : 0);
+    
+    #ifndef SILENT
+    if (status == SUCCESS)
+    {
+      printf("Success: Computation %d/%d terminated.\n", first + p + 1,
+	     sim->iter);
+      printf("         Results stored in '%s'\n", filename);
+    }
+    else
+    {
+      printf("Fatal:   Unable to print data in file (I/O error).\n");
+    }
+    #endif
+  }
+
+  return status;
+} /* end of compute_vector_block function */
+#endif
+
+
+static unsigned int
+next_checkpoint(const struct progress *progress, unsigned int first)
+{
+  /* The end of the range of units starting at 'first'. */
+
+  const unsigned int last = progress->last;
+
+  if (progress->every == 0 || last - first <= progress->every)
+  {
+    return last;
+  }
+
+  return first + progress->every;
+} /* end of next_checkpoint function */
+
+
+static state
+store_checkpoint(struct progress *progress, unsigned int done,
+		 const void *data)
+{
+  /* Record that the units before 'done' are complete. */
+
+  progress->point.done = done;
+  if (checkpoint_store(progress->filename, &progress->point, data) != 0)
+  {
+    #ifndef SILENT
+    printf("Fatal:   Cannot store checkpoint %s.\n", progress->filename);
+    #endif
+    return IO_ERROR;
+  }
+
+  return SUCCESS;
+} /* end of store_checkpoint function */
+
+
+#ifndef STATISTICS
+static state
+run_paths(const struct simulation *sim, struct progress *progress,
+	  unsigned int threads, unsigned int writers, void **worker_ptrs,
+	  void **slot_ptrs, unsigned int slot_count)
+{
+  /*
+   * Compute and store the trajectories which are not done yet, by
+   * ranges of 'progress->every' units (trajectories, batches of
+   * VECTOR_BATCH ones for systems), and store a checkpoint once the
+   * files of a range are complete.
+   */
+
+  unsigned int last;
+  state status = SUCCESS;
+
+  for (unsigned int first = progress->point.done;
+       first < progress->last && status == SUCCESS; first = last)
+  {
+    last = next_checkpoint(progress, first);
+    if (sim->vector != NULL)
+    {
+      status = driver_state(mc_run_range(first, last, threads,
+					 &compute_vector_block, worker_ptrs));
+    }
+    else if (writers > 0)
+    {
+      status = driver_state(mc_run_pipeline(first, last, threads,
+					    &fill_slot, worker_ptrs, writers,
+					    &write_slot, worker_ptrs + threads,
+					    slot_ptrs, slot_count));
+    }
+    else
+    {
+      status = driver_state(mc_run_range(first, last, threads,
+					 &compute_path, worker_ptrs));
+    }
+
+    if (status != SUCCESS || last == progress->last)
+    {
+      continue;
+    }
+
+    if (sim->dataset != NULL && bin_dataset_sync(sim->dataset) != 0)
+    {
+      status = IO_ERROR;
+    }
+    else
+    {
+      status = store_checkpoint(progress, last, NULL);
+    }
+  } /* end of for-loop */
+
+  return status;
+} /* end of run_paths function */
+#endif
+
+
+#ifdef STATISTICS
+struct block_target
+{
+  /*
+   * Where simulate_fused pushes the values of the path 'path', and
+   * f(X_T) and Z of the first path of an antithetic pair.
+   */
+  
+  const struct simulation *sim;
+  struct estimators *est;
+  unsigned int path;
+  double pending[2];
+};
+
+
+static void
+push_functional(struct block_target *target, double approximation,
+		double reference)
+{
+  /*
+   * Push f(X_T) of a path, then the sample of its pair (antithetic)
+   * or of the path, in the estimators of variance reduction (see
+   * struct stat_blocks). Z is 0 without CONTROL_VARIATE.
+   */
+
+  struct estimators *est = target->est;
+  double value = mlmc_functional(approximation);
+  double control = 0;
+
+  #ifdef CONTROL_VARIATE
+  control = control_variate(reference);
+  #else
+  dummy(reference);
+  #endif
+  acc_push(&est->reduced[0], value);
+
+  if (target->sim->antithetic && (target->path & 1) == 0)
+  {
+    target->pending[0] = value;
+    target->pending[1] = control;
+    return;
+  }
+  else if (target->sim->antithetic)
+  {
+    value = 0.5 * (target->pending[0] + value);
+    control = 0.5 * (target->pending[1] + control);
+  }
+
+  acc_push(&est->reduced[1], value);
+  acc_push(&est->reduced[2], control);
+  acc_push(&est->reduced[3], value + control);
+} /* end of push_functional function */
+
+
+static void
+push_estimators(void *arg, unsigned int j, double approximation,
+		double reference)
+{
+  /* Push the step j of a path in the estimators of its block. */
+  
+  struct block_target *target = arg;
+  struct estimators *est = target->est;
+
+  #ifdef COMPARE
+  acc_push(&est->profile[j], fabs(approximation - reference));
+  #else
+  dummy(reference);
+  acc_push(&est->profile[j], approximation);
+  #endif
+
+  if (j == target->sim->profile_size - 1)
+  {
+    acc_push(&est->approximation, approximation);
+    #ifdef COMPARE
+    acc_push(&est->reference, reference);
+    acc_push(&est->strong_error, fabs(approximation - reference));
+    acc_push(&est->weak_error, approximation - reference);
+    #endif
+    if (target->sim->functional > 0)
+    {
+      push_functional(target, approximation, reference);
+    }
+  }
+} /* end of push_estimators function */
+
+
+static int
+compute_block(void *arg, unsigned int b)
+{
+  /*
+   * Compute the trajectories of block b and push them, in order, in
+   * the estimators of the block. Nothing is written on disk.
+   *
+   * With quasi-Monte Carlo, block b is the replicate b, i.e. the
+   * trajectories b, b + QMC_REPLICATES, ..., and likewise the stratum
+   * b with STRATA.
+   */
+
+  struct worker *worker = arg;
+  const struct simulation *sim = worker->sim;
+  struct estimators *est = &sim->blocks[b];
+  const unsigned int stride = sim->qmc != NULL ? sim->replicates
+    : sim->strata > 0 ? sim->strata : 1;
+  const unsigned int first = stride > 1 ? b : b * sim->block_size;
+  unsigned int last = stride > 1 ? sim->iter : first + sim->block_size;
+  const struct trajectory *traj = &worker->traj;
+  struct block_target target = {sim, est, 0, {0, 0}};
+  double value;
+
+  if (last > sim->iter)
+  {
+    last = sim->iter;
+  }
+
+  for (unsigned int i = first; i < last; i += stride)
+  {
+    METRIC_PATH(&worker->metrics, i);
+    METRIC_ADD(&worker->metrics, paths, 1);
+    target.path = i;
+    if (sim->qmc == NULL && sim->strata == 0)
+    {
+      METRIC_STAGE(&worker->metrics, METRIC_FUSED,
+		   simulate_fused(sim, i, &worker->traj, NULL,
+				  &push_estimators, &target));
+      continue;
+    }
+    
+    simulate_path(sim, i, &worker->traj, &worker->metrics);
+
+    for (unsigned int j = 0; j < sim->profile_size; ++j)
+    {
+      #ifdef COMPARE
+      value = fabs(traj->path[j] - traj->reference[sim->factor * j]);
+      #else
+      value = traj->path[j];
+      #endif
+      acc_push(&est->profile[j], value);
+    }
+
+    value = traj->path[sim->profile_size - 1];
+    acc_push(&est->approximation, value);
+    #ifdef COMPARE
+    double exact = traj->reference[sim->factor * (sim->truncation - 1)];
+    acc_push(&est->reference, exact);
+    acc_push(&est->strong_error, fabs(value - exact));
+    acc_push(&est->weak_error, value - exact);
+    #else
+    double exact = 0;
+    #endif
+    if (sim->functional > 0)
+    {
+      push_functional(&target, value, exact);
+    }
+  }
+
+  return SUCCESS;
+} /* end of compute_block function */
+
+
+static state
+write_summary(const struct simulation *sim, const stat_blocks *set,
+	      const accumulator *total)
+{
+  /*
+   * Store the estimators in 'summary.csv' and the time profile in
+   * 'profile.csv' (see stat_write_csv), then print them at time T,
+   * with the gain in effective sample size of variance reduction.
+   */
+
+  if (stat_write_csv(sim->filepath, set, total) != 0)
+  {
+    return IO_ERROR;
+  }
+
+  #ifndef SILENT
+  #ifdef COMPARE
+  printf("Strong error at T:      %.*f +/- %.*f\n",
+	 (int)sim->float_prec, total[2].mean, (int)sim->float_prec,
+	 acc_half_width(&total[2], CONFIDENCE));
+  printf("Weak error at T:        %.*f +/- %.*f\n",
+	 (int)sim->float_prec, total[3].mean, (int)sim->float_prec,
+	 acc_half_width(&total[3], CONFIDENCE));
+  #else
+  printf("Mean at T:              %.*f +/- %.*f\n",
+	 (int)sim->float_prec, total[0].mean, (int)sim->float_prec,
+	 acc_half_width(&total[0], CONFIDENCE));
+  #endif
+  if (set->functional > 0)
+  {
+    accumulator reduced;
+    double gain;
+
+    stat_reduce(set, total, &reduced);
+    gain = stat_ess_gain(&total[set->functional], &reduced);
+    printf("E[f(X_T)], reduced:     %.*f +/- %.*f\n",
+	   (int)sim->float_prec, reduced.mean, (int)sim->float_prec,
+	   acc_half_width(&reduced, CONFIDENCE));
+    if (isinf(gain))
+    {
+      printf("Effective sample size:  exact estimator\n");
+    }
+    else
+    {
+      printf("Effective sample size:  %.4g times the number of paths\n",
+	     gain);
+    }
+  }
+  printf("Success: Summary stored in '%s/summary.csv'\n", sim->filepath);
+  #endif
+
+  return SUCCESS;
+} /* end of write_summary function */
+
+
+static unsigned int
+statistics_blocks(struct simulation *sim)
+{
+  /*
+   * Split the trajectories in at most STAT_BLOCKS blocks (one per
+   * replicate with quasi-Monte Carlo, per stratum with STRATA), of
+   * whole antithetic pairs. Returns the number of blocks.
+   */
+
+  const unsigned int blocks = sim->qmc != NULL ? sim->replicates
+    : sim->strata > 0 ? sim->strata
+    : sim->iter < STAT_BLOCKS ? sim->iter : STAT_BLOCKS;
+
+  sim->block_size = (sim->iter + blocks - 1) / blocks;
+  sim->block_size += sim->antithetic ? sim->block_size & 1 : 0;
+  #ifdef COMPARE
+  sim->profile_size = sim->truncation;
+  #else
+  sim->profile_size = sim->steps;
+  #endif
+
+  return sim->qmc != NULL || sim->strata > 0 ? blocks
+    : (sim->iter + sim->block_size - 1) / sim->block_size;
+} /* end of statistics_blocks function */
+
+
+static void
+pack_estimators(const struct simulation *sim, stat_blocks *set, int unpack)
+{
+  /*
+   * Copy the estimators of every block in 'set' (from 'set' if
+   * 'unpack'), for checkpoints and shards.
+   */
+
+  const size_t profile = (size_t)sim->profile_size * sizeof(accumulator);
+  accumulator *data = set->data;
+  accumulator *fixed[STAT_QUANTITIES + STAT_REDUCED];
+  unsigned int count;
+
+  for (unsigned int b = 0; b < set->blocks; ++b)
+  {
+    count = 0;
+    fixed[count++] = &sim->blocks[b].approximation;
+    #ifdef COMPARE
+    fixed[count++] = &sim->blocks[b].reference;
+    fixed[count++] = &sim->blocks[b].strong_error;
+    fixed[count++] = &sim->blocks[b].weak_error;
+    #endif
+    for (unsigned int k = 0; sim->functional > 0 && k < STAT_REDUCED; ++k)
+    {
+      fixed[count++] = &sim->blocks[b].reduced[k];
+    }
+
+    for (unsigned int k = 0; k < count; ++k, ++data)
+    {
+      if (unpack)
+      {
+	*fixed[k] = *data;
+      }
+      else
+      {
+	*data = *fixed[k];
+      }
+    }
+
+    if (unpack)
+    {
+      memcpy(sim->blocks[b].profile, data, profile);
+    }
+    else
+    {
+      memcpy(data, sim->blocks[b].profile, profile);
+    }
+    data += sim->profile_size;
+  }
+} /* end of pack_estimators function */
+
+
+static state
+run_statistics(struct simulation *sim, struct progress *progress,
+	       unsigned int threads, void **worker_ptrs)
+{
+  /*
+   * Compute the blocks of trajectories (see statistics_blocks) of
+   * the shard which are not done yet, and merge the estimators of
+   * its blocks, in order. Checkpoints hold the estimators of every
+   * block; a shard of a run stores its blocks in 'estimators.bin',
+   * merged with those of the other shards by merge_shards.
+   */
+
+  const unsigned int blocks = statistics_blocks(sim);
+  struct estimators *est = calloc(blocks, sizeof *est);
+  accumulator *profiles = calloc((size_t)blocks * sim->profile_size,
+				 sizeof *profiles);
+  stat_blocks set = {0};
+  accumulator *total = NULL;
+  char filename[sizeof progress->filename];
+  unsigned int last;
+  state status = SUCCESS;
+
+  set.seed = sim->seed;
+  set.iter = sim->iter;
+  set.step = sim->step_precision;
+  set.confidence = CONFIDENCE;
+  set.quantities = QUANTITIES + (sim->functional > 0 ? STAT_REDUCED : 0);
+  set.profile_size = sim->profile_size;
+  set.blocks = blocks;
+  set.first = progress->first;
+  set.last = progress->last;
+  set.replicates = sim->qmc != NULL ? sim->replicates : 0;
+  set.float_prec = sim->float_prec;
+  set.precision = sim->precision;
+  set.functional = sim->functional;
+  set.antithetic = sim->antithetic;
+  set.strata = sim->strata;
+  #ifdef CONTROL_VARIATE
+  set.control = 1;
+  set.control_mean = control_mean((sim->truncation - 1)
+				  * sim->step_precision);
+  #endif
+  if (stat_blocks_init(&set) == 0)
+  {
+    total = malloc(stat_block_size(&set) * sizeof *total);
+  }
+
+  if (est == NULL || profiles == NULL || total == NULL)
+  {
+    free(est);
+    free(profiles);
+    free(total);
+    stat_blocks_free(&set);
+    return CANNOT_ALLOCATE_SDS;
+  }
+
+  /* Zeroed accumulators are empty accumulators (see acc_init). */
+  for (unsigned int b = 0; b < blocks; ++b)
+  {
+    est[b].profile = profiles + (size_t)b * sim->profile_size;
+  }
+  sim->blocks = est;
+
+  if (progress->point.done > progress->first)
+  {
+    if (checkpoint_load(progress->filename, &progress->point, set.data,
+			progress->point.size) == 0)
+    {
+      pack_estimators(sim, &set, 1);
+    }
+    else
+    {
+      #ifndef SILENT
+      printf("Fatal:   Cannot read checkpoint %s.\n", progress->filename);
+      #endif
+      status = IO_ERROR;
+    }
+  }
+
+  for (unsigned int first = progress->point.done;
+       first < progress->last && status == SUCCESS; first = last)
+  {
+    last = next_checkpoint(progress, first);
+    status = driver_state(mc_run_range(first, last, threads,
+				       &compute_block, worker_ptrs));
+    if (status == SUCCESS && last < progress->last)
+    {
+      pack_estimators(sim, &set, 0);
+      status = store_checkpoint(progress, last, set.data);
+    }
+  } /* end of for-loop */
+
+  if (status == SUCCESS)
+  {
+    pack_estimators(sim, &set, 0);
+    stat_merge(&set, total);
+    status = write_summary(sim, &set, total);
+  }
+
+  snprintf(filename, sizeof filename, "%s/estimators.bin", sim->filepath);
+  if (status == SUCCESS && progress->point.shards > 1
+      && stat_blocks_store(filename, &set) != 0)
+  {
+    #ifndef SILENT
+    printf("Fatal:   Cannot store estimators in %s.\n", filename);
+    #endif
+    status = IO_ERROR;
+  }
+
+  free(profiles);
+  free(est);
+  free(total);
+  stat_blocks_free(&set);
+
+  return status;
+} /* end of run_statistics function */
+#endif
+
+
+static int
+compute_sweep_block(void *arg, unsigned int b)
+{
+  /*
+   * Compute the Brownian paths of block b once, at the Brownian
+   * precision, and the approximation at every step precision of the
+   * sweep on these same paths. Push the values at time T in the
+   * estimators of the block (one per step precision).
+   */
+
+  struct worker *worker = arg;
+  const struct simulation *sim = worker->sim;
+  struct estimators *est = &sim->blocks[(size_t)b * sim->sweep_size];
+  const unsigned int first = b * sim->block_size;
+  unsigned int last = first + sim->block_size;
+  double *brownian_motion = worker->traj.brownian_motion;
+  double *path = worker->traj.path;
+  #ifdef COMPARE
+  double *reference = worker->traj.reference;
+  #endif
+  prng_state rng;
+  unsigned int factor, truncation;
+  double value;
+
+  if (last > sim->iter)
+  {
+    last = sim->iter;
+  }
+
+  for (unsigned int i = first; i < last; ++i)
+  {
+    METRIC_PATH(&worker->metrics, i);
+    METRIC_ADD(&worker->metrics, paths, 1);
+    METRIC_STAGE(&worker->metrics, METRIC_RNG,
+		 prng_init(&rng, GENERATOR, sim->seed, i);
+		 sample_brownian(sim, &rng, i, brownian_motion));
+    #ifdef COMPARE
+    METRIC_STAGE(&worker->metrics, METRIC_REFERENCE,
+		 reference_process(sim, brownian_motion, reference));
+    #endif
+
+    for (unsigned int k = 0; k < sim->sweep_size; ++k)
+    {
+      factor = floor(sim->sweep_steps[k] / sim->brownian_precision);
+      truncation = floor(sim->time_bound / sim->sweep_steps[k]) + 1;
+      METRIC_STAGE(&worker->metrics, METRIC_SCHEME,
+		   scheme_kernels[sim->scheme](sim->time_bound,
+					       sim->sweep_steps[k],
+					       initial_condition(),
+					       brownian_motion, factor,
+					       path));
+
+      value = path[truncation - 1];
+      acc_push(&est[k].approximation, value);
+      #ifdef COMPARE
+      double exact = reference[factor * (truncation - 1)];
+      acc_push(&est[k].reference, exact);
+      acc_push(&est[k].strong_error, fabs(value - exact));
+      acc_push(&est[k].weak_error, value - exact);
+      #endif
+    }
+  }
+  
+  return SUCCESS;
+} /* end of compute_sweep_block function */
+
+
+static state
+run_sweep(struct simulation *sim, const run_config *config,
+	  unsigned int threads, void **worker_ptrs)
+{
+  /*
+   * Simulate every (Brownian precision, number of iterations) pair of
+   * the grid, and store the estimators at time T of every step
+   * precision in 'sweep.csv', one line per quantity.
+   */
+
+  const double *brownian = config->sweep_brownian;
+  unsigned int brownian_size = config->sweep_brownian_size;
+  const unsigned int *iters = config->sweep_iter;
+  unsigned int iter_size = config->sweep_iter_size;
+  double finest = config->brownian_precision;
+  char filename[OUTPUT_NAME_SIZE];
+  char label[128];
+  FILE *output;
+  state status = SUCCESS;
+
+  /* Default grid: a single Brownian precision, fine enough. */
+  for (unsigned int k = 0; k < config->sweep_steps_size; ++k)
+  {
+    if (config->sweep_steps[k] < finest)
+    {
+      finest = config->sweep_steps[k];
+    }
+  }
+  if (brownian_size == 0)
+  {
+    brownian = &finest;
+    brownian_size = 1;
+  }
+  if (iter_size == 0)
+  {
+    iters = &config->iter;
+    iter_size = 1;
+  }
+
+  sim->sweep_steps = config->sweep_steps;
+  sim->sweep_size = config->sweep_steps_size;
+
+  /* Brownian bridges refine the largest step of the sweep. */
+  sim->bridge_step = sim->sweep_steps[0];
+  for (unsigned int k = 0; k < sim->sweep_size; ++k)
+  {
+    if (sim->sweep_steps[k] > sim->bridge_step)
+    {
+      sim->bridge_step = sim->sweep_steps[k];
+    }
+  }
+  for (unsigned int k = 0; BROWNIAN == BROWNIAN_BRIDGE && k < sim->sweep_size
+	 + brownian_size; ++k)
+  {
+    if (dyadic_level(sim->time_bound, sim->bridge_step, k < sim->sweep_size
+		     ? sim->sweep_steps[k]
+		     : brownian[k - sim->sweep_size]) < 0)
+    {
+      #ifndef SILENT
+      printf("Fatal:  Brownian bridges need dyadic refinements of the largest step.\n");
+      #endif
+      return INVALID_BROWNIAN_PRECISION;
+    }
+  }
+  for (unsigned int k = 0; sim->scheme == SCHEME_ADAPTIVE
+	 && k < sim->sweep_size * brownian_size; ++k)
+  {
+    if (dyadic_level(sim->time_bound, sim->sweep_steps[k % sim->sweep_size],
+		     brownian[k / sim->sweep_size]) < 0)
+    {
+      #ifndef SILENT
+      printf("Fatal:  The adaptive scheme needs step_precision = 2^k brownian_precision.\n");
+      #endif
+      return INVALID_BROWNIAN_PRECISION;
+    }
+  }
+
+  if (output_name(filename, sim->filepath, "sweep.csv") != SUCCESS)
+  {
+    return IO_ERROR;
+  }
+  output = fopen(filename, "w");
+  if (output == NULL)
+  {
+    return IO_ERROR;
+  }
+  fprintf(output, "step,brownian_step,iter,quantity,count,mean,variance,"
+	  "ci_low,ci_high\n");
+
+  for (unsigned int m = 0; m < brownian_size && status == SUCCESS; ++m)
+  {
+    for (unsigned int n = 0; n < iter_size && status == SUCCESS; ++n)
+    {
+      const unsigned int iter = iters[n];
+      const unsigned int blocks = iter < STAT_BLOCKS ? iter : STAT_BLOCKS;
+      const unsigned int size = sim->sweep_size;
+      struct estimators *est = calloc((size_t)(blocks + 1) * size,
+				      sizeof *est);
+      struct estimators *total;
+
+      if (est == NULL)
+      {
+	status = CANNOT_ALLOCATE_SDS;
+	break;
+      }
+      
+      sim->brownian_precision = brownian[m];
+      #ifdef COMPARE
+      reference_plan_init(&sim->reference, &REFERENCE_SDE, brownian[m]);
+      #endif
+      sim->level = dyadic_level(sim->time_bound, sim->bridge_step,
+				brownian[m]);
+      sim->steps = floor(sim->time_bound / brownian[m]) + 1;
+      sim->iter = iter;
+      sim->block_size = (iter + blocks - 1) / blocks;
+      sim->blocks = est;
+
+      /* Zeroed accumulators are empty, the last 'size' are the total. */
+      status = driver_state(mc_run((iter + sim->block_size - 1)
+				   / sim->block_size, threads,
+				   &compute_sweep_block, worker_ptrs));
+      total = &est[(size_t)blocks * size];
+
+      for (unsigned int k = 0; k < size && status == SUCCESS; ++k)
+      {
+	for (unsigned int b = 0; b < blocks; ++b)
+	{
+	  acc_merge(&total[k].approximation, &est[b * size + k].approximation);
+	  #ifdef COMPARE
+	  acc_merge(&total[k].reference, &est[b * size + k].reference);
+	  acc_merge(&total[k].strong_error, &est[b * size + k].strong_error);
+	  acc_merge(&total[k].weak_error, &est[b * size + k].weak_error);
+	  #endif
+	}
+
+	#define SWEEP_LABEL(quantity)						\
+	  snprintf(label, 128, "%.*f,%.*f,%u,%s", (int)sim->float_prec,	\
+		   sim->sweep_steps[k], (int)sim->float_prec, brownian[m], \
+		   iter, quantity)
+	SWEEP_LABEL("approximation");
+	print_acc_in_csv(output, label, &total[k].approximation, CONFIDENCE,
+			 sim->float_prec);
+	#ifdef COMPARE
+	SWEEP_LABEL("reference");
+	print_acc_in_csv(output, label, &total[k].reference, CONFIDENCE,
+			 sim->float_prec);
+	SWEEP_LABEL("strong_error");
+	print_acc_in_csv(output, label, &total[k].strong_error, CONFIDENCE,
+			 sim->float_prec);
+	SWEEP_LABEL("weak_error");
+	print_acc_in_csv(output, label, &total[k].weak_error, CONFIDENCE,
+			 sim->float_prec);
+	#endif
+	#undef SWEEP_LABEL
+
+	#ifndef SILENT
+	#ifdef COMPARE
+	printf("Sweep:   step %.*f, %u paths: strong error %.*f +/- %.*f\n",
+	       (int)sim->float_prec, sim->sweep_steps[k], iter,
+	       (int)sim->float_prec, total[k].strong_error.mean,
+	       (int)sim->float_prec,
+	       acc_half_width(&total[k].strong_error, CONFIDENCE));
+	#else
+	printf("Sweep:   step %.*f, %u paths: mean %.*f +/- %.*f\n",
+	       (int)sim->float_prec, sim->sweep_steps[k], iter,
+	       (int)sim->float_prec, total[k].approximation.mean,
+	       (int)sim->float_prec,
+	       acc_half_width(&total[k].approximation, CONFIDENCE));
+	#endif
+	#endif
+      }
+
+      free(est);
+    }
+  }
+
+  fclose(output);
+
+  #ifndef SILENT
+  if (status == SUCCESS)
+  {
+    printf("Success: Sweep stored in '%s'\n", filename);
+  }
+  #endif
+  
+  return status;
+} /* end of run_sweep function */
+
+
+static state
+run_mlmc(const struct simulation *sim, double epsilon, unsigned int threads)
+{
+  /*
+   * Estimate E[f(X_T)] by multilevel Monte Carlo, the coarsest level
+   * using the step precision. The estimators of every level are
+   * stored in 'mlmc.csv', followed by the estimate itself.
+   */
+
+  mlmc_problem problem;
+  mlmc_result result;
+  char filename[OUTPUT_NAME_SIZE];
+  char label[64];
+  FILE *output;
+  double variance = 0.0, half_width;
+  unsigned long long count = 0;
+  int status;
+
+  problem.time_bound = sim->time_bound;
+  problem.coarsest_step = sim->step_precision;
+  problem.init = initial_condition();
+  problem.determ_func = &deterministic_term;
+  problem.stocha_func = &stochastic_term;
+  /* Levels have no finer Brownian values: adaptive steps are whole. */
+  if (sim->scheme == SCHEME_ADAPTIVE)
+  {
+    problem.scheme = &milstein_model;
+    problem.step = &milstein_step;
+  }
+  else
+  {
+    problem.scheme = scheme_kernels[sim->scheme];
+    problem.step = scheme_steps[sim->scheme];
+  }
+  problem.functional = &mlmc_functional;
+  problem.kind = GENERATOR;
+  problem.seed = sim->seed;
+  problem.brownian = BROWNIAN;
+
+  status = mlmc_run(&problem, epsilon, threads, &result);
+  if (status != 0 && status != MLMC_ERR_MAX_LEVEL)
+  {
+    return CANNOT_ALLOCATE_SDS;
+  }
+
+  if (output_name(filename, sim->filepath, "mlmc.csv") != SUCCESS)
+  {
+    return IO_ERROR;
+  }
+  output = fopen(filename, "w");
+  if (output == NULL)
+  {
+    return IO_ERROR;
+  }
+
+  fprintf(output, "level,step,count,mean,variance,ci_low,ci_high\n");
+  for (unsigned int l = 0; l < result.size; ++l)
+  {
+    snprintf(label, 64, "%u,%.*f", l, (int)sim->float_prec,
+	     problem.coarsest_step / pow(2, l));
+    print_acc_in_csv(output, label, &result.levels[l], CONFIDENCE,
+		     sim->float_prec);
+    if (result.levels[l].count > 0)
+    {
+      variance += acc_variance(&result.levels[l]) / result.levels[l].count;
+    }
+    count += result.levels[l].count;
+  }
+  half_width = normal_quantile(0.5 + 0.5 * CONFIDENCE) * sqrt(variance);
+  fprintf(output, "total,,%llu,%.*f,%.*f,%.*f,%.*f\n", count,
+	  (int)sim->float_prec, result.estimate,
+	  (int)sim->float_prec, variance,
+	  (int)sim->float_prec, result.estimate - half_width,
+	  (int)sim->float_prec, result.estimate + half_width);
+  fclose(output);
+
+  #ifndef SILENT
+  if (status == MLMC_ERR_MAX_LEVEL)
+  {
+    printf("Warn:    %d levels were not enough to reach the target bias.\n",
+	   MLMC_MAX_LEVELS);
+  }
+  printf("MLMC:    E[f(X_T)] = %.*f +/- %.*f (%u levels, %llu samples)\n",
+	 (int)sim->float_prec, result.estimate, (int)sim->float_prec,
+	 half_width, result.size, count);
+  printf("         alpha = %.2f, beta = %.2f, cost = %.3e steps\n",
+	 result.alpha, result.beta, result.cost);
+  printf("Success: Estimators stored in '%s'\n", filename);
+  #endif
+  
+  return SUCCESS;
+} /* end of run_mlmc function */
+
+
+#ifdef INSTRUMENT
+static void
+report_metrics(const struct simulation *sim, const struct worker *workers,
+	       unsigned int threads, const metrics_clock *begin,
+	       const metrics_clock *end)
+{
+  /*
+   * Print the counters of every worker, merged, then store them in
+   * 'metrics.json' (see INSTRUMENT_JSON) and the trace events in
+   * 'trace.json' (see INSTRUMENT_TRACE). A file which cannot be
+   * written is not an error of the run.
+   */
+
+  metrics *counters = malloc(threads * sizeof *counters);
+  char filename[OUTPUT_NAME_SIZE];
+
+  if (counters == NULL)
+  {
+    return;
+  }
+
+  /* CSV files are counted by their writer. */
+  for (unsigned int t = 0; t < threads; ++t)
+  {
+    counters[t] = workers[t].metrics;
+    counters[t].bytes += workers[t].writer->written;
+  }
+
+  #ifndef SILENT
+  metrics_print(stdout, counters, threads, begin, end);
+  #endif
+
+  #ifdef INSTRUMENT_JSON
+  if (output_name(filename, sim->filepath, "metrics.json") != SUCCESS
+      || metrics_write_json(filename, counters, threads, begin, end) != 0)
+  {
+    #ifndef SILENT
+    printf("Warn:    Unable to store metrics in '%s'.\n", filename);
+    #endif
+  }
+  #ifndef SILENT
+  else
+  {
+    printf("Success: Metrics stored in '%s'\n", filename);
+  }
+  #endif
+  #endif
+
+  if (INSTRUMENT_TRACE > 0
+      && (output_name(filename, sim->filepath, "trace.json") != SUCCESS
+	  || metrics_write_trace(filename, counters, threads, begin, end)
+	  != 0))
+  {
+    #ifndef SILENT
+    printf("Warn:    Unable to store trace events in '%s'.\n", filename);
+    #endif
+  }
+  #ifndef SILENT
+  else if (INSTRUMENT_TRACE > 0)
+  {
+    printf("Success: Trace events stored in '%s'\n", filename);
+  }
+  #endif
+
+  free(counters);
+} /* end of report_metrics function */
+#endif
+
+
+static void
+default_config(run_config *config)
+{
+  /* Values set in config.h. */
+  
+  memset(config, 0, sizeof *config);
+  snprintf(config->filepath, OPT_MAX_PATH, "%s", FILEPATH);
+  config->seed = PRNG_SEED;
+  #ifdef USE_TIME
+  config->use_time = 1;
+  #endif
+  config->iter = ITER;
+  config->threads = THREADS;
+  config->writers = WRITERS;
+  config->checkpoint = CHECKPOINT;
+  config->shard = 1;
+  config->shards = 1;
+  config->float_prec = FLOAT_PREC;
+  config->time_bound = TIME_BOUND;
+  config->step_precision = STEP_PRECISION;
+  config->brownian_precision = BROWNIAN_PRECISION;
+  config->scheme = SCHEME;
+  config->precision = PRECISION;
+  config->qmc_replicates = QMC_REPLICATES;
+  #ifdef ANTITHETIC
+  config->antithetic = 1;
+  #endif
+  config->strata = STRATA;
+  config->rows = ROWS;
+  config->rows_step = ROWS_STEP;
+  config->observation_size = sizeof OBSERVATION_TIMES
+    / sizeof *OBSERVATION_TIMES;
+  if (config->observation_size > OPT_MAX_SWEEP)
+  {
+    config->observation_size = OPT_MAX_SWEEP;
+  }
+  memcpy(config->observation_times, OBSERVATION_TIMES,
+	 config->observation_size * sizeof *OBSERVATION_TIMES);
+} /* end of default_config function */
+
+
+static int
+select_rows(const run_config *config, unsigned int rows, double step,
+	    unsigned int **index, unsigned int **order, unsigned int *count)
+{
+  /*
+   * Rows stored out of the 'rows' rows of a trajectory, one every
+   * 'step', see ROWS: '*count' rows, the k-th being (*index)[k], or
+   * k if '*index' is NULL. They come along the trajectory in the
+   * order (*order)[0], (*order)[1]... (which follows '*index' in the
+   * same block). MUST BE FREE'D (through '*index')!
+   *
+   * Returns SUCCESS, or CANNOT_ALLOCATE_SDS.
+   */
+
+  const unsigned int every = config->rows_step;
+  unsigned int j, m;
+
+  *index = NULL;
+  *order = NULL;
+  switch (config->rows)
+  {
+  case ROWS_TERMINAL:
+    *count = 1;
+    break;
+  case ROWS_EVERY:
+    *count = (rows - 1) / every + 1 + ((rows - 1) % every != 0);
+    break;
+  case ROWS_TIMES:
+    *count = config->observation_size;
+    break;
+  case ROWS_SUMMARY:
+    *count = 1;
+    return SUCCESS;
+  default:
+    *count = rows;
+    return SUCCESS;
+  }
+
+  *index = malloc(2 * *count * sizeof **index);
+  if (*index == NULL)
+  {
+    return CANNOT_ALLOCATE_SDS;
+  }
+  *order = *index + *count;
+
+  for (unsigned int k = 0; k < *count; ++k)
+  {
+    if (config->rows == ROWS_TERMINAL)
+    {
+      j = rows - 1;
+    }
+    else if (config->rows == ROWS_EVERY)
+    {
+      j = k * every;
+    }
+    else
+    {
+      j = floor(config->observation_times[k] / step + 0.5);
+    }
+    (*index)[k] = j < rows ? j : rows - 1;
+
+    /* Insertion sort, equal rows keeping their order. */
+    for (m = k; m > 0 && (*index)[(*order)[m - 1]] > (*index)[k]; --m)
+    {
+      (*order)[m] = (*order)[m - 1];
+    }
+    (*order)[m] = k;
+  }
+
+  return SUCCESS;
+} /* end of select_rows function */
+
+
+static void
+init_progress(struct simulation *sim, const run_config *config,
+	      struct progress *progress)
+{
+  /*
+   * Describe the run of 'sim', none of its units being done, and
+   * convert the trajectories between two checkpoints in units: blocks
+   * of trajectories with STATISTICS (see statistics_blocks), batches
+   * of VECTOR_BATCH trajectories for systems, trajectories otherwise.
+   */
+
+  checkpoint *point = &progress->point;
+  unsigned int paths = 1;
+
+  memset(point, 0, sizeof *point);
+  #ifdef STATISTICS
+  point->mode = UNIT_BLOCK;
+  point->units = statistics_blocks(sim);
+  point->size = point->units * (QUANTITIES + (size_t)sim->profile_size
+				+ (sim->functional > 0 ? STAT_REDUCED : 0))
+    * sizeof(accumulator);
+  paths = (sim->iter + point->units - 1) / point->units;
+  #else
+  point->mode = sim->vector != NULL ? UNIT_BATCH : UNIT_PATH;
+  if (sim->vector != NULL)
+  {
+    point->units = (sim->iter + VECTOR_BATCH - 1) / VECTOR_BATCH;
+    paths = VECTOR_BATCH;
+  }
+  else
+  {
+    point->units = sim->iter;
+  }
+  #endif
+  point->seed = sim->seed;
+  point->iter = sim->iter;
+  point->time_bound = sim->time_bound;
+  point->step_precision = sim->step_precision;
+  point->brownian_precision = sim->brownian_precision;
+  point->scheme = sim->scheme;
+  point->output = OUTPUT;
+  point->rows = sim->rows;
+  point->rows_step = config->rows_step;
+  point->observation = sim->rows != ROWS_TIMES ? 0
+    : checkpoint_hash(config->observation_times, config->observation_size
+		      * sizeof *config->observation_times);
+  point->row_count = sim->row_count;
+  point->columns = 1 + DIMENSION * (PATH_COLUMNS - 1);
+  point->replicates = sim->replicates;
+  point->shard = config->shard;
+  point->shards = config->shards;
+  point->precision = sim->precision;
+  point->antithetic = sim->antithetic;
+  point->strata = sim->strata;
+  #ifdef CONTROL_VARIATE
+  point->control = 1;
+  #endif
+
+  /* Shard k of N: the k-th of N ranges of units as equal as can be. */
+  progress->first = (uint64_t)point->units * (config->shard - 1)
+    / config->shards;
+  progress->last = (uint64_t)point->units * config->shard / config->shards;
+  point->done = progress->first;
+
+  progress->every = config->checkpoint > 0
+    ? (config->checkpoint + paths - 1) / paths : 0;
+} /* end of init_progress function */
+
+
+int
+main(int argc, char **argv)
+{
+  run_config config;
+  int parsed;
+
+  default_config(&config);
+  parsed = parse_options(&config, argc, argv);
+  if (parsed == OPT_HELP)
+  {
+    print_usage(argv[0]);
+    return SUCCESS;
+  }
+  else if (parsed != 0)
+  {
+    return INVALID_ARGUMENT;
+  }
+  
+  uint64_t seed = config.use_time ? (uint64_t)time(NULL) : config.seed;
+  const int sweep = config.sweep_steps_size > 0;
+  unsigned int iter = config.iter;
+  struct progress progress = {0};
+  checkpoint resumed = {0};
+  int resume = 0;
+
+  /* An interrupted run goes on with its own seed (see CHECKPOINT). */
+  snprintf(progress.filename, sizeof progress.filename,
+	   "%s/checkpoint.bin", config.filepath);
+  if (config.resume)
+  {
+    parsed = checkpoint_load(progress.filename, &resumed, NULL, 0);
+    if (parsed == 0)
+    {
+      resume = 1;
+      seed = resumed.seed;
+    }
+    else if (parsed != CHECKPOINT_ERR_OPEN)
+    {
+      #ifndef SILENT
+      printf("Fatal:  Cannot read checkpoint %s.\n", progress.filename);
+      #endif
+      return IO_ERROR;
+    }
+    #ifndef SILENT
+    else
+    {
+      printf("Warn:   No checkpoint %s, starting from the beginning.\n",
+	     progress.filename);
+    }
+    #endif
+  }
+
+  for (unsigned int n = 0; sweep && n < config.sweep_iter_size; ++n)
+  {
+    iter = (n == 0 || config.sweep_iter[n] > iter) ? config.sweep_iter[n]
+      : iter;
+  }
+
+  /* Type safety */
+  const char *filepath = config.filepath;
+  const unsigned int float_prec = config.float_prec;
+  const double step_precision = config.step_precision;
+  const double time_bound = config.time_bound;
+  const unsigned int cores = config.threads > 0 ? config.threads
+    : mc_available_threads();
+  const unsigned int threads = cores < iter ? cores : iter;
+  #ifdef COMPARE
+  const double brownian_precision = config.brownian_precision;
+  #else
+  const double brownian_precision = config.scheme == SCHEME_ADAPTIVE
+    ? config.brownian_precision : step_precision;
+  #endif
+  /* The sweep uses the Brownian precision of 'config' in any case. */
+  double finest = sweep && config.brownian_precision < brownian_precision
+    ? config.brownian_precision : brownian_precision;
+  for (unsigned int k = 0; sweep && k < config.sweep_steps_size; ++k)
+  {
+    finest = config.sweep_steps[k] < finest ? config.sweep_steps[k] : finest;
+  }
+  for (unsigned int m = 0; sweep && m < config.sweep_brownian_size; ++m)
+  {
+    finest = config.sweep_brownian[m] < finest ? config.sweep_brownian[m]
+      : finest;
+  }
+  const unsigned int factor = floor(step_precision / brownian_precision);
+  double cholesky[FACTORS * FACTORS];
+  const vector_sde system = {DIMENSION, FACTORS, &deterministic_vector,
+    &stochastic_vector, cholesky, LAYOUT};
+  const unsigned int steps = floor(time_bound / brownian_precision) + 1;
+  const unsigned int truncation = floor(time_bound / step_precision) + 1;
+
+  
+  /* Mandatory verifications */
+  if (!isfinite(step_precision) || step_precision <= 0)
+  {
+    #ifndef SILENT
+    printf("Fatal:  step_precision cannot be less than zero.\n");
+    #endif
+    return INVALID_STEP_PRECISION;
+  }
+
+  if (!isfinite(brownian_precision) || brownian_precision <= 0
+      || brownian_precision > step_precision)
+  {
+    #ifndef SILENT
+    printf("Fatal:  brownian_precision cannot be greater than step_precision.\n");
+    #endif
+    return INVALID_BROWNIAN_PRECISION;
+  }
+
+  if (!isfinite(time_bound) || time_bound < 0)
+  {
+    #ifndef SILENT
+    printf("Fatal:  time_bound must be positive and finite.\n");
+    #endif
+    return INVALID_TIME_BOUND;
+  }
+
+  for (unsigned int k = 0; sweep && k < config.sweep_steps_size; ++k)
+  {
+    for (unsigned int m = 0; m < config.sweep_brownian_size; ++m)
+    {
+      if (!isfinite(config.sweep_brownian[m]) || config.sweep_brownian[m] <= 0
+	  || config.sweep_brownian[m] > config.sweep_steps[k])
+      {
+	#ifndef SILENT
+	printf("Fatal:  brownian_precision cannot be greater than step_precision.\n");
+	#endif
+	return INVALID_BROWNIAN_PRECISION;
+      }
+    }
+    
+    if (!isfinite(config.sweep_steps[k]) || config.sweep_steps[k] <= 0)
+    {
+      #ifndef SILENT
+      printf("Fatal:  step_precision cannot be less than zero.\n");
+      #endif
+      return INVALID_STEP_PRECISION;
+    }
+  }
+
+  if (BROWNIAN == BROWNIAN_BRIDGE && !sweep && config.mlmc_epsilon <= 0
+      && dyadic_level(time_bound, step_precision, brownian_precision) < 0)
+  {
+    #ifndef SILENT
+    printf("Fatal:  Brownian bridges need step_precision = 2^k brownian_precision.\n");
+    #endif
+    return INVALID_BROWNIAN_PRECISION;
+  }
+
+  if (config.scheme == SCHEME_ADAPTIVE && !sweep && config.mlmc_epsilon <= 0
+      && dyadic_level(time_bound, step_precision, brownian_precision) < 0)
+  {
+    #ifndef SILENT
+    printf("Fatal:  The adaptive scheme needs step_precision = 2^k brownian_precision.\n");
+    #endif
+    return INVALID_BROWNIAN_PRECISION;
+  }
 
-#ifndef ITER
-#define ITER 1
-#endif
+  if (config.qmc_replicates > 0
+      && (dyadic_level(time_bound, time_bound, brownian_precision) < 0
+	  || dyadic_level(time_bound, step_precision, brownian_precision) < 0))
+  {
+    #ifndef SILENT
+    printf("Fatal:  Quasi-Monte Carlo needs time_bound = 2^k step_precision = 2^l brownian_precision.\n");
+    #endif
+    return INVALID_BROWNIAN_PRECISION;
+  }
 
-#ifndef STEP_PRECISION
-#define STEP_PRECISION pow(2, -7)
-#endif
+  if (config.qmc_replicates > iter || (config.qmc_replicates > 0
+				       && (sweep || config.mlmc_epsilon > 0)))
+  {
+    #ifndef SILENT
+    printf("Fatal:  qmc must be at most iter, without sweep nor mlmc.\n");
+    #endif
+    return INVALID_ARGUMENT;
+  }
 
-#ifndef TIME_BOUND
-#define TIME_BOUND 1.0
-#endif
+  if (BROWNIAN == BROWNIAN_BRIDGE && config.mlmc_epsilon > 0
+      && floor(time_bound / step_precision) * step_precision != time_bound)
+  {
+    #ifndef SILENT
+    printf("Fatal:  time_bound must be a multiple of step_precision.\n");
+    #endif
+    return INVALID_TIME_BOUND;
+  }
 
-#ifdef COMPARE
-#define STEPS floor(TIME_BOUND / BROWNIAN_PRECISION) + 1
-#define FACTOR floor(STEP_PRECISION / BROWNIAN_PRECISION)
-#ifndef BROWNIAN_PRECISION
-#define BROWNIAN_PRECISION STEP_PRECISION
-#endif
-#else
-#define STEPS floor(TIME_BOUND / STEP_PRECISION) + 1
-#endif
+  if (iter < 1)
+  {
+    #ifndef SILENT
+    printf("Fatal:  iter must be an integer and cannot be less than 1.\n");
+    #endif
+    return INVALID_ITERATION_NUMBER;
+  }
 
+  for (unsigned int n = 0; sweep && n < config.sweep_iter_size; ++n)
+  {
+    if (config.sweep_iter[n] < 1)
+    {
+      #ifndef SILENT
+      printf("Fatal:  iter must be an integer and cannot be less than 1.\n");
+      #endif
+      return INVALID_ITERATION_NUMBER;
+    }
+  }
 
-int
-main(void)
-{
-  #ifdef USE_TIME
-  srand((unsigned int)time(NULL));
+  if ((config.checkpoint > 0 || config.resume || config.shards > 1)
+      && (sweep || config.mlmc_epsilon > 0))
+  {
+    #ifndef SILENT
+    printf("Fatal:  Checkpoints and shards are not available with sweep nor mlmc.\n");
+    #endif
+    return INVALID_ARGUMENT;
+  }
+
+  /* Shards are parts of the same run, hence of the same seed. */
+  if (config.shards > 1 && config.use_time)
+  {
+    #ifndef SILENT
+    printf("Fatal:  Shards need a common seed (see --seed), not USE_TIME.\n");
+    #endif
+    return INVALID_ARGUMENT;
+  }
+
+  #ifdef STATISTICS
+  const int statistics = 1;
   #else
-  srand((unsigned int)PRNG_SEED);
+  const int statistics = 0;
   #endif
+  if (DIMENSION > 1 && (statistics || sweep || config.mlmc_epsilon > 0
+			|| config.qmc_replicates > 0
+			|| BROWNIAN == BROWNIAN_BRIDGE
+			|| config.scheme != SCHEME_EULER))
+  {
+    #ifndef SILENT
+    printf("Fatal:  Systems (DIMENSION > 1) need the Euler-Maruyama scheme, without statistics, sweep, mlmc, qmc nor Brownian bridges.\n");
+    #endif
+    return INVALID_ARGUMENT;
+  }
 
-  /* Type safety */
-  const char *filepath = FILEPATH;
-  const unsigned int float_prec = FLOAT_PREC;
-  const unsigned int iter = ITER;
-  const double step_precision = STEP_PRECISION;
-  const unsigned int steps = STEPS;
-  const double time_bound = TIME_BOUND;
-  #ifdef COMPARE
-  const double brownian_precision = BROWNIAN_PRECISION;
-  const unsigned int factor = FACTOR;
-  const unsigned int truncation = floor(time_bound / step_precision) + 1;
+  if (config.precision == PRECISION_SINGLE
+      && (!statistics || sweep || config.mlmc_epsilon > 0
+	  || config.qmc_replicates > 0 || DIMENSION > 1))
+  {
+    #ifndef SILENT
+    printf("Fatal:  Single precision needs statistics, without sweep, mlmc, qmc nor systems.\n");
+    #endif
+    return INVALID_ARGUMENT;
+  }
+
+  #ifdef CONTROL_VARIATE
+  const int control = 1;
   #else
+  const int control = 0;
   #endif
-  
-  
-  /* Mandatory verifications */
-  if (step_precision <= 0)
+  const int reduction = config.antithetic || config.strata > 0 || control;
+  if (reduction && (!statistics || sweep || config.mlmc_epsilon > 0
+		    || config.qmc_replicates > 0 || DIMENSION > 1))
   {
     #ifndef SILENT
-    printf("Fatal:  step_precision cannot be less than zero.\n");
+    printf("Fatal:  Variance reduction needs statistics, without sweep, mlmc, qmc nor systems.\n");
     #endif
-    return INVALID_STEP_PRECISION;
+    return INVALID_ARGUMENT;
   }
 
-  #ifdef COMPARE
-  if (brownian_precision > step_precision)
+  #ifndef COMPARE
+  if (control)
   {
     #ifndef SILENT
-    printf("Fatal:  brownian_precision cannot be greater than step_precision.\n");
+    printf("Fatal:  Control variates (CONTROL_VARIATE) need COMPARE.\n");
     #endif
-    return INVALID_BROWNIAN_PRECISION;
+    return INVALID_ARGUMENT;
   }
   #endif
 
-  if (time_bound < 0)
+  if (config.antithetic && (config.strata > 0 || iter % 2 != 0))
   {
     #ifndef SILENT
-    printf("Fatal:  time_bound must be positive.\n");
+    printf("Fatal:  Antithetic pairs need an even iter, without strata.\n");
     #endif
-    return INVALID_TIME_BOUND;
+    return INVALID_ITERATION_NUMBER;
   }
 
-  if (iter < 1)
+  if (config.strata > iter)
   {
     #ifndef SILENT
-    printf("Fatal:  iter must be an integer and cannot be less than 1.\n");
+    printf("Fatal:  strata must be at most iter.\n");
     #endif
     return INVALID_ITERATION_NUMBER;
   }
 
+  if (config.strata > 0
+      && (dyadic_level(time_bound, time_bound, brownian_precision) < 0
+	  || dyadic_level(time_bound, step_precision, brownian_precision) < 0))
+  {
+    #ifndef SILENT
+    printf("Fatal:  Strata need time_bound = 2^k step_precision = 2^l brownian_precision.\n");
+    #endif
+    return INVALID_BROWNIAN_PRECISION;
+  }
+
+  #ifdef COMPARE
+  reference_plan reference = {0};
+  
+  if (REFERENCE == REFERENCE_LINEAR
+      && reference_plan_init(&reference, &REFERENCE_SDE,
+			     brownian_precision) != 0)
+  {
+    #ifndef SILENT
+    printf("Fatal:  REFERENCE_SDE has no closed form (neither additive nor multiplicative noise).\n");
+    #endif
+    return INVALID_ARGUMENT;
+  }
+  #endif
+
+  if (DIMENSION > 1 && config.rows == ROWS_SUMMARY)
+  {
+    #ifndef SILENT
+    printf("Fatal:  Systems (DIMENSION > 1) cannot be summarized.\n");
+    #endif
+    return INVALID_ARGUMENT;
+  }
+
+  if (config.rows_step < 1
+      || (config.rows == ROWS_TIMES && config.observation_size == 0))
+  {
+    #ifndef SILENT
+    printf("Fatal:  rows_step must be positive and observation_times cannot be empty.\n");
+    #endif
+    return INVALID_ARGUMENT;
+  }
+
+  for (unsigned int k = 0; config.rows == ROWS_TIMES
+	 && k < config.observation_size; ++k)
+  {
+    if (config.observation_times[k] < 0
+	|| config.observation_times[k] > time_bound)
+    {
+      #ifndef SILENT
+      printf("Fatal:  observation_times must lie in [0, time_bound].\n");
+      #endif
+      return INVALID_ARGUMENT;
+    }
+  }
+
+  if (DIMENSION > 1 && OUTPUT == DATASET)
+  {
+    #ifndef SILENT
+    printf("Fatal:  Systems (DIMENSION > 1) cannot be stored in a dataset.\n");
+    #endif
+    return INVALID_ARGUMENT;
+  }
+
+  /*
+   * Writer threads only store the files of single SDEs. A dataset is
+   * appended to by a single one, in the order of trajectories.
+   */
+  const unsigned int writers = statistics || sweep || config.mlmc_epsilon > 0
+    || DIMENSION > 1 ? 0 : OUTPUT == DATASET ? 1 : config.writers;
+  const unsigned int queue = (OUTPUT_QUEUE > 0 ? OUTPUT_QUEUE : 1) * threads;
+  const unsigned int slot_count = queue < iter ? queue : iter;
+
+  if (DIMENSION > 1
+      && cholesky_factor(CORRELATION, FACTORS, cholesky) != 0)
+  {
+    #ifndef SILENT
+    printf("Fatal:  CORRELATION must be positive definite.\n");
+    #endif
+    return INVALID_ARGUMENT;
+  }
+
   /* It sucks if there's no folder where to store the data. */
   struct stat st = {0};
   if (stat(filepath, &st) == -1)
@@ -142,12 +3158,21 @@ main(void)
   #ifndef SILENT
   printf("Destination path:       %s\n", filepath);
   printf("Number of simulation:   %d\n", iter);
+  printf("Number of threads:      %d\n", threads);
+  if (writers > 0)
+  {
+    printf("Writer threads:         %u\n", writers);
+  }
 
-  #ifdef USE_TIME
-  printf("Seed:                   %d (Time based)\n", PRNG_SEED);
-  #else
-  printf("Seed:                   %d\n", PRNG_SEED);
-  #endif
+  if (config.use_time && !resume)
+  {
+    printf("Seed:                   %llu (Time based)\n",
+	   (unsigned long long)seed);
+  }
+  else
+  {
+    printf("Seed:                   %llu\n", (unsigned long long)seed);
+  }
   
   printf("Precision:              %f\n", step_precision);
   if (step_precision <= 0.0000001)
@@ -158,12 +3183,102 @@ main(void)
   }
   
   printf("Interval of simulation: [0, %.4f]\n", time_bound);
+  if (config.qmc_replicates > 0)
+  {
+    printf("Quasi-Monte Carlo:      %u replicates\n", config.qmc_replicates);
+  }
+  if (reduction)
+  {
+    printf("Variance reduction:    %s%s%s\n",
+	   config.antithetic ? " antithetic" : "",
+	   config.strata > 0 ? " strata" : "", control ? " control" : "");
+  }
   #endif
   
   /* We can proceed to try to compute a solution. */
-  sds *storage = init_sds();
-  sds_store_precision(storage, float_prec);
-  state status;
+  struct simulation sim = {0};
+  sobol_sequence qmc = {0};
+  unsigned int *row_index = NULL, *row_order = NULL;
+  #ifndef STATISTICS
+  bin_dataset dataset;
+  bin_header dataset_header = {0};
+  char dataset_name[sizeof config.filepath + 16];
+  #endif
+  struct worker *workers = malloc((threads + writers) * sizeof *workers);
+  void **worker_ptrs = malloc((threads + writers) * sizeof *worker_ptrs);
+  struct output_slot *slots = calloc(writers > 0 ? slot_count : 0,
+				     sizeof *slots);
+  void **slot_ptrs = malloc((writers > 0 ? slot_count : 0)
+			    * sizeof *slot_ptrs);
+  state status = SUCCESS;
+
+  sim.filepath = filepath;
+  sim.seed = seed;
+  sim.iter = iter;
+  sim.steps = steps;
+  sim.float_prec = float_prec;
+  sim.time_bound = time_bound;
+  sim.step_precision = step_precision;
+  sim.brownian_precision = brownian_precision;
+  sim.factor = factor;
+  sim.truncation = truncation;
+  sim.scheme = config.scheme;
+  sim.precision = config.precision;
+  sim.vector = DIMENSION > 1 ? &system : NULL;
+  sim.bridge_step = step_precision;
+  sim.level = dyadic_level(time_bound, step_precision, brownian_precision);
+  sim.replicates = config.qmc_replicates;
+  sim.antithetic = config.antithetic;
+  sim.strata = config.strata;
+  sim.functional = reduction ? QUANTITIES : 0;
+  sim.rows = config.rows;
+  #ifdef COMPARE
+  sim.reference = reference;
+  #endif
+  #ifdef COMPARE
+  status = select_rows(&config, steps, brownian_precision, &row_index,
+		       &row_order, &sim.row_count);
+  #else
+  status = select_rows(&config, truncation, step_precision, &row_index,
+		       &row_order, &sim.row_count);
+  #endif
+  sim.row_index = row_index;
+  sim.row_order = row_order;
+
+  /*
+   * Quasi-Monte Carlo: one Brownian bridge over [0, T], whose 2^level
+   * random numbers are the coordinates of a Sobol' point. Strata use
+   * the same bridge, W(T) being its first number.
+   */
+  if (sim.strata > 0)
+  {
+    sim.bridge_step = time_bound;
+    sim.level = dyadic_level(time_bound, time_bound, brownian_precision);
+  }
+  if (sim.replicates > 0)
+  {
+    sim.bridge_step = time_bound;
+    sim.level = dyadic_level(time_bound, time_bound, brownian_precision);
+    if (sobol_init(&qmc, 1U << sim.level, sim.replicates, GENERATOR,
+		   seed) != 0)
+    {
+      status = CANNOT_ALLOCATE_SDS;
+    }
+    sim.qmc = &qmc;
+  }
+
+  /*
+   * Unless every row is stored, paths are computed a step at a time
+   * and only their stored rows are kept (see fused_rows). The rows
+   * of a path with COMPARE must then end with its last step.
+   */
+  #ifndef STATISTICS
+  sim.fused = sim.rows != ROWS_ALL && sim.qmc == NULL && sim.strata == 0
+    && sim.vector == NULL && !sweep && config.mlmc_epsilon <= 0;
+  #ifdef COMPARE
+  sim.fused = sim.fused && (truncation - 1) * factor + 1 == steps;
+  #endif
+  #endif
 
   /*
    * If precision of the Brownian motion is set to 2^{-m} and
@@ -177,94 +3292,188 @@ main(void)
    *
    * If we are comparing, we may decide to generate a more precise
    * Brownian motion.
+   *
+   * Every thread owns a worker, i.e. its own CSV writer and arena.
+   * Writer threads own a worker too, after those of the computing
+   * threads.
    */  
-  
-  if (storage == NULL)
+
+  if (workers == NULL || worker_ptrs == NULL || status != SUCCESS
+      || (writers > 0 && (slots == NULL || slot_ptrs == NULL)))
   {
     #ifndef SILENT
     printf("Fatal:   Not enough (heap) space to allocate to storage utility.");
     #endif
+    free(workers);
+    free(worker_ptrs);
+    free(slots);
+    free(slot_ptrs);
+    free(row_index);
+    sobol_free(&qmc);
     return CANNOT_ALLOCATE_SDS;
   }
-  
-  for (unsigned int i = 0; i < iter; ++i)
+
+  /*
+   * Every array of a worker holds a Brownian motion at the finest
+   * precision, the largest array computed, or over a single step for
+   * fused paths; nothing else is allocated while computing paths.
+   */
+  for (unsigned int t = 0; t < threads + writers; ++t)
   {
-    double *brownian_motion;
-    char filename[128];
-    FILE *output;
-    double *path;
-    #ifdef COMPARE    
-    double *interpolation;
-    double *reference;
-    double time_pos[3];
-    double truncated_brownian_motion[truncation];
-    #else
-    double time_pos[2];
-    #endif
-  
-    snprintf(filename, 128, "%s/data_%d.csv", filepath, i + 1);
-    
-    output = fopen(filename, "w");
-    brownian_motion = brownian_path(steps);
-    
-    #ifdef COMPARE
-    for (unsigned int j = 0; j < truncation; ++j)
+    worker_ptrs[t] = &workers[t];
+    if (init_worker(&workers[t], &sim, t >= threads ? 1 : sim.fused
+		    ? factor + 1 : floor(time_bound / finest) + 1) != SUCCESS)
     {
-      truncated_brownian_motion[j] = brownian_motion[factor * j];
+      status = CANNOT_ALLOCATE_SDS;
     }
-    path = euler_maruyama_method(time_bound, step_precision,
-				 initial_condition(), truncated_brownian_motion,
-				 &deterministic_term, &stochastic_term);
-    interpolation = linear_interpolation(path, truncation, factor);
-    reference = reference_process(brownian_motion);
-    #else
-    path = euler_maruyama_method(time_bound, step_precision,
-				 initial_condition(), brownian_motion,
-				 &deterministic_term, &stochastic_term);
-    #endif
-    
-    /* Now printing in file */
-    if (output != NULL)
+  }
+
+  /* Units of the run, and those done before it was interrupted. */
+  if (status == SUCCESS && !sweep && config.mlmc_epsilon <= 0)
+  {
+    init_progress(&sim, &config, &progress);
+    if (resume && !checkpoint_matches(&resumed, &progress.point))
     {
-      for (unsigned int j = 0; j < steps; ++j)
-      {
-	#ifdef COMPARE
-	time_pos[0] = j * brownian_precision;
-	time_pos[1] = interpolation[j];
-	time_pos[2] = reference[j];
-	sds_store_array_double(storage, time_pos, 3);
-	#else
-	time_pos[0] = j * step_precision;
-	time_pos[1] = path[j];
-	sds_store_array_double(storage, time_pos, 2);
-	#endif
-	
-	print_sds_in_csv(output, FORMAT, storage);
-      }
-    
       #ifndef SILENT
-      printf("Success: Computation %d/%d terminated.\n", i + 1, iter);
-      printf("         Results stored in '%s'\n", filename);
+      printf("Fatal:   %s is not a checkpoint of this run.\n",
+	     progress.filename);
+      printf("         Resume with the parameters it was started with.\n");
       #endif
-      status = SUCCESS;
+      status = INVALID_ARGUMENT;
+    }
+    else if (resume)
+    {
+      progress.point.done = resumed.done;
+      #ifndef SILENT
+      printf("Resumed:                %llu of %u units done\n",
+	     (unsigned long long)resumed.done - progress.first,
+	     progress.last - progress.first);
+      #endif
+    }
+
+    #ifndef SILENT
+    if (config.shards > 1)
+    {
+      printf("Shard:                  %u/%u (units %u to %u of %llu)\n",
+	     config.shard, config.shards, progress.first + 1, progress.last,
+	     (unsigned long long)progress.point.units);
+    }
+    #endif
+  }
+
+  /* The slots of the writer threads hold whole trajectories. */
+  #ifndef STATISTICS
+  for (unsigned int k = 0; writers > 0 && k < slot_count; ++k)
+  {
+    slot_ptrs[k] = &slots[k];
+    if (init_slot(&slots[k], output_columns(&sim) * sim.row_count)
+	!= SUCCESS)
+    {
+      status = CANNOT_ALLOCATE_SDS;
+    }
+  }
+
+  /* Every trajectory goes to the same file, see OUTPUT. */
+  if (writers > 0 && OUTPUT == DATASET && status == SUCCESS)
+  {
+    binary_header(&sim, 0, &dataset_header);
+    snprintf(dataset_name, sizeof dataset_name, "%s/dataset.bin", filepath);
+    if (progress.point.done > progress.first
+	? bin_dataset_resume(&dataset, dataset_name, &dataset_header,
+			     progress.point.done - progress.first) == 0
+	: bin_dataset_create(&dataset, dataset_name, &dataset_header) == 0)
+    {
+      sim.dataset = &dataset;
     }
     else
     {
       #ifndef SILENT
-      printf("Fatal:   Unable to print data in CSV file (I/O error).\n");
+      printf("Fatal:   Cannot create dataset %s.\n", dataset_name);
       #endif
       status = IO_ERROR;
     }
+  }
+  #endif
+  
+  if (status == CANNOT_ALLOCATE_SDS)
+  {
+    #ifndef SILENT
+    printf("Fatal:   Not enough (heap) space to allocate to storage utility.");
+    #endif
+  }
+  else if (status == SUCCESS)
+  {
+    #ifdef INSTRUMENT
+    metrics_clock begin, end;
+
+    metrics_clock_now(&begin);
+    #endif
+    rand_normal_init();
+    if (config.mlmc_epsilon > 0)
+    {
+      status = run_mlmc(&sim, config.mlmc_epsilon, cores);
+    }
+    else if (sweep)
+    {
+      status = run_sweep(&sim, &config, threads, worker_ptrs);
+    }
+    else
+    {
+      #ifdef STATISTICS
+      status = run_statistics(&sim, &progress, threads, worker_ptrs);
+      #else
+      status = run_paths(&sim, &progress, threads, writers, worker_ptrs,
+			 slot_ptrs, slot_count);
+      if (sim.dataset != NULL && bin_dataset_close(sim.dataset) != 0)
+      {
+	#ifndef SILENT
+	printf("Fatal:   Unable to complete dataset %s (I/O error).\n",
+	       dataset_name);
+	#endif
+	status = status != SUCCESS ? status : IO_ERROR;
+      }
+      #endif
+
+      /* Complete: nothing left to resume. */
+      if (status == SUCCESS && (progress.every > 0 || resume))
+      {
+	remove(progress.filename);
+      }
+    }
+    #ifndef SILENT
+    if (status == CANNOT_ALLOCATE_SDS)
+    {
+      printf("Fatal:   Not enough (heap) space to run the simulation.\n");
+    }
+    #endif
+    #ifdef INSTRUMENT
+    metrics_clock_now(&end);
+    if (config.mlmc_epsilon <= 0)
+    {
+      report_metrics(&sim, workers, threads + writers, &begin, &end);
+    }
+    #endif
+  }
 
-    fclose(output);
-    #ifdef COMPARE
-    free(interpolation);
-    free(reference);
+  for (unsigned int t = 0; t < threads + writers; ++t)
+  {
+    free_csv_writer(workers[t].writer);
+    arena_free(&workers[t].scratch);
+    #ifdef INSTRUMENT
+    metrics_free(&workers[t].metrics);
     #endif
-    free(path);
-    free(brownian_motion);
   }
+  for (unsigned int k = 0; writers > 0 && k < slot_count; ++k)
+  {
+    arena_free(&slots[k].scratch);
+    free_csv_buffer(&slots[k].text);
+  }
+  free(workers);
+  free(worker_ptrs);
+  free(slots);
+  free(slot_ptrs);
+  free(row_index);
+  sobol_free(&qmc);
   
-  free(storage);  
   return status;
 } /* end of main */
@@ -4,8 +4,15 @@
  * Summary: configuration file for solving numerically some SDE.
  *
  * This configuration file may be changed before compilation in order
- * to solve different SDE. As of now (2022, May), the only algorithm
- * available is the Euler-Maruyama scheme.
+ * to solve different SDE. Several integration schemes are available,
+ * see SCHEME.
+ *
+ * Numerical parameters (FILEPATH, TIME_BOUND, STEP_PRECISION,
+ * BROWNIAN_PRECISION, USE_TIME, PRNG_SEED, ITER, THREADS, WRITERS,
+ * CHECKPOINT, FLOAT_PREC, SCHEME, PRECISION, ROWS, ROWS_STEP,
+ * OBSERVATION_TIMES, ANTITHETIC, STRATA)
+ * are only defaults: they may be overridden at run time, see
+ * 'compute_approximation.exe --help'.
  *
  * Author: bdj <bdosse(at)student.uliege.be>
  *
@@ -23,14 +30,18 @@
 
 #include <stdlib.h>
 
+#include "binary_format.h"
 #include "brownian_path.h"
 #include "data_manipulation.h"
 #include "numerical_approximation.h"
+#include "reference.h"
+#include "vector_sde.h"
 
 
 typedef enum {IO_ERROR=-32, CANNOT_ALLOCATE_SDS, CANNOT_CREATE_DIRECTORY,
   INVALID_STEP_PRECISION, INVALID_BROWNIAN_PRECISION, INVALID_TIME_BOUND,
-  INVALID_ITERATION_NUMBER, INFINITY_OCCURENCE, NAN_OCCURENCE, SUCCESS=0}
+  INVALID_ITERATION_NUMBER, INFINITY_OCCURENCE, NAN_OCCURENCE,
+  INVALID_ARGUMENT, SUCCESS=0}
   state;
 
 void dummy(double arg)
@@ -97,6 +108,53 @@ __custom_exp(double x)
 csv_format FORMAT = COMMA;
 
 
+/*
+ * Output format of the trajectories.
+ *
+ * CSV stores every trajectory in a text file formatted according to
+ * FORMAT. BINARY stores it in a binary columnar file (raw float64
+ * columns, see binary_format.h), far cheaper to write and read; the
+ * 'bin2csv.exe' tool converts it back to CSV. DATASET appends every
+ * trajectory to a single binary file, 'dataset.bin', indexed by path
+ * (see binary_format.h): a single writer thread (see WRITERS) stores
+ * them, and the 'dataset2csv.exe' tool reads any of them back.
+ * Systems (see DIMENSION) cannot be stored in a dataset.
+ *
+ * Available options are: CSV, BINARY, DATASET.
+ *
+ * Default value: CSV
+ */
+output_format OUTPUT = CSV;
+
+
+/*
+ * Rows stored per trajectory, whatever OUTPUT.
+ *
+ * ROWS_ALL stores every row (every step of the Brownian motion if
+ * COMPARE is defined, of the approximation otherwise). ROWS_TERMINAL
+ * only stores the last one, at time TIME_BOUND, the only one read by
+ * 'calculation.R'. ROWS_EVERY stores every ROWS_STEP-th row, from
+ * the first, and the last one. ROWS_TIMES stores the rows at
+ * OBSERVATION_TIMES (the closest step to each time). ROWS_SUMMARY
+ * stores a single row: TIME_BOUND, then for every other column its
+ * last value, its minimum, its maximum and its mean over the rows.
+ *
+ * Other rows are neither interpolated nor formatted, and the writer
+ * threads (see WRITERS) only hold the stored rows. Except for
+ * ROWS_ALL, quasi-Monte Carlo, STRATA and systems, paths are not
+ * stored either: they are computed a step at a time. Systems (see
+ * DIMENSION) cannot be summarized.
+ *
+ * Available options are: ROWS_ALL, ROWS_TERMINAL, ROWS_EVERY,
+ * ROWS_TIMES, ROWS_SUMMARY.
+ *
+ * Default values: ROWS_ALL, 16, {0.25, 0.5, 0.75, 1.0}
+ */
+row_policy ROWS = ROWS_ALL;
+#define ROWS_STEP 16
+const double OBSERVATION_TIMES[] = {0.25, 0.5, 0.75, 1.0};
+
+
 /*
  * Path of output data.
  * Be careful when editing this! Better is to keep it as it is!
@@ -117,30 +175,148 @@ csv_format FORMAT = COMMA;
  */
 
 /*
- * Deterministic term of the SDE. See above for more details.
+ * Terms of the SDE, written once for the floating type 'real' of the
+ * approximation: SDE_TERMS_OF(real, suffix) defines the functions
+ * below, suffixed by 'suffix'. It is expanded for double (no suffix)
+ * and for float (suffix _f, see PRECISION), so that both precisions
+ * always step the same model. Declare positions and local values as
+ * 'real'.
+ *
+ * The terms are inlined in the integration schemes (see
+ * SCHEME_KERNEL): keep them short, they are called at every step.
+ *
+ * deterministic_term: deterministic term of the SDE, see above.
+ *   Default: the opposite of the position (Ornstein-Uhlenbeck
+ *   process, see REFERENCE).
+ *
+ * stochastic_term: stochastic term of the SDE, see above.
+ *   Default: 1.0.
+ *
+ * stochastic_term_derivative: derivative of the stochastic term
+ *   w.r.t. the position (second argument), used by the Milstein
+ *   scheme only (see SCHEME). Default: central finite difference of
+ *   stochastic_term; replace it by the exact derivative when it is
+ *   known.
+ */
+#define SDE_TERMS_OF(real, suffix)					\
+  real									\
+  deterministic_term##suffix(double time, real pos)			\
+  {									\
+    dummy(time);							\
+    return -pos;							\
+  }									\
+									\
+  real									\
+  stochastic_term##suffix(double time, real pos)			\
+  {									\
+    dummy(time);							\
+    dummy(pos);								\
+    return 1.0;								\
+  }									\
+									\
+  real									\
+  stochastic_term_derivative##suffix(double time, real pos)		\
+  {									\
+    /* Cube root of the machine epsilon, scaled by the position. */	\
+    const real h = (real)(sizeof(real) == sizeof(float)		\
+			  ? 4.9215667e-03f : 6.0554544523933395e-06)	\
+      * (real)fmax(1.0, fabs(pos));					\
+    const real up = pos + h, down = pos - h;				\
+									\
+    return (stochastic_term##suffix(time, up)				\
+	    - stochastic_term##suffix(time, down)) / (up - down);	\
+  }
+
+SDE_TERMS_OF(double, )
+SDE_TERMS_OF(float, _f)
+
+
+/*
+ * Batched deterministic and stochastic terms, in both precisions:
+ * the functions above, evaluated for 'paths' paths at once (see
+ * euler_maruyama_batch). They are derived from SDE_TERMS_OF, so there
+ * is nothing to edit here.
+ */
+BATCH_FUNC_OF(deterministic_term_batch, double, deterministic_term)
+BATCH_FUNC_OF(stochastic_term_batch, double, stochastic_term)
+BATCH_FUNC_OF(deterministic_term_batch_f, float, deterministic_term_f)
+BATCH_FUNC_OF(stochastic_term_batch_f, float, stochastic_term_f)
+
+
+/*
+ * Integration scheme.
+ *
+ * SCHEME_EULER (Euler-Maruyama) has strong order 1/2; SCHEME_MILSTEIN
+ * (needs stochastic_term_derivative) and SCHEME_RUNGE_KUTTA
+ * (derivative-free) have strong order 1, hence reach the same error
+ * with far fewer steps when the noise is multiplicative. For additive
+ * noise, the three schemes coincide.
+ *
+ * SCHEME_ADAPTIVE takes Milstein steps of STEP_PRECISION, halved down
+ * to BROWNIAN_PRECISION where one step and two half steps differ by
+ * more than ADAPTIVE_TOLERANCE; values inside a step are taken from
+ * the Brownian motion at BROWNIAN_PRECISION, even if COMPARE is not
+ * defined. STEP_PRECISION must be 2^k BROWNIAN_PRECISION. The output
+ * remains on the grid of STEP_PRECISION. In the multilevel mode, it
+ * is the Milstein scheme.
+ *
+ * Available options are: SCHEME_EULER, SCHEME_MILSTEIN,
+ * SCHEME_RUNGE_KUTTA, SCHEME_ADAPTIVE.
+ *
+ * Default value: SCHEME_EULER
+ */
+scheme_kind SCHEME = SCHEME_EULER;
+
+
+/*
+ * Local error tolerance of SCHEME_ADAPTIVE (absolute, per step).
  *
- * Default: function returning second positional argument.
+ * Default value: 1e-4
  */
-double
-deterministic_term(double time, double pos)
-{
-  dummy(time);
-  return pos;
-} /* end of deterministic_term function */
+#define ADAPTIVE_TOLERANCE 1e-4
+
+
+/*
+ * Precision of the approximation.
+ *
+ * PRECISION_SINGLE steps the approximation in single precision
+ * (float): the Brownian motion over a step and the approximation are
+ * rounded to float, and the float expansion of SDE_TERMS_OF is used.
+ * The reference process and the estimators stay in double (the
+ * estimators are compensated, see statistics.h), so that the errors
+ * estimated include the rounding of the approximation; for usual
+ * steps, it is far below the discretization error ('bench.exe'
+ * compares both precisions).
+ *
+ * A scalar step costs the same in float and in double, so this mode
+ * measures the effect of rounding on a model, e.g. before porting it
+ * to float hardware. Float pays where paths advance in lockstep over
+ * vector lanes: euler_maruyama_batch_f steps twice as many paths per
+ * vector as euler_maruyama_batch ('bench.exe' times both).
+ *
+ * PRECISION_SINGLE needs STATISTICS, without quasi-Monte Carlo,
+ * sweeps, the multilevel mode nor systems (see DIMENSION).
+ *
+ * Available options are: PRECISION_DOUBLE, PRECISION_SINGLE.
+ *
+ * Default value: PRECISION_DOUBLE
+ */
+precision_kind PRECISION = PRECISION_DOUBLE;
 
 
 /*
- * Stochastic term of the SDE. See above for more details.
+ * Functional of the solution at time T.
+ *
+ * The multilevel Monte Carlo mode (option '--mlmc EPSILON') estimates
+ * E[f(X_T)], f being this function.
  *
- * Default: function returning 1.0.
+ * Default: identity.
  */
 double
-stochastic_term(double time, double pos)
+mlmc_functional(double pos)
 {
-  dummy(time);
-  dummy(pos);
-  return 1.0;
-} /* end of stochastic_term function */
+  return pos;
+} /* end of mlmc_functional function */
 
 
 /*
@@ -158,6 +334,91 @@ initial_condition(void)
 } /* end of initial_condition function */
 
 
+/*
+ * Systems of SDE.
+ *
+ * If DIMENSION is greater than 1, the d-dimensional system
+ *
+ *   dX_t = a(t, X_t) dt + B(t, X_t) dW_t
+ *
+ * is approximated instead of the SDE above, d being DIMENSION, a
+ * deterministic_vector, B the d x m matrix stochastic_vector and W
+ * FACTORS (m) Brownian motions, correlated by CORRELATION. Every
+ * trajectory file then holds d columns for the approximation (and d
+ * more for the reference process if COMPARE is defined).
+ *
+ * Systems are approximated by the Euler-Maruyama scheme, without
+ * STATISTICS, sweeps, the multilevel mode, quasi-Monte Carlo nor
+ * Brownian bridges.
+ *
+ * Default value: 1 (the SDE above), 1
+ */
+#define DIMENSION 1
+#define FACTORS 1
+
+
+/*
+ * Correlation matrix of the increments of the m Brownian motions
+ * (m x m values, row by row). It must be positive definite.
+ *
+ * Default value: identity
+ */
+const double CORRELATION[FACTORS * FACTORS] = {1.0};
+
+
+/*
+ * Drift (d values), diffusion matrix (d x m values, row by row) and
+ * initial condition of the system. See above for more details.
+ *
+ * Default: every component follows the SDE above, driven by its own
+ * Brownian motion (FACTORS must be equal to DIMENSION).
+ */
+void
+deterministic_vector(double time, const double *pos, double *out)
+{
+  for (unsigned int k = 0; k < DIMENSION; ++k)
+  {
+    out[k] = deterministic_term(time, pos[k]);
+  }
+} /* end of deterministic_vector function */
+
+
+void
+stochastic_vector(double time, const double *pos, double *out)
+{
+  for (unsigned int k = 0; k < DIMENSION; ++k)
+  {
+    for (unsigned int f = 0; f < FACTORS; ++f)
+    {
+      out[k * FACTORS + f] = k == f ? stochastic_term(time, pos[k]) : 0;
+    }
+  }
+} /* end of stochastic_vector function */
+
+
+void
+initial_vector(double *init)
+{
+  for (unsigned int k = 0; k < DIMENSION; ++k)
+  {
+    init[k] = initial_condition();
+  }
+} /* end of initial_vector function */
+
+
+/*
+ * Layout of the states of a batch of VECTOR_BATCH paths, computed in
+ * lockstep (see vector_layout). Results do not depend on these
+ * values.
+ *
+ * Available options are: LAYOUT_INTERLEAVED, LAYOUT_SOA.
+ *
+ * Default value: LAYOUT_SOA, 16
+ */
+vector_layout LAYOUT = LAYOUT_SOA;
+#define VECTOR_BATCH 16
+
+
 /*
  * Set the time bound.
  *
@@ -190,7 +451,8 @@ initial_condition(void)
  *
  * Value cannot be greater than STEP_PRECISION.
  *
- * If COMPARE is not defined, this macro has no effect.
+ * If COMPARE is not defined, this macro has no effect, unless SCHEME
+ * is SCHEME_ADAPTIVE.
  *
  * Default value: STEP_PRECISION
  */
@@ -212,6 +474,78 @@ initial_condition(void)
 //#define USE_TIME
 
 
+/*
+ * Pseudo-random number generator.
+ *
+ * Every trajectory draws its random numbers from its own stream, so
+ * that trajectory i is the same whatever the number of trajectories
+ * computed before it.
+ *
+ * Available options are: PRNG_PHILOX (counter-based, streams can be
+ * positioned anywhere in constant time), PRNG_XOSHIRO (xoshiro256**,
+ * streams are seeded by hashing).
+ *
+ * Default value: PRNG_PHILOX
+ */
+prng_kind GENERATOR = PRNG_PHILOX;
+
+
+/*
+ * Construction of the Brownian motion.
+ *
+ * BROWNIAN_FORWARD sums independent increments at the Brownian
+ * precision. BROWNIAN_BRIDGE (Levy construction) samples the Brownian
+ * motion at the step precision first, then refines it by Brownian
+ * bridges down to the Brownian precision; a path is then the same at
+ * every precision it is refined to. With BROWNIAN_BRIDGE:
+ *
+ *   - the grid of the Brownian precision must be a dyadic refinement
+ *     of the grid of the step precision (of the largest step of a
+ *     sweep), i.e. STEP_PRECISION = 2^k BROWNIAN_PRECISION over the
+ *     same time bound;
+ *   - the multilevel mode needs TIME_BOUND to be a multiple of the
+ *     step precision;
+ *   - the multilevel mode refines paths one coarse step at a time,
+ *     so that fine levels are never stored whole.
+ *
+ * BROWNIAN_BRIDGE is much faster with PRNG_PHILOX.
+ *
+ * Available options are: BROWNIAN_FORWARD, BROWNIAN_BRIDGE.
+ *
+ * Default value: BROWNIAN_FORWARD
+ */
+brownian_method BROWNIAN = BROWNIAN_FORWARD;
+
+
+/*
+ * Quasi-Monte Carlo (randomized).
+ *
+ * If positive, Brownian motions are built by Brownian bridges over
+ * [0, TIME_BOUND] (whatever BROWNIAN) from the points of a scrambled
+ * Sobol' sequence, mapped to normal numbers by the inverse normal
+ * cumulative distribution function: W(T) takes the first coordinate,
+ * W(T/2) the second, and so on. TIME_BOUND must be 2^k times the
+ * step precision and the Brownian precision.
+ *
+ * Trajectories are split in QMC_REPLICATES independent scramblings
+ * of the sequence ("replicates"), trajectory i being the point i /
+ * QMC_REPLICATES of the replicate i % QMC_REPLICATES. If STATISTICS
+ * is defined, quantities at time T are estimated by the mean of the
+ * replicates' means, and the lines of 'summary.csv' describe these
+ * means (count is the number of replicates): the confidence
+ * intervals remain valid although points are not independent. The
+ * intervals of 'profile.csv' treat points as independent, hence are
+ * wider than needed.
+ *
+ * For smooth functionals of X_T, the error decreases nearly as
+ * 1/ITER instead of 1/sqrt(ITER). Has no effect on sweeps and on the
+ * multilevel mode.
+ *
+ * Default value: 0 (pseudo-random numbers)
+ */
+#define QMC_REPLICATES 0
+
+
 /*
  * Pseduo-random number generator seed.
  *
@@ -235,6 +569,60 @@ initial_condition(void)
 #define ITER 1
 
 
+/*
+ * Number of threads.
+ *
+ * Trajectories are independent, hence they are computed in parallel
+ * by THREADS threads. Results do not depend on this value.
+ *
+ * Setting it to 0 uses every available core.
+ *
+ * Default value: 0
+ */
+#define THREADS 0
+
+
+/*
+ * Writer threads.
+ *
+ * When WRITERS > 0, trajectories are computed by THREADS threads,
+ * which format them, and stored in files by WRITERS other threads:
+ * computation goes on while files are written. Trajectories are
+ * written in order, and at most OUTPUT_QUEUE trajectories per
+ * computing thread wait to be written, which bounds memory. Files do
+ * not depend on these values.
+ *
+ * Setting WRITERS to 0 stores every trajectory from the thread which
+ * computed it. Systems (see DIMENSION) are always stored this way.
+ *
+ * Default values: 1, 4
+ */
+#define WRITERS 1
+#define OUTPUT_QUEUE 4
+
+
+/*
+ * Checkpoints.
+ *
+ * Every CHECKPOINT trajectories, once their files are complete, the
+ * progress of the run is stored in FILEPATH/checkpoint.bin (with the
+ * estimators computed so far if STATISTICS is defined). A run which
+ * is interrupted is then resumed from its last checkpoint with
+ * '--resume', with the same parameters, instead of starting over:
+ * files and estimators are the ones of an uninterrupted run. The
+ * seed is taken from the checkpoint, even with USE_TIME. The
+ * checkpoint is removed once the run is complete.
+ *
+ * With STATISTICS, checkpoints are stored between blocks of
+ * trajectories, i.e. at least every CHECKPOINT trajectories.
+ * Checkpoints are not available for sweeps nor multilevel Monte
+ * Carlo. Setting CHECKPOINT to 0 disables them.
+ *
+ * Default value: 0
+ */
+#define CHECKPOINT 0
+
+
 /*
  * Printed precision
  *
@@ -259,53 +647,229 @@ initial_condition(void)
 #define COMPARE
 
 
+/*
+ * Streaming statistics.
+ *
+ * When defined, trajectories are not stored anymore. Instead, the
+ * mean, the variance and a confidence interval of the approximation
+ * at time T are computed along the simulation, as well as the strong
+ * error E|X_T - Y_T| and the weak error E[X_T - Y_T] if COMPARE is
+ * defined (Y being the reference process). The results are stored in
+ * 'summary.csv', and the mean (absolute error if COMPARE is defined)
+ * at every step of the approximation in 'profile.csv'.
+ *
+ * Each path is computed in a single pass: every Brownian increment
+ * feeds the reference process and the approximation, then is
+ * forgotten, so that memory does not grow with the Brownian
+ * precision.
+ *
+ * Default value: commented
+ */
+/* #define STATISTICS */
+
+
+/*
+ * Level of the confidence intervals computed when STATISTICS is
+ * defined.
+ *
+ * Default value: 0.95
+ */
+#define CONFIDENCE 0.95
+
+
+/*
+ * Variance reduction.
+ *
+ * The estimator of E[f(X_T)], f being mlmc_functional, is improved
+ * by (STATISTICS only, without quasi-Monte Carlo, sweeps, the
+ * multilevel mode nor systems):
+ *
+ *   - ANTITHETIC: trajectories go by pairs, the second one driven by
+ *     the opposite Brownian motion of the first one; a sample is the
+ *     mean of f(X_T) over the pair. ITER must be even.
+ *   - STRATA: if positive, W(T) is drawn in STRATA equally likely
+ *     strata, trajectory i in the stratum i % STRATA, and the
+ *     estimator is the mean of the strata's means. Brownian motions
+ *     are then built by Brownian bridges over [0, TIME_BOUND], which
+ *     must be 2^k times the step precision and the Brownian
+ *     precision. Not available with ANTITHETIC.
+ *   - CONTROL_VARIATE (see below).
+ *
+ * Lines 'functional' (every trajectory) and 'functional_reduced' of
+ * 'summary.csv' give the estimator without and with variance
+ * reduction; the ratio of their variances is the gain in effective
+ * sample size, printed at the end of the run.
+ *
+ * Default values: commented, 0
+ */
+/* #define ANTITHETIC */
+#define STRATA 0
+
+
+/*
+ * Instrumentation.
+ *
+ * When defined, every thread measures the time spent in each stage of
+ * the paths it computes (random numbers, scheme, interpolation,
+ * reference process, output, writing by writer threads, or the whole
+ * single pass if STATISTICS is defined), and counts its allocations
+ * and the bytes it writes. The counters are merged and printed at
+ * the end of the run, and stored in 'metrics.json' if INSTRUMENT_JSON
+ * is defined. Multilevel Monte Carlo is not instrumented.
+ *
+ * INSTRUMENT_TRACE is the number of stages per thread also stored as
+ * trace events in 'trace.json' (chrome://tracing, Perfetto), 0 for
+ * none.
+ *
+ * When INSTRUMENT is not defined, instrumentation is compiled out.
+ *
+ * Default value: commented
+ */
+/* #define INSTRUMENT */
+#define INSTRUMENT_JSON
+#define INSTRUMENT_TRACE 0
+
+
+/*
+ * Reference solution.
+ *
+ * REFERENCE_LINEAR computes the closed-form solution of the linear
+ * SDE REFERENCE_SDE = {a, b, c, d},
+ *
+ *   dX_t = (a X_t + b) dt + (c X_t + d) dW_t,
+ *
+ * from initial_condition(), without any transcendental call per step
+ * for additive noise (see reference.h). Its noise must be additive
+ * (c = 0) or multiplicative (b = d = 0). REFERENCE_CUSTOM computes
+ * the reference process defined below, for any other solution.
+ * Systems (see DIMENSION) always use the reference process below.
+ *
+ * Has no effect if COMPARE is not defined.
+ *
+ * Available options are: REFERENCE_LINEAR, REFERENCE_CUSTOM.
+ *
+ * Default values: REFERENCE_LINEAR, {-1.0, 0.0, 0.0, 1.0}
+ * (Ornstein-Uhlenbeck process, solution of the default SDE)
+ */
+reference_kind REFERENCE = REFERENCE_LINEAR;
+const linear_sde REFERENCE_SDE = {-1.0, 0.0, 0.0, 1.0};
+
+
 /*
  * Reference process.
  *
  * See above for more details. Has no effect if COMPARE is not
- * defined.
+ * defined, or if REFERENCE is not REFERENCE_CUSTOM (systems
+ * excepted).
  *
- * If COMPARE is defined, this function must be defined. Results shall
- * be stored in a separate file with the 'reference_' prefix.
+ * If COMPARE is defined, these functions must be defined. The
+ * reference process is computed one Brownian increment at a time,
+ * from a state of REFERENCE_STATE values, so that the Brownian motion
+ * never needs to be stored:
  *
- * If COMPARE is not defined, this function has no effect.
+ *   - reference_start initializes the state at time 0;
+ *   - reference_update adds the increment 'd_brownian' of the
+ *     Brownian motion over [time, time + brownian_prec];
+ *   - reference_value returns the reference process at 'time', the
+ *     state holding every increment before 'time'.
  *
- * Default value: Ornstein-Uhlenbeck process.
+ * If COMPARE is not defined, these functions have no effect.
+ *
+ * Default value: Ornstein-Uhlenbeck process,
+ *   Y_t = e^{-t} (Y_0 + \int_0^t e^s dW_s),
+ * the state being the Ito integral.
  */
-double *
-reference_process(double *brownian_motion)
+#define REFERENCE_STATE 1
+
+void
+reference_start(double *state)
 {
-  const unsigned int steps = floor(TIME_BOUND / BROWNIAN_PRECISION) + 1;
-  
-  double *path = malloc(steps * sizeof *path);
-  
-  double *integral = deterministic_ito_integral(BROWNIAN_PRECISION, TIME_BOUND,
-						brownian_motion, &__custom_exp);
-
-  if (path != NULL)
+  state[0] = 0; // Integrating over [0, 0] returns 0.
+} /* end of reference_start function */
+
+
+void
+reference_update(double *state, double time, double d_brownian)
+{
+  state[0] += __custom_exp(time) * d_brownian;
+} /* end of reference_update function */
+
+
+double
+reference_value(const double *state, double time)
+{
+  return exp(-1.0 * time) * (initial_condition() + state[0]);
+} /* end of reference_value function */
+
+
+/*
+ * Reference process of a system (see DIMENSION), from a state of
+ * REFERENCE_VECTOR_STATE values: reference_vector_update receives
+ * the m increments of the Brownian motions, reference_vector_value
+ * stores the d values of the process in 'out'.
+ *
+ * Default: every component is the reference process above, driven
+ * by its own Brownian motion.
+ */
+#define REFERENCE_VECTOR_STATE (DIMENSION * REFERENCE_STATE)
+
+void
+reference_vector_start(double *state)
+{
+  for (unsigned int k = 0; k < DIMENSION; ++k)
   {
-    for(unsigned int j = 0; j < steps; ++j)
-    {
-      path[j] = exp(-1.0 * j * BROWNIAN_PRECISION);
-      path[j] *= initial_condition() + integral[j];
-    }
+    reference_start(state + k * REFERENCE_STATE);
+  }
+} /* end of reference_vector_start function */
+
+
+void
+reference_vector_update(double *state, double time,
+			const double *d_brownian)
+{
+  for (unsigned int k = 0; k < DIMENSION; ++k)
+  {
+    reference_update(state + k * REFERENCE_STATE, time, d_brownian[k]);
   }
+} /* end of reference_vector_update function */
 
-  /* free(integral); */
 
-  /* if (path != NULL) */
-  /* { */
-  /*   path[0] = initial_condition(); */
-    
-  /*   for (unsigned int j = 1; j < steps; ++j) */
-  /*   { */
-  /*     path[j] = path[j - 1] * exp((brownian_motion[j] - brownian_motion[j - 1])); */
-  /*   } */
-  /* } */
+void
+reference_vector_value(const double *state, double time, double *out)
+{
+  for (unsigned int k = 0; k < DIMENSION; ++k)
+  {
+    out[k] = reference_value(state + k * REFERENCE_STATE, time);
+  }
+} /* end of reference_vector_value function */
 
-  
-  return path;
-}
+
+/*
+ * Control variate.
+ *
+ * When defined (with STATISTICS and COMPARE), Z = control_variate(Y_T)
+ * is a control variate of f(X_T), Y being the reference process, and
+ * control_mean(T) must return E[Z]. The estimator of E[f(X_T)] is
+ * then mean(f(X_T)) - beta (mean(Z) - E[Z]), beta being estimated
+ * along the run so as to minimize its variance.
+ *
+ * Default: Z = Y_T, the mean of which is known for REFERENCE_SDE (if
+ * initial_condition() is deterministic).
+ */
+/* #define CONTROL_VARIATE */
+
+double
+control_variate(double reference)
+{
+  return reference;
+} /* end of control_variate function */
+
+
+double
+control_mean(double time)
+{
+  return reference_linear_mean(&REFERENCE_SDE, initial_condition(), time);
+} /* end of control_mean function */
 
 
 #endif /* _CONFIG_H */
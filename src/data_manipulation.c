@@ -13,6 +13,8 @@
  * License: see LICENSE file.
  */
 
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,20 +24,17 @@
 
 
 static char *
-format_string_from_sds(sds *atom)
+format_string_from_sds(sds *atom, char *format_string)
 {
-  /* MUST BE FREE'D ! 
-   *
-   * Returns the format string used to print the sds content. 
+  /* 
+   * Returns the format string used to print the sds content, stored
+   * in 'format_string' (at least 8 bytes), or NULL.
    *
    * The format string is used by printf family's functions, see the
    * man page ('man 3 printf' on Linux) for more info.
    */
   
   generic_t atom_type = atom->type;
-  char *format_string = malloc(6 * sizeof *format_string);
-  
-  char prec[4];
   data_t data_type;
 
   if (atom_type == UNIT)
@@ -62,10 +61,7 @@ format_string_from_sds(sds *atom)
     break;
 
   case DOUBLE:
-    snprintf(prec, 4, "%d", atom->precision);
-    strcpy(format_string, "%.");
-    strcat(format_string, prec);
-    strcat(format_string, "f");
+    snprintf(format_string, 8, "%%.%uf", atom->precision % 1000);
     break;
 
   default:
@@ -85,10 +81,11 @@ print_sds_in_csv(FILE *output, csv_format format, sds *atom)
    */
   if (output != NULL)
   {
-    char *fs_sds = format_string_from_sds(atom);
+    char fs_buffer[8];
+    char *fs_sds = format_string_from_sds(atom, fs_buffer);
     generic_t atom_type = atom->type;
     
-    char sep[3];
+    char sep[3] = "";
 
     if (atom_type != UNIT && atom_type != ARRAY)
     {
@@ -134,9 +131,8 @@ print_sds_in_csv(FILE *output, csv_format format, sds *atom)
 	break;
       } /* end of switch-condition */
     
-      fprintf(output, sep);
+      fputs(sep, output);
 
-      free(fs_sds);
       return fprintf(output, "\n");
     } /* end of if-condition */
 
@@ -150,7 +146,7 @@ print_sds_in_csv(FILE *output, csv_format format, sds *atom)
 	for (unsigned int j = 0; j < (atom->array).size; ++j)
 	{
 	  fprintf(output, fs_sds, (atom->array)._int[j]);
-	  fprintf(output, sep);
+	  fputs(sep, output);
 	}
 	break;
 	
@@ -158,7 +154,7 @@ print_sds_in_csv(FILE *output, csv_format format, sds *atom)
 	for (unsigned int j = 0; j < (atom->array).size; ++j)
 	{
 	  fprintf(output, fs_sds, (atom->array)._uint[j]);
-	  fprintf(output, sep);
+	  fputs(sep, output);
 	}
 	break;
 
@@ -166,18 +162,339 @@ print_sds_in_csv(FILE *output, csv_format format, sds *atom)
 	for (unsigned int j = 0; j < (atom->array).size; ++j)
 	{
 	  fprintf(output, fs_sds, (atom->array)._double[j]);
-	  fprintf(output, sep);
+	  fputs(sep, output);
 	}
 	break;
       } /* end of switch-condition */
 
-      free(fs_sds);
       return fprintf(output, "\n");
     } /* end of if-condition */
 
-    free(fs_sds);
     return SDS_NULL_FORMAT_STRING;
   } /* end of if-condition */
 
   return NULL_FILE_DESCRIPTOR;
 } /* end of store_in_csv function */
+
+
+/*
+ * Buffered CSV writer.
+ *
+ * Rows are serialized in a large buffer, flushed with a single fwrite
+ * when full. Numbers are formatted by format_fixed, which produces
+ * the same bytes as printf's "%.<precision>f" without going through
+ * printf.
+ */
+
+#define CSV_BUFFER_SIZE 65536
+#define CSV_MAX_PRECISION 17
+/* Worst case of printf("%.17f") for a finite double. */
+#define CSV_MAX_FIELD 330
+
+static const double powers_of_ten[CSV_MAX_PRECISION + 1] = {1e0, 1e1, 1e2,
+  1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+  1e16, 1e17};
+
+
+static void
+two_product(double a, double b, double *product, double *error)
+{
+  /*
+   * Exact product a * b = product + error (Dekker, Veltkamp's
+   * splitting). Exact as long as nothing overflows.
+   */
+  
+  const double split = 134217729.0; /* 2^27 + 1 */
+  double t, a_hi, a_lo, b_hi, b_lo;
+
+  *product = a * b;
+
+  t = split * a;
+  a_hi = t - (t - a);
+  a_lo = a - a_hi;
+  t = split * b;
+  b_hi = t - (t - b);
+  b_lo = b - b_hi;
+
+  *error = ((a_hi * b_hi - *product) + a_hi * b_lo + a_lo * b_hi)
+    + a_lo * b_lo;
+} /* end of two_product function */
+
+
+static size_t
+format_fixed(char *dest, double value, unsigned int precision)
+{
+  /*
+   * Write 'value' with 'precision' digits after the decimal point in
+   * 'dest', exactly as printf("%.*f", precision, value) would (round
+   * half to even on the exact binary value), and return the number of
+   * characters written (no terminating null byte).
+   *
+   * Let x = |value| 10^precision = n + f, n integer. The product is
+   * computed exactly as scaled + error, so that the rounding of x is
+   * decided exactly: f is a multiple of ulp(scaled) <= 1/2 and
+   * |error| <= ulp(scaled) / 2, hence error only matters on a tie.
+   * Values too large for this argument go through snprintf.
+   */
+
+  char digits[24];
+  double scaled, error, integral, fraction;
+  uint64_t number, divisor;
+  size_t length = 0;
+  unsigned int count = 0;
+
+  if (!isfinite(value) || precision > CSV_MAX_PRECISION
+      || fabs(value) >= 0x1.0p52 / powers_of_ten[precision])
+  {
+    return snprintf(dest, CSV_MAX_FIELD, "%.*f", (int)precision, value);
+  }
+
+  two_product(fabs(value), powers_of_ten[precision], &scaled, &error);
+  if (scaled >= 0x1.0p52)
+  {
+    return snprintf(dest, CSV_MAX_FIELD, "%.*f", (int)precision, value);
+  }
+
+  integral = floor(scaled);
+  fraction = scaled - integral;
+  number = (uint64_t)integral;
+
+  if (fraction > 0.5 || (fraction == 0.5
+			 && (error > 0 || (error == 0 && number % 2 == 1))))
+  {
+    number++;
+  }
+
+  if (signbit(value))
+  {
+    dest[length++] = '-';
+  }
+
+  divisor = (uint64_t)powers_of_ten[precision];
+
+  /* Integer part. */
+  uint64_t integer_part = number / divisor;
+  do {
+    digits[count++] = '0' + integer_part % 10;
+    integer_part /= 10;
+  } while (integer_part > 0);
+  while (count > 0)
+  {
+    dest[length++] = digits[--count];
+  }
+
+  /* Fractional part, zero-padded. */
+  if (precision > 0)
+  {
+    uint64_t fractional_part = number % divisor;
+
+    dest[length++] = '.';
+    for (unsigned int k = precision; k > 0; --k)
+    {
+      dest[length + k - 1] = '0' + fractional_part % 10;
+      fractional_part /= 10;
+    }
+    length += precision;
+  }
+
+  return length;
+} /* end of format_fixed function */
+
+
+csv_writer *
+init_csv_writer(csv_format format, unsigned int precision)
+{
+  /*
+   * MUST BE FREE'D with free_csv_writer!
+   *
+   * The separator and the number format are set once for every file
+   * written through the writer.
+   */
+  
+  csv_writer *writer = malloc(sizeof *writer);
+
+  if (writer == NULL)
+  {
+    return NULL;
+  }
+
+  writer->buffer = malloc(CSV_BUFFER_SIZE);
+  if (writer->buffer == NULL)
+  {
+    free(writer);
+    return NULL;
+  }
+
+  switch (format)
+  {
+  case SINGLE_SPACE:
+    strcpy(writer->sep, " ");
+    break;
+
+  case DOUBLE_SPACE:
+    strcpy(writer->sep, "  ");
+    break;
+
+  case SEMICOLON:
+    strcpy(writer->sep, ";");
+    break;
+
+  case COMMA:
+  default:
+    strcpy(writer->sep, ",");
+    break;
+  } /* end of switch-condition */
+
+  writer->sep_length = strlen(writer->sep);
+  writer->precision = precision;
+  writer->output = NULL;
+  writer->memory = NULL;
+  writer->used = 0;
+  writer->written = 0;
+
+  return writer;
+} /* end of init_csv_writer function */
+
+
+void
+free_csv_writer(csv_writer *writer)
+{
+  if (writer != NULL)
+  {
+    free(writer->buffer);
+    free(writer);
+  }
+} /* end of free_csv_writer function */
+
+
+void
+csv_begin(csv_writer *writer, FILE *output)
+{
+  /* Rows are written in 'output' until csv_end is called. */
+  
+  writer->output = output;
+  writer->memory = NULL;
+  writer->used = 0;
+} /* end of csv_begin function */
+
+
+void
+csv_begin_buffer(csv_writer *writer, csv_buffer *memory)
+{
+  /*
+   * Rows are written in 'memory', emptied first, until csv_end is
+   * called. 'memory' only grows, hence it is reused without any
+   * allocation once large enough.
+   */
+
+  writer->output = NULL;
+  writer->memory = memory;
+  writer->used = 0;
+  memory->size = 0;
+} /* end of csv_begin_buffer function */
+
+
+void
+free_csv_buffer(csv_buffer *memory)
+{
+  free(memory->data);
+  memory->data = NULL;
+  memory->size = memory->capacity = 0;
+} /* end of free_csv_buffer function */
+
+
+static int
+csv_flush(csv_writer *writer)
+{
+  size_t count = writer->used;
+
+  csv_buffer *memory = writer->memory;
+  size_t capacity;
+  char *data;
+
+  writer->used = 0;
+  writer->written += count;
+
+  if (memory != NULL)
+  {
+    capacity = memory->capacity > 0 ? memory->capacity : CSV_BUFFER_SIZE;
+    while (capacity - memory->size < count)
+    {
+      capacity *= 2;
+    }
+    if (capacity > memory->capacity)
+    {
+      data = realloc(memory->data, capacity);
+      if (data == NULL)
+      {
+	return NULL_FILE_DESCRIPTOR;
+      }
+      memory->data = data;
+      memory->capacity = capacity;
+    }
+    
+    memcpy(memory->data + memory->size, writer->buffer, count);
+    memory->size += count;
+    return 0;
+  }
+  
+  if (fwrite(writer->buffer, 1, count, writer->output) != count)
+  {
+    return NULL_FILE_DESCRIPTOR;
+  }
+
+  return 0;
+} /* end of csv_flush function */
+
+
+int
+csv_write_row(csv_writer *writer, const double *values, unsigned int size)
+{
+  /*
+   * Append one row, i.e. every value followed by the separator, then
+   * a new line (the layout of print_sds_in_csv).
+   */
+
+  const size_t field = CSV_MAX_FIELD + writer->sep_length;
+  
+  if (writer->output == NULL && writer->memory == NULL)
+  {
+    return NULL_FILE_DESCRIPTOR;
+  }
+  
+  for (unsigned int j = 0; j < size; ++j)
+  {
+    if (CSV_BUFFER_SIZE - writer->used < field
+	&& csv_flush(writer) != 0)
+    {
+      return NULL_FILE_DESCRIPTOR;
+    }
+
+    writer->used += format_fixed(writer->buffer + writer->used, values[j],
+				 writer->precision);
+    memcpy(writer->buffer + writer->used, writer->sep, writer->sep_length);
+    writer->used += writer->sep_length;
+  } /* end of for-loop */
+
+  if (writer->used == CSV_BUFFER_SIZE && csv_flush(writer) != 0)
+  {
+    return NULL_FILE_DESCRIPTOR;
+  }
+  writer->buffer[writer->used++] = '\n';
+
+  return 0;
+} /* end of csv_write_row function */
+
+
+int
+csv_end(csv_writer *writer)
+{
+  /* Flush the rows still in the buffer. Does not close the file. */
+  
+  int status = csv_flush(writer);
+
+  writer->output = NULL;
+  writer->memory = NULL;
+
+  return status;
+} /* end of csv_end function */
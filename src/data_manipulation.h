@@ -21,9 +21,65 @@
 
 typedef enum {NULL_FILE_DESCRIPTOR=-512} data_state;
 typedef enum {SINGLE_SPACE=1, DOUBLE_SPACE, COMMA, SEMICOLON} csv_format;
+typedef enum {CSV=1, BINARY, DATASET} output_format;
+typedef enum {ROWS_ALL=1, ROWS_TERMINAL, ROWS_EVERY, ROWS_TIMES, ROWS_SUMMARY}
+  row_policy;
+
+struct csv_buffer
+{
+  /*
+   * Growable text, see csv_begin_buffer. Zeroed is empty; MUST BE
+   * FREE'D with free_csv_buffer.
+   */
+
+  char *data;
+  size_t size;
+  size_t capacity;
+};
+
+struct csv_writer
+{
+  /*
+   * Buffered CSV writer, see init_csv_writer. Do not write in members
+   * manually.
+   */
+  
+  FILE *output;
+  struct csv_buffer *memory;
+  char *buffer;
+  size_t used;
+  size_t written; /* bytes written since the creation of the writer */
+  char sep[3];
+  size_t sep_length;
+  unsigned int precision;
+};
+
+typedef struct csv_buffer csv_buffer;
+typedef struct csv_writer csv_writer;
 
 int
 print_sds_in_csv(FILE *output, csv_format format, sds *atom);
 
+csv_writer *
+init_csv_writer(csv_format format, unsigned int precision);
+
+void
+free_csv_writer(csv_writer *writer);
+
+void
+csv_begin(csv_writer *writer, FILE *output);
+
+void
+csv_begin_buffer(csv_writer *writer, csv_buffer *memory);
+
+void
+free_csv_buffer(csv_buffer *memory);
+
+int
+csv_write_row(csv_writer *writer, const double *values, unsigned int size);
+
+int
+csv_end(csv_writer *writer);
+
 
 #endif /* DATA_MANIPULATION_H */
@@ -0,0 +1,295 @@
+/*
+ * Filename: metrics.c
+ *
+ * Summary: implements the instrumentation of the computation of
+ * paths.
+ *
+ * Every thread owns its counters, hence nothing is shared nor locked
+ * while computing: counters are merged once the run is over. Stages
+ * are timed in ticks (see metrics_ticks), converted to seconds from
+ * the wall-clock time elapsed over the run.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "metrics.h"
+
+
+static const char *const stage_names[] = {
+  [METRIC_RNG] = "rng",
+  [METRIC_SCHEME] = "scheme",
+  [METRIC_INTERPOLATION] = "interpolation",
+  [METRIC_REFERENCE] = "reference",
+  [METRIC_OUTPUT] = "output",
+  [METRIC_WRITE] = "write",
+  [METRIC_FUSED] = "fused"};
+
+
+int
+metrics_init(metrics *m, size_t events)
+{
+  /*
+   * Zero the counters of 'm' and allocate room for 'events' trace
+   * events (none if 0). MUST BE FREE'D with metrics_free!
+   *
+   * Returns 0 on success, METRICS_ERR_ALLOC otherwise.
+   */
+
+  memset(m, 0, sizeof *m);
+  if (events == 0)
+  {
+    return 0;
+  }
+
+  m->events = malloc(events * sizeof *m->events);
+  if (m->events == NULL)
+  {
+    return METRICS_ERR_ALLOC;
+  }
+  m->event_capacity = events;
+  m->allocations = 1;
+
+  return 0;
+} /* end of metrics_init function */
+
+
+void
+metrics_free(metrics *m)
+{
+  free(m->events);
+  m->events = NULL;
+  m->event_count = m->event_capacity = 0;
+} /* end of metrics_free function */
+
+
+void
+metrics_stage(metrics *m, metric_stage stage, uint64_t start)
+{
+  /*
+   * Account for the stage of the current path started at 'start'
+   * and ending now. Kept as a trace event while there is room.
+   */
+
+  const uint64_t end = metrics_ticks();
+  struct metric_event *event;
+
+  m->ticks[stage] += end - start;
+  m->calls[stage]++;
+
+  if (m->event_count < m->event_capacity)
+  {
+    event = &m->events[m->event_count++];
+    event->start = start;
+    event->end = end;
+    event->path = m->path;
+    event->stage = stage;
+  }
+} /* end of metrics_stage function */
+
+
+void
+metrics_merge(metrics *total, const metrics *m)
+{
+  /* Add the counters of 'm' to 'total' (trace events excepted). */
+
+  for (unsigned int s = 0; s < METRIC_STAGES; ++s)
+  {
+    total->ticks[s] += m->ticks[s];
+    total->calls[s] += m->calls[s];
+  }
+  total->paths += m->paths;
+  total->allocations += m->allocations;
+  total->files += m->files;
+  total->bytes += m->bytes;
+  total->scratch += m->scratch;
+} /* end of metrics_merge function */
+
+
+void
+metrics_clock_now(metrics_clock *clock)
+{
+  struct timespec now;
+
+  clock->ticks = metrics_ticks();
+  timespec_get(&now, TIME_UTC);
+  clock->seconds = now.tv_sec + now.tv_nsec * 1e-9;
+} /* end of metrics_clock_now function */
+
+
+double
+metrics_tick_seconds(const metrics_clock *begin, const metrics_clock *end)
+{
+  /* Duration of a tick between two clock readings. */
+
+  if (end->ticks <= begin->ticks)
+  {
+    return 0.0;
+  }
+
+  return (end->seconds - begin->seconds) / (end->ticks - begin->ticks);
+} /* end of metrics_tick_seconds function */
+
+
+static void
+metrics_total(metrics *total, const metrics *threads, unsigned int size)
+{
+  memset(total, 0, sizeof *total);
+  for (unsigned int t = 0; t < size; ++t)
+  {
+    metrics_merge(total, &threads[t]);
+  }
+} /* end of metrics_total function */
+
+
+void
+metrics_print(FILE *output, const metrics *threads, unsigned int size,
+	      const metrics_clock *begin, const metrics_clock *end)
+{
+  /*
+   * Print the counters of every thread, merged: the time spent in
+   * every stage (summed over threads, and its share of the time
+   * spent in every stage), then the output and the memory.
+   */
+
+  const double tick = metrics_tick_seconds(begin, end);
+  const double wall = end->seconds - begin->seconds;
+  metrics total;
+  uint64_t busy = 0;
+
+  metrics_total(&total, threads, size);
+  for (unsigned int s = 0; s < METRIC_STAGES; ++s)
+  {
+    busy += total.ticks[s];
+  }
+
+  fprintf(output, "Metrics:  %llu paths in %.3f s on %u threads "
+	  "(%.1f paths/s)\n", (unsigned long long)total.paths, wall, size,
+	  wall > 0 ? total.paths / wall : 0.0);
+  fprintf(output, "          %-14s %12s %12s %8s %12s\n", "stage", "calls",
+	  "seconds", "share", "ns/call");
+  for (unsigned int s = 0; s < METRIC_STAGES; ++s)
+  {
+    if (total.calls[s] == 0)
+    {
+      continue;
+    }
+    fprintf(output, "          %-14s %12llu %12.6f %7.2f%% %12.1f\n",
+	    stage_names[s], (unsigned long long)total.calls[s],
+	    total.ticks[s] * tick,
+	    busy > 0 ? 100.0 * total.ticks[s] / busy : 0.0,
+	    total.ticks[s] * tick * 1e9 / total.calls[s]);
+  }
+  fprintf(output, "          %llu bytes in %llu files (%.1f MB/s), "
+	  "%llu allocations, %llu bytes of scratch\n",
+	  (unsigned long long)total.bytes, (unsigned long long)total.files,
+	  wall > 0 ? total.bytes / wall * 1e-6 : 0.0,
+	  (unsigned long long)total.allocations,
+	  (unsigned long long)total.scratch);
+} /* end of metrics_print function */
+
+
+static void
+print_json_counters(FILE *output, const metrics *m, double tick)
+{
+  /* Members of the JSON object of a thread (or of the total). */
+
+  fprintf(output, "\"paths\": %llu, \"allocations\": %llu, "
+	  "\"files\": %llu, \"bytes\": %llu, \"scratch_bytes\": %llu, "
+	  "\"stages\": {", (unsigned long long)m->paths,
+	  (unsigned long long)m->allocations, (unsigned long long)m->files,
+	  (unsigned long long)m->bytes, (unsigned long long)m->scratch);
+  for (unsigned int s = 0; s < METRIC_STAGES; ++s)
+  {
+    fprintf(output, "%s\"%s\": {\"calls\": %llu, \"seconds\": %.9f}",
+	    s > 0 ? ", " : "", stage_names[s],
+	    (unsigned long long)m->calls[s], m->ticks[s] * tick);
+  }
+  fputs("}", output);
+} /* end of print_json_counters function */
+
+
+int
+metrics_write_json(const char *filename, const metrics *threads,
+		   unsigned int size, const metrics_clock *begin,
+		   const metrics_clock *end)
+{
+  /*
+   * Store the counters, merged and per thread, in 'filename' as a
+   * JSON object. Returns 0 on success, METRICS_ERR_OPEN otherwise.
+   */
+
+  const double tick = metrics_tick_seconds(begin, end);
+  FILE *output = fopen(filename, "w");
+  metrics total;
+
+  if (output == NULL)
+  {
+    return METRICS_ERR_OPEN;
+  }
+
+  metrics_total(&total, threads, size);
+  fprintf(output, "{\n  \"threads\": %u,\n  \"wall_seconds\": %.9f,\n"
+	  "  \"tick_seconds\": %.6e,\n  \"total\": {", size,
+	  end->seconds - begin->seconds, tick);
+  print_json_counters(output, &total, tick);
+  fputs("},\n  \"per_thread\": [\n", output);
+  for (unsigned int t = 0; t < size; ++t)
+  {
+    fputs("    {", output);
+    print_json_counters(output, &threads[t], tick);
+    fputs(t + 1 < size ? "},\n" : "}\n", output);
+  }
+  fputs("  ]\n}\n", output);
+
+  return fclose(output) == 0 ? 0 : METRICS_ERR_OPEN;
+} /* end of metrics_write_json function */
+
+
+int
+metrics_write_trace(const char *filename, const metrics *threads,
+		    unsigned int size, const metrics_clock *begin,
+		    const metrics_clock *end)
+{
+  /*
+   * Store the trace events of every thread in 'filename', in the
+   * trace event format (one complete event per stage, timestamps in
+   * microseconds from the beginning of the run), readable by
+   * chrome://tracing or Perfetto. Returns 0 on success,
+   * METRICS_ERR_OPEN otherwise.
+   */
+
+  const double tick = metrics_tick_seconds(begin, end) * 1e6;
+  FILE *output = fopen(filename, "w");
+  const char *sep = "";
+
+  if (output == NULL)
+  {
+    return METRICS_ERR_OPEN;
+  }
+
+  fputs("{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n", output);
+  for (unsigned int t = 0; t < size; ++t)
+  {
+    for (size_t e = 0; e < threads[t].event_count; ++e)
+    {
+      const struct metric_event *event = &threads[t].events[e];
+
+      fprintf(output, "%s{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 0, "
+	      "\"tid\": %u, \"ts\": %.3f, \"dur\": %.3f, "
+	      "\"args\": {\"path\": %u}}", sep, stage_names[event->stage],
+	      t, (double)(event->start - begin->ticks) * tick,
+	      (double)(event->end - event->start) * tick, event->path + 1);
+      sep = ",\n";
+    }
+  }
+  fputs("\n]}\n", output);
+
+  return fclose(output) == 0 ? 0 : METRICS_ERR_OPEN;
+} /* end of metrics_write_trace function */
@@ -0,0 +1,151 @@
+/*
+ * Filename: metrics.h
+ *
+ * Summary: defines the instrumentation of the computation of paths:
+ * time spent in every stage, allocations and bytes written, counted
+ * per thread and merged at the end of a run.
+ *
+ * The hooks (METRIC_STAGE, METRIC_PATH, METRIC_ADD) are compiled out
+ * unless INSTRUMENT is defined (see config.h, which must be included
+ * first).
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+
+typedef enum {METRICS_ERR_ALLOC=-2304, METRICS_ERR_OPEN} metrics_error_t;
+
+typedef enum {METRIC_RNG, METRIC_SCHEME, METRIC_INTERPOLATION,
+  METRIC_REFERENCE, METRIC_OUTPUT, METRIC_WRITE, METRIC_FUSED,
+  METRIC_STAGES}
+  metric_stage;
+
+struct metric_event
+{
+  /* A stage of a path, for trace events. */
+
+  uint64_t start;
+  uint64_t end;
+  unsigned int path;
+  metric_stage stage;
+};
+
+struct metrics
+{
+  /*
+   * Counters of a single thread, in ticks of metrics_ticks. Do not
+   * write in 'events' manually.
+   */
+
+  uint64_t ticks[METRIC_STAGES];
+  uint64_t calls[METRIC_STAGES];
+  uint64_t paths;
+  uint64_t allocations;
+  uint64_t files;
+  uint64_t bytes;
+  uint64_t scratch;
+  unsigned int path; /* path being computed */
+  struct metric_event *events;
+  size_t event_count;
+  size_t event_capacity;
+};
+
+struct metrics_clock
+{
+  /* A tick count and the wall-clock time at which it was read. */
+
+  uint64_t ticks;
+  double seconds;
+};
+
+typedef struct metrics metrics;
+typedef struct metrics_clock metrics_clock;
+
+
+static inline uint64_t
+metrics_ticks(void)
+{
+  /*
+   * Time stamp counter on x86 (constant rate on recent processors),
+   * nanoseconds elsewhere. Converted to seconds by
+   * metrics_tick_seconds.
+   */
+
+  #if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  return __builtin_ia32_rdtsc();
+  #else
+  struct timespec now;
+
+  timespec_get(&now, TIME_UTC);
+  return (uint64_t)now.tv_sec * 1000000000U + (uint64_t)now.tv_nsec;
+  #endif
+} /* end of metrics_ticks function */
+
+
+#ifdef INSTRUMENT
+#define METRIC_STAGE(m, stage, statement)				\
+  do									\
+  {									\
+    const uint64_t metric_start_ = metrics_ticks();			\
+    statement;								\
+    metrics_stage((m), (stage), metric_start_);			\
+  } while (0)
+#define METRIC_PATH(m, i) ((m)->path = (i))
+#define METRIC_ADD(m, member, value) ((m)->member += (value))
+#else
+#define METRIC_STAGE(m, stage, statement)	\
+  do						\
+  {						\
+    (void)(m);					\
+    statement;					\
+  } while (0)
+#define METRIC_PATH(m, i) ((void)(m), (void)(i))
+#define METRIC_ADD(m, member, value) ((void)(m))
+#endif
+
+extern int
+metrics_init(metrics *m, size_t events);
+
+extern void
+metrics_free(metrics *m);
+
+extern void
+metrics_stage(metrics *m, metric_stage stage, uint64_t start);
+
+extern void
+metrics_merge(metrics *total, const metrics *m);
+
+extern void
+metrics_clock_now(metrics_clock *clock);
+
+extern double
+metrics_tick_seconds(const metrics_clock *begin, const metrics_clock *end);
+
+extern void
+metrics_print(FILE *output, const metrics *threads, unsigned int size,
+	      const metrics_clock *begin, const metrics_clock *end);
+
+extern int
+metrics_write_json(const char *filename, const metrics *threads,
+		   unsigned int size, const metrics_clock *begin,
+		   const metrics_clock *end);
+
+extern int
+metrics_write_trace(const char *filename, const metrics *threads,
+		    unsigned int size, const metrics_clock *begin,
+		    const metrics_clock *end);
+
+
+#endif /* METRICS_H */
@@ -0,0 +1,483 @@
+/*
+ * Filename: mlmc.c
+ *
+ * Summary: implements a multilevel Monte Carlo (MLMC) estimator of
+ * E[f(X_T)], X being approximated by the Euler-Maruyama scheme or by
+ * a scheme given with the problem.
+ *
+ * Following Giles ("Multilevel Monte Carlo path simulation", 2008,
+ * and "Multilevel Monte Carlo methods", 2015), E[f(X^L_T)] is written
+ * as the telescopic sum of E[f(X^l_T) - f(X^{l-1}_T)], where X^l is
+ * the approximation with step h / 2^l. On each level, the fine and
+ * the coarse approximations are driven by the same Brownian path (the
+ * coarse one sees every other point), so that the corrections have a
+ * small variance and only need few samples. The number of levels and
+ * of samples per level are chosen from online estimates of the means
+ * and variances, so that the root mean square error is below a given
+ * epsilon.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "arena.h"
+#include "brownian_path.h"
+#include "mlmc.h"
+#include "monte_carlo.h"
+#include "numerical_approximation.h"
+
+
+#define MLMC_BLOCKS 256
+/* Part of the squared error given to the variance (the rest to bias). */
+#define MLMC_THETA 0.5
+
+struct mlmc_batch
+{
+  /* Samples number 'first' to 'first + count - 1' of a level. */
+  
+  const mlmc_problem *problem;
+  unsigned int level;
+  unsigned long long first;
+  unsigned long long count;
+  unsigned long long block_size;
+  accumulator *blocks;
+};
+
+struct mlmc_worker
+{
+  /*
+   * Scratch arrays of a thread, sized once per batch from the number
+   * of steps of the fine level.
+   */
+
+  struct mlmc_batch *batch;
+  arena scratch;
+  double *brownian_motion;
+  double *fine;
+  double *truncated;
+  double *coarse;
+};
+
+
+static void
+mlmc_path(struct mlmc_worker *worker, double step, unsigned int factor,
+	  double *path)
+{
+  /*
+   * Approximation of step 'step' driven by worker->brownian_motion,
+   * whose precision is step / factor.
+   */
+
+  const mlmc_problem *problem = worker->batch->problem;
+  const unsigned int steps = floor(problem->time_bound / step);
+  const double *brownian_motion = worker->brownian_motion;
+  
+  if (problem->scheme != NULL)
+  {
+    problem->scheme(problem->time_bound, step, problem->init,
+		    brownian_motion, factor, path);
+    return;
+  }
+
+  if (factor > 1)
+  {
+    for (unsigned int j = 0; j <= steps; ++j)
+    {
+      worker->truncated[j] = brownian_motion[factor * j];
+    }
+    brownian_motion = worker->truncated;
+  }
+  euler_maruyama_into(problem->time_bound, step, problem->init,
+		      brownian_motion, problem->determ_func,
+		      problem->stocha_func, path);
+} /* end of mlmc_path function */
+
+
+static void
+mlmc_sample(struct mlmc_worker *worker, unsigned long long sample,
+	    double *correction)
+{
+  /*
+   * Compute f(X^l_T) - f(X^{l-1}_T) for the sample number 'sample' of
+   * level l, in the arrays of the worker. Every (level, sample) pair
+   * owns its generator stream, disjoint from the streams of
+   * compute_approximation's paths.
+   */
+
+  const mlmc_problem *problem = worker->batch->problem;
+  const unsigned int level = worker->batch->level;
+  const double step = problem->coarsest_step / pow(2, level);
+  const unsigned int steps = floor(problem->time_bound / step);
+  const uint64_t stream = ((uint64_t)(level + 1) << 48) | sample;
+  prng_state rng;
+
+  prng_init(&rng, problem->kind, problem->seed, stream);
+  brownian_path_into(&rng, problem->time_bound, step,
+		     worker->brownian_motion);
+  mlmc_path(worker, step, 1, worker->fine);
+  
+  *correction = problem->functional(worker->fine[steps]);
+
+  if (level > 0)
+  {
+    mlmc_path(worker, 2 * step, 2, worker->coarse);
+    *correction -= problem->functional(worker->coarse[steps / 2]);
+  }
+} /* end of mlmc_sample function */
+
+
+static void
+mlmc_sample_bridge(struct mlmc_worker *worker, unsigned long long sample,
+		   double *correction)
+{
+  /*
+   * Same as mlmc_sample, the Brownian path being built by Brownian
+   * bridges over one coarsest step at a time, in worker->brownian_motion
+   * (2^l + 1 values). Both approximations step through the segment
+   * before the next one is computed.
+   */
+
+  const mlmc_problem *problem = worker->batch->problem;
+  const unsigned int level = worker->batch->level;
+  const unsigned int size = 1U << level;
+  const double step = problem->coarsest_step / pow(2, level);
+  const uint64_t stream = ((uint64_t)(level + 1) << 48) | sample;
+  double *segment = worker->brownian_motion;
+  double fine = problem->init, coarse = problem->init, time;
+  double left = 0, right, d_brownian;
+  unsigned int j;
+  brownian_bridge bridge;
+  prng_state rng;
+
+  prng_init(&rng, problem->kind, problem->seed, stream);
+  brownian_bridge_init(&bridge, &rng, problem->time_bound,
+		       problem->coarsest_step);
+
+  for (unsigned int i = 0; i < bridge.intervals; ++i)
+  {
+    right = left + brownian_bridge_increment(&bridge, i);
+    brownian_bridge_segment(&bridge, i, level, left, right, segment);
+    left = right;
+    
+    for (unsigned int k = 1; k <= size; ++k)
+    {
+      j = i * size + k;
+      time = j * step;
+      d_brownian = segment[k] - segment[k - 1];
+      fine = problem->step != NULL
+	? problem->step(time, step, fine, segment + k - 1, 1)
+	: fine + step * problem->determ_func(time, fine)
+	+ d_brownian * problem->stocha_func(time, fine);
+
+      if (level > 0 && k % 2 == 0)
+      {
+	time = (j / 2) * (2 * step);
+	d_brownian = segment[k] - segment[k - 2];
+	coarse = problem->step != NULL
+	  ? problem->step(time, 2 * step, coarse, segment + k - 2, 2)
+	  : coarse + 2 * step * problem->determ_func(time, coarse)
+	  + d_brownian * problem->stocha_func(time, coarse);
+      }
+    }
+  }
+
+  *correction = problem->functional(fine);
+  if (level > 0)
+  {
+    *correction -= problem->functional(coarse);
+  }
+} /* end of mlmc_sample_bridge function */
+
+
+static int
+mlmc_block(void *arg, unsigned int b)
+{
+  /* Push, in order, the corrections of the block b of the batch. */
+  
+  struct mlmc_worker *worker = arg;
+  struct mlmc_batch *batch = worker->batch;
+  unsigned long long first = b * batch->block_size;
+  unsigned long long last = first + batch->block_size;
+  double correction;
+
+  if (last > batch->count)
+  {
+    last = batch->count;
+  }
+
+  for (unsigned long long k = first; k < last; ++k)
+  {
+    if (batch->problem->brownian == BROWNIAN_BRIDGE)
+    {
+      mlmc_sample_bridge(worker, batch->first + k, &correction);
+    }
+    else
+    {
+      mlmc_sample(worker, batch->first + k, &correction);
+    }
+    acc_push(&batch->blocks[b], correction);
+  }
+
+  return 0;
+} /* end of mlmc_block function */
+
+
+static int
+mlmc_sample_level(const mlmc_problem *problem, unsigned int level,
+		  unsigned long long count, unsigned int threads,
+		  accumulator *acc)
+{
+  /*
+   * Compute 'count' more samples of the level and add them to 'acc'.
+   * Samples are split in blocks merged in order, so that the result
+   * does not depend on the number of threads.
+   */
+
+  const unsigned long long blocks = count < MLMC_BLOCKS ? count
+    : MLMC_BLOCKS;
+  const size_t length = problem->brownian == BROWNIAN_BRIDGE
+    ? (1U << level) + 1
+    : floor(problem->time_bound * pow(2, level) / problem->coarsest_step) + 1;
+  struct mlmc_batch batch;
+  struct mlmc_worker *workers;
+  void **worker_ptrs;
+  int status = 0;
+
+  if (count == 0)
+  {
+    return 0;
+  }
+  
+  batch.problem = problem;
+  batch.level = level;
+  batch.first = acc->count;
+  batch.count = count;
+  batch.block_size = (count + blocks - 1) / blocks;
+  batch.blocks = calloc(blocks, sizeof *batch.blocks);
+  workers = calloc(threads, sizeof *workers);
+  worker_ptrs = malloc(threads * sizeof *worker_ptrs);
+
+  if (batch.blocks == NULL || workers == NULL || worker_ptrs == NULL)
+  {
+    free(batch.blocks);
+    free(workers);
+    free(worker_ptrs);
+    return MLMC_ERR_ALLOC;
+  }
+
+  /*
+   * Workers only share read-only data, blocks are written once. The
+   * coarse arrays are shorter, the fine length is an upper bound;
+   * Brownian bridges only use the first array, as a segment.
+   */
+  for (unsigned int t = 0; t < threads; ++t)
+  {
+    workers[t].batch = &batch;
+    worker_ptrs[t] = &workers[t];
+    if (arena_init(&workers[t].scratch,
+		   4 * arena_size_of_doubles(length)) != 0)
+    {
+      status = MLMC_ERR_ALLOC;
+      continue;
+    }
+    workers[t].brownian_motion = arena_doubles(&workers[t].scratch, length);
+    workers[t].fine = arena_doubles(&workers[t].scratch, length);
+    workers[t].truncated = arena_doubles(&workers[t].scratch, length);
+    workers[t].coarse = arena_doubles(&workers[t].scratch, length);
+  }
+
+  if (status == 0)
+  {
+    status = mc_run((count + batch.block_size - 1) / batch.block_size,
+		    threads, &mlmc_block, worker_ptrs);
+  }
+
+  for (unsigned long long b = 0; b < blocks && status == 0; ++b)
+  {
+    acc_merge(acc, &batch.blocks[b]);
+  }
+
+  for (unsigned int t = 0; t < threads; ++t)
+  {
+    arena_free(&workers[t].scratch);
+  }
+  free(batch.blocks);
+  free(workers);
+  free(worker_ptrs);
+
+  return status;
+} /* end of mlmc_sample_level function */
+
+
+static double
+mlmc_rate(const double *values, unsigned int size)
+{
+  /*
+   * Least squares slope of -log2(values[l]) w.r.t. l, over levels 1
+   * to size - 1 (level 0 is not a correction), at least 0.5.
+   */
+
+  double sum_l = 0, sum_y = 0, sum_ll = 0, sum_ly = 0, y;
+  unsigned int n = 0;
+
+  for (unsigned int l = 1; l < size; ++l)
+  {
+    if (values[l] > 0)
+    {
+      y = -log2(values[l]);
+      sum_l += l;
+      sum_y += y;
+      sum_ll += (double)l * l;
+      sum_ly += l * y;
+      n++;
+    }
+  }
+
+  if (n < 2)
+  {
+    return 0.5;
+  }
+
+  y = (n * sum_ly - sum_l * sum_y) / (n * sum_ll - sum_l * sum_l);
+  
+  return y > 0.5 ? y : 0.5;
+} /* end of mlmc_rate function */
+
+
+int
+mlmc_run(const mlmc_problem *problem, double epsilon, unsigned int threads,
+	 mlmc_result *result)
+{
+  /*
+   * Estimate E[f(X_T)] with a root mean square error below
+   * 'epsilon', using 'threads' threads.
+   *
+   * Returns 0 on success, MLMC_ERR_MAX_LEVEL if MLMC_MAX_LEVELS levels
+   * were not enough to reach the bias target (the result is filled
+   * anyway), another negative error code otherwise.
+   */
+
+  const double steps0 = floor(problem->time_bound / problem->coarsest_step);
+  double mean[MLMC_MAX_LEVELS], variance[MLMC_MAX_LEVELS];
+  double cost[MLMC_MAX_LEVELS];
+  unsigned long long wanted[MLMC_MAX_LEVELS];
+  double sum, remainder;
+  unsigned int size = MLMC_MIN_LEVELS + 1;
+  int converged = 0, status = 0;
+
+  for (unsigned int l = 0; l < MLMC_MAX_LEVELS; ++l)
+  {
+    acc_init(&result->levels[l]);
+    /* Fine steps, plus coarse steps on corrections. */
+    cost[l] = steps0 * pow(2, l) * (l > 0 ? 1.5 : 1.0);
+    wanted[l] = l < size ? MLMC_INITIAL_SAMPLES : 0;
+  }
+  result->alpha = 0.5;
+  result->beta = 0.5;
+
+  while (!converged && status == 0)
+  {
+    /* Draw the missing samples. */
+    for (unsigned int l = 0; l < size && status == 0; ++l)
+    {
+      if (wanted[l] > result->levels[l].count)
+      {
+	status = mlmc_sample_level(problem, l,
+				   wanted[l] - result->levels[l].count,
+				   threads, &result->levels[l]);
+      }
+    }
+
+    if (status != 0)
+    {
+      break;
+    }
+
+    /* Estimates, with a fix for levels where they vanish. */
+    for (unsigned int l = 0; l < size; ++l)
+    {
+      mean[l] = fabs(result->levels[l].mean);
+      variance[l] = acc_variance(&result->levels[l]);
+    }
+    result->alpha = mlmc_rate(mean, size);
+    result->beta = mlmc_rate(variance, size);
+    for (unsigned int l = 2; l < size; ++l)
+    {
+      mean[l] = fmax(mean[l], 0.5 * mean[l - 1] / pow(2, result->alpha));
+      variance[l] = fmax(variance[l],
+			 0.5 * variance[l - 1] / pow(2, result->beta));
+    }
+
+    for (;;)
+    {
+      /* Optimal numbers of samples (Lagrange multipliers). */
+      sum = 0;
+      for (unsigned int l = 0; l < size; ++l)
+      {
+	sum += sqrt(variance[l] * cost[l]);
+      }
+
+      converged = 1;
+      for (unsigned int l = 0; l < size; ++l)
+      {
+	wanted[l] = fmax(ceil(sqrt(variance[l] / cost[l]) * sum
+			      / ((1.0 - MLMC_THETA) * epsilon * epsilon)),
+			 MLMC_MIN_SAMPLES);
+	if (wanted[l] > result->levels[l].count
+	    && wanted[l] - result->levels[l].count
+	    > 0.01 * result->levels[l].count)
+	{
+	  converged = 0;
+	}
+      }
+
+      if (!converged)
+      {
+	break;
+      }
+
+      /* Weak error left, extrapolated from the last levels. */
+      remainder = 0;
+      for (unsigned int l = size >= 3 ? size - 3 : 1; l < size; ++l)
+      {
+	remainder = fmax(remainder, mean[l] * pow(2, result->alpha
+						  * ((double)l - (size - 1))));
+      }
+      remainder /= pow(2, result->alpha) - 1.0;
+
+      if (remainder <= sqrt(MLMC_THETA) * epsilon)
+      {
+	break;
+      }
+
+      if (size == MLMC_MAX_LEVELS)
+      {
+	status = MLMC_ERR_MAX_LEVEL;
+	break;
+      }
+
+      /* New level, its variance extrapolated from the last one. */
+      variance[size] = variance[size - 1] / pow(2, result->beta);
+      mean[size] = mean[size - 1] / pow(2, result->alpha);
+      size++;
+      converged = 0;
+    }
+  } /* end of while-loop */
+
+  result->size = size;
+  result->estimate = 0;
+  result->cost = 0;
+  for (unsigned int l = 0; l < size; ++l)
+  {
+    result->estimate += result->levels[l].mean;
+    result->cost += cost[l] * result->levels[l].count;
+  }
+
+  return status;
+} /* end of mlmc_run function */
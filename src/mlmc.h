@@ -0,0 +1,88 @@
+/*
+ * Filename: mlmc.h
+ *
+ * Summary: defines a multilevel Monte Carlo (MLMC) estimator of
+ * E[f(X_T)], X being approximated by the Euler-Maruyama scheme or by
+ * a scheme given with the problem.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#ifndef MLMC_H
+#define MLMC_H
+
+#include <stdint.h>
+
+#include "brownian_path.h"
+#include "numerical_approximation.h"
+#include "prng.h"
+#include "statistics.h"
+
+
+#define MLMC_MAX_LEVELS 21
+#define MLMC_MIN_LEVELS 2
+#define MLMC_INITIAL_SAMPLES 1000
+/* Fewest samples of a level, so that its variance is defined. */
+#define MLMC_MIN_SAMPLES 2
+
+typedef enum {MLMC_ERR_ALLOC=-1280, MLMC_ERR_MAX_LEVEL} mlmc_error_t;
+
+struct mlmc_problem
+{
+  /*
+   * The SDE (see euler_maruyama_method), the functional f and the
+   * step of the coarsest level. Level l uses the step
+   * coarsest_step / 2^l.
+   *
+   * 'scheme' and 'step', if not NULL, are a kernel and a step of a
+   * scheme specialized for the SDE (see SCHEME_KERNEL), used instead
+   * of the Euler-Maruyama scheme with the function pointers. The
+   * coarse approximation of a level is computed by the same scheme.
+   *
+   * With BROWNIAN_BRIDGE, paths are refined from the coarsest grid
+   * one coarsest step at a time: a sample of level l stores 2^l + 1
+   * values only. time_bound must then be a multiple of
+   * coarsest_step.
+   */
+  
+  double time_bound;
+  double coarsest_step;
+  double init;
+  double (*determ_func)(double time, double pos);
+  double (*stocha_func)(double time, double pos);
+  double (*functional)(double pos);
+  scheme_kernel scheme;
+  scheme_step step;
+  prng_kind kind;
+  uint64_t seed;
+  brownian_method brownian;
+};
+
+struct mlmc_result
+{
+  /*
+   * levels[l] accumulates the corrections f(X^l_T) - f(X^{l-1}_T)
+   * (f(X^0_T) on level 0). The estimate is the sum of their means.
+   */
+  
+  unsigned int size;
+  accumulator levels[MLMC_MAX_LEVELS];
+  double alpha; /* weak order, estimated */
+  double beta;  /* variance decay rate, estimated */
+  double estimate;
+  double cost;  /* total number of fine and coarse steps */
+};
+
+typedef struct mlmc_problem mlmc_problem;
+typedef struct mlmc_result mlmc_result;
+
+extern int
+mlmc_run(const mlmc_problem *problem, double epsilon, unsigned int threads,
+	 mlmc_result *result);
+
+
+#endif /* MLMC_H */
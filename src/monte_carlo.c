@@ -0,0 +1,431 @@
+/*
+ * Filename: monte_carlo.c
+ *
+ * Summary: implements a driver running independent trajectories of a
+ * Monte Carlo simulation on several threads.
+ *
+ * Trajectories are handed out one at a time from a shared atomic
+ * counter, so that a slow trajectory never leaves the other threads
+ * idle. A run may be split in consecutive ranges of trajectories
+ * (see mc_run_range), e.g. to store checkpoints between them. A
+ * trajectory must only depend on its number (e.g. through its own
+ * random stream, see prng.h) so that the results do not depend on
+ * the number of threads nor on the scheduling.
+ *
+ * With mc_run_pipeline, trajectories are handed to writer threads
+ * through a bounded queue of slots: trajectory i goes in slot i %
+ * capacity, which it may only fill once trajectory i - capacity is
+ * written. Computation runs at most 'capacity' trajectories ahead of
+ * the writers, and trajectories are written in order. Slots are
+ * handed over by atomic sequence numbers, without any lock.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <threads.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "monte_carlo.h"
+
+
+/* Yields before sleeping MC_NAP nanoseconds between two checks. */
+#define MC_SPINS 64
+#define MC_NAP 50000L
+
+
+struct mc_task
+{
+  /*
+   * Shared between every thread of a run, except 'worker', 'status'
+   * and 'failed_path' which belong to a single thread.
+   */
+  
+  atomic_uint *next;
+  unsigned int last;
+  mc_path_func func;
+  void *worker;
+  int status;
+  unsigned int failed_path;
+};
+
+
+static int
+mc_thread(void *arg)
+{
+  /*
+   * Compute trajectories until there is none left. Keep the error
+   * of the first failing trajectory (w.r.t. its number).
+   */
+
+  struct mc_task *task = arg;
+  unsigned int path;
+  int status;
+
+  while ((path = atomic_fetch_add(task->next, 1)) < task->last)
+  {
+    status = task->func(task->worker, path);
+    
+    if (status != 0 && path < task->failed_path)
+    {
+      task->status = status;
+      task->failed_path = path;
+    }
+  } /* end of while-loop */
+
+  return 0;
+} /* end of mc_thread function */
+
+
+struct mc_queue
+{
+  /*
+   * Slots of a pipeline. The sequence number of a slot is 2 i when
+   * the slot is free for trajectory i, 2 i + 1 when trajectory i is
+   * ready to be written. 'status' holds the status of filling.
+   */
+
+  void **slots;
+  atomic_ullong *sequence;
+  int *status;
+  unsigned int capacity;
+  unsigned int last;
+  mc_fill_func fill;
+  mc_write_func write;
+  atomic_uint next;     /* next trajectory to write */
+  atomic_int aborted;   /* no trajectory will be filled anymore */
+};
+
+struct mc_stage
+{
+  /* A worker or a writer of a pipeline. */
+
+  struct mc_queue *queue;
+  void *data;
+  int status;
+  unsigned int failed_path;
+};
+
+
+static int
+mc_wait(struct mc_queue *queue, unsigned int slot, unsigned long long value)
+{
+  /*
+   * Wait until the sequence number of 'slot' is 'value'. Returns 0
+   * if the pipeline is aborted meanwhile, 1 otherwise.
+   */
+
+  const struct timespec nap = {0, MC_NAP};
+  unsigned int spins = 0;
+
+  while (atomic_load_explicit(&queue->sequence[slot], memory_order_acquire)
+	 != value)
+  {
+    if (atomic_load_explicit(&queue->aborted, memory_order_relaxed))
+    {
+      return 0;
+    }
+    
+    if (++spins < MC_SPINS)
+    {
+      thrd_yield();
+    }
+    else
+    {
+      thrd_sleep(&nap, NULL);
+    }
+  } /* end of while-loop */
+
+  return 1;
+} /* end of mc_wait function */
+
+
+static int
+mc_fill(void *arg, unsigned int path)
+{
+  /* Fill the slot of a trajectory once it is free, then publish it. */
+
+  struct mc_stage *stage = arg;
+  struct mc_queue *queue = stage->queue;
+  const unsigned int slot = path % queue->capacity;
+
+  mc_wait(queue, slot, 2ULL * path);
+  queue->status[slot] = queue->fill(stage->data, queue->slots[slot], path);
+  atomic_store_explicit(&queue->sequence[slot], 2ULL * path + 1,
+			memory_order_release);
+
+  /* Errors are reported by the writers. */
+  return 0;
+} /* end of mc_fill function */
+
+
+static int
+mc_writer(void *arg)
+{
+  /*
+   * Write trajectories, in order, until there is none left, and free
+   * their slots. Keep the error of the first failing trajectory
+   * (w.r.t. its number), while filling or writing it.
+   */
+
+  struct mc_stage *stage = arg;
+  struct mc_queue *queue = stage->queue;
+  unsigned int path, slot;
+  int status;
+
+  while ((path = atomic_fetch_add(&queue->next, 1)) < queue->last)
+  {
+    slot = path % queue->capacity;
+    if (!mc_wait(queue, slot, 2ULL * path + 1))
+    {
+      break;
+    }
+
+    status = queue->status[slot];
+    if (status == 0)
+    {
+      status = queue->write(stage->data, queue->slots[slot], path);
+    }
+    atomic_store_explicit(&queue->sequence[slot],
+			  2ULL * (path + queue->capacity),
+			  memory_order_release);
+
+    if (status != 0 && path < stage->failed_path)
+    {
+      stage->status = status;
+      stage->failed_path = path;
+    }
+  } /* end of while-loop */
+
+  return 0;
+} /* end of mc_writer function */
+
+
+unsigned int
+mc_available_threads(void)
+{
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return cores > 0 ? (unsigned int)cores : 1;
+} /* end of mc_available_threads function */
+
+
+int
+mc_run_range(unsigned int first, unsigned int last, unsigned int threads,
+	     mc_path_func func, void **workers)
+{
+  /*
+   * Compute the trajectories 'first' to 'last' (excluded) with
+   * 'threads' threads. The array 'workers' holds one scratch pointer
+   * per thread, given to 'func'.
+   *
+   * Returns 0 if every trajectory succeeded, otherwise the error
+   * returned by the failing trajectory having the lowest number, or
+   * MC_ERR_ALLOC.
+   */
+
+  atomic_uint next = first;
+  struct mc_task *tasks;
+  thrd_t *ids;
+  unsigned int started = 0;
+  unsigned int failed_path = last;
+  int status = 0;
+
+  if (threads < 1)
+  {
+    threads = 1;
+  }
+
+  tasks = malloc(threads * sizeof *tasks);
+  ids = malloc(threads * sizeof *ids);
+
+  if (tasks == NULL || ids == NULL)
+  {
+    free(tasks);
+    free(ids);
+    return MC_ERR_ALLOC;
+  }
+
+  for (unsigned int t = 0; t < threads; ++t)
+  {
+    tasks[t].next = &next;
+    tasks[t].last = last;
+    tasks[t].func = func;
+    tasks[t].worker = workers[t];
+    tasks[t].status = 0;
+    tasks[t].failed_path = last;
+  } /* end of for-loop */
+
+  /* The calling thread is the first worker. */
+  for (unsigned int t = 1; t < threads; ++t)
+  {
+    if (thrd_create(&ids[t], &mc_thread, &tasks[t]) != thrd_success)
+    {
+      break;
+    }
+    started++;
+  } /* end of for-loop */
+
+  mc_thread(&tasks[0]);
+
+  for (unsigned int t = 1; t <= started; ++t)
+  {
+    thrd_join(ids[t], NULL);
+  } /* end of for-loop */
+
+  for (unsigned int t = 0; t < threads; ++t)
+  {
+    if (tasks[t].status != 0 && tasks[t].failed_path < failed_path)
+    {
+      status = tasks[t].status;
+      failed_path = tasks[t].failed_path;
+    }
+  } /* end of for-loop */
+
+  free(tasks);
+  free(ids);
+  
+  return status;
+} /* end of mc_run_range function */
+
+
+int
+mc_run(unsigned int iter, unsigned int threads, mc_path_func func,
+       void **workers)
+{
+  /* Compute 'iter' trajectories, see mc_run_range. */
+
+  return mc_run_range(0, iter, threads, func, workers);
+} /* end of mc_run function */
+
+
+int
+mc_run_pipeline(unsigned int first, unsigned int last, unsigned int threads,
+		mc_fill_func fill, void **workers, unsigned int writers,
+		mc_write_func write, void **writer_ptrs, void **slots,
+		unsigned int capacity)
+{
+  /*
+   * Compute the trajectories 'first' to 'last' (excluded) with
+   * 'threads' threads and write them with 'writers' other threads,
+   * through the 'capacity' slots of 'slots'. The arrays 'workers'
+   * and 'writer_ptrs' hold one pointer per thread, given to 'fill'
+   * and 'write' respectively.
+   *
+   * Returns 0 if every trajectory was filled and written, otherwise
+   * the error of the failing trajectory having the lowest number, or
+   * an error of the driver (see mc_error_t).
+   */
+
+  struct mc_queue queue;
+  struct mc_stage *stages;
+  void **stage_ptrs;
+  thrd_t *ids;
+  unsigned int started = 0;
+  unsigned int failed_path = last;
+  int status = 0, aborted;
+
+  if (threads < 1)
+  {
+    threads = 1;
+  }
+  if (writers < 1 || capacity < 1)
+  {
+    return MC_ERR_VALUE;
+  }
+
+  queue.slots = slots;
+  queue.capacity = capacity;
+  queue.last = last;
+  queue.fill = fill;
+  queue.write = write;
+  atomic_init(&queue.next, first);
+  atomic_init(&queue.aborted, 0);
+  queue.sequence = malloc(capacity * sizeof *queue.sequence);
+  queue.status = malloc(capacity * sizeof *queue.status);
+  stages = malloc((threads + writers) * sizeof *stages);
+  stage_ptrs = malloc(threads * sizeof *stage_ptrs);
+  ids = malloc(writers * sizeof *ids);
+
+  if (queue.sequence == NULL || queue.status == NULL || stages == NULL
+      || stage_ptrs == NULL || ids == NULL)
+  {
+    free(queue.sequence);
+    free(queue.status);
+    free(stages);
+    free(stage_ptrs);
+    free(ids);
+    return MC_ERR_ALLOC;
+  }
+
+  for (unsigned int k = 0; k < capacity; ++k)
+  {
+    atomic_init(&queue.sequence[(first + k) % capacity],
+		2ULL * (first + k));
+  }
+
+  for (unsigned int t = 0; t < threads + writers; ++t)
+  {
+    stages[t].queue = &queue;
+    stages[t].data = t < threads ? workers[t] : writer_ptrs[t - threads];
+    stages[t].status = 0;
+    stages[t].failed_path = last;
+    if (t < threads)
+    {
+      stage_ptrs[t] = &stages[t];
+    }
+  } /* end of for-loop */
+
+  for (unsigned int w = 0; w < writers; ++w)
+  {
+    if (thrd_create(&ids[w], &mc_writer, &stages[threads + w])
+	!= thrd_success)
+    {
+      break;
+    }
+    started++;
+  } /* end of for-loop */
+
+  aborted = started == 0 ? MC_ERR_THREAD
+    : mc_run_range(first, last, threads, &mc_fill, stage_ptrs);
+  if (aborted != 0)
+  {
+    atomic_store(&queue.aborted, 1);
+  }
+
+  for (unsigned int w = 0; w < started; ++w)
+  {
+    thrd_join(ids[w], NULL);
+  } /* end of for-loop */
+
+  for (unsigned int w = 0; w < writers; ++w)
+  {
+    if (stages[threads + w].status != 0
+	&& stages[threads + w].failed_path < failed_path)
+    {
+      status = stages[threads + w].status;
+      failed_path = stages[threads + w].failed_path;
+    }
+  } /* end of for-loop */
+
+  if (aborted != 0)
+  {
+    status = aborted;
+  }
+
+  free(queue.sequence);
+  free(queue.status);
+  free(stages);
+  free(stage_ptrs);
+  free(ids);
+
+  return status;
+} /* end of mc_run_pipeline function */
@@ -0,0 +1,59 @@
+/*
+ * Filename: monte_carlo.h
+ *
+ * Summary: defines the driver running independent trajectories of a
+ * Monte Carlo simulation on several threads.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#ifndef MONTE_CARLO_H
+#define MONTE_CARLO_H
+
+
+/*
+ * Errors of the driver itself: MC_ERR_ALLOC if its data cannot be
+ * allocated, MC_ERR_THREAD if no writer thread can be started,
+ * MC_ERR_VALUE if a pipeline has no writer or no slot.
+ */
+typedef enum {MC_ERR_ALLOC=-3328, MC_ERR_THREAD, MC_ERR_VALUE} mc_error_t;
+
+/*
+ * Function computing the trajectory number 'path' (starting from 0)
+ * with the scratch data of the calling worker. Returns 0 on success,
+ * a negative error code otherwise.
+ */
+typedef int (*mc_path_func)(void *worker, unsigned int path);
+
+/*
+ * Pipeline: function filling 'slot' with the trajectory number 'path'
+ * (with the scratch data of the calling worker), and function writing
+ * it (with the data of the calling writer). Both return 0 on success,
+ * a negative error code otherwise.
+ */
+typedef int (*mc_fill_func)(void *worker, void *slot, unsigned int path);
+typedef int (*mc_write_func)(void *writer, void *slot, unsigned int path);
+
+extern unsigned int
+mc_available_threads(void);
+
+extern int
+mc_run_range(unsigned int first, unsigned int last, unsigned int threads,
+	     mc_path_func func, void **workers);
+
+extern int
+mc_run(unsigned int iter, unsigned int threads, mc_path_func func,
+       void **workers);
+
+extern int
+mc_run_pipeline(unsigned int first, unsigned int last, unsigned int threads,
+		mc_fill_func fill, void **workers, unsigned int writers,
+		mc_write_func write, void **writer_ptrs, void **slots,
+		unsigned int capacity);
+
+
+#endif /* MONTE_CARLO_H */
@@ -74,24 +74,166 @@ euler_maruyama_method(double max_time, double d_time, double init, \
   unsigned int steps = floor(max_time / d_time);
   double *path = malloc((steps + 1) * sizeof *path);
 
-  double d_brownian;
-
   if (path != NULL) { 
+    euler_maruyama_into(max_time, d_time, init, brownian_motion,
+			determ_func, stocha_func, path);
+  } /* end of if-condition */
+  
+  return path;
+} /* end of euler_maruyama_method function */
+
+
+double *
+euler_maruyama_into(double max_time, double d_time, double init,	\
+		    const double *brownian_motion,			\
+		    double (*determ_func)(double time, double iter),	\
+		    double (*stocha_func)(double time, double iter),	\
+		    double *path)
+{
+  /*
+   * Same as euler_maruyama_method, the 'steps + 1' values being
+   * stored in 'path' instead of a newly allocated array. Returns
+   * 'path', or NULL if max_time is not positive.
+   */
+  
+  if (max_time <= 0) {
+    return NULL;
+  }
+  
+  unsigned int steps = floor(max_time / d_time);
+  double d_brownian;
 
-    path[0] = init;
+  path[0] = init;
   
-    for (unsigned int j = 1; j < steps + 1; ++j) {
-      d_brownian = brownian_motion[j] - brownian_motion[j - 1];
+  for (unsigned int j = 1; j < steps + 1; ++j) {
+    d_brownian = brownian_motion[j] - brownian_motion[j - 1];
       
-      path[j] = path[j - 1];
-      path[j] += d_time * determ_func(j * d_time, path[j - 1]);
-      path[j] += d_brownian * stocha_func(j * d_time, path[j - 1]);
-    } /* end of for-loop */
-    
-  } /* end of if-condition */
+    path[j] = path[j - 1];
+    path[j] += d_time * determ_func(j * d_time, path[j - 1]);
+    path[j] += d_brownian * stocha_func(j * d_time, path[j - 1]);
+  } /* end of for-loop */
   
   return path;
-} /* end of euler_maruyama_method function */
+} /* end of euler_maruyama_into function */
+
+
+/*
+ * Compute 'paths' pathwise approximations at once using
+ * Euler-Maruyama method. Paths advance in lockstep, so that the
+ * innermost loop runs over paths and is vectorized by the
+ * compiler. Expanded for double (euler_maruyama_batch) and float
+ * (euler_maruyama_batch_f), whose vectors hold twice as many paths.
+ *
+ * Parameters
+ * ----------
+ *
+ * max_time, d_time : double
+ *   See euler_maruyama_method. d_time is rounded to 'real'.
+ *
+ * paths : unsigned int
+ *   Number of paths computed at once.
+ *
+ * init : array of real
+ *   Initial value of each path ('paths' values).
+ *
+ * brownian_motion : array of real
+ *   Brownian motions driving the paths, stored step by step: the
+ *   value of the p-th motion at step j is brownian_motion[j * paths
+ *   + p]. Contains at least 'steps + 1' steps.
+ *
+ * determ_func, stocha_func : batch_func (batch_func_f)
+ *   Batched counterparts of the functions given to
+ *   euler_maruyama_method: given the time and the positions of
+ *   every path, they store the 'paths' values of the function in
+ *   their third argument.
+ *
+ *
+ * Returns
+ * -------
+ *
+ * Pointer (array) of reals, stored step by step like
+ * brownian_motion. Contains 'steps + 1' steps. In double, every path
+ * is bit-identical to the one computed by euler_maruyama_method.
+ */
+#define EULER_MARUYAMA_BATCH_OF(name, into, real, func)			\
+  real *								\
+  name(double max_time, double d_time, unsigned int paths,		\
+       const real *init, const real *brownian_motion,			\
+       func determ_func, func stocha_func)				\
+  {									\
+    if (max_time <= 0 || paths == 0) {					\
+      return NULL;							\
+    }									\
+									\
+    unsigned int steps = floor(max_time / d_time);			\
+    real *path = malloc((size_t)(steps + 1) * paths * sizeof *path);	\
+    real *terms = malloc(2 * (size_t)paths * sizeof *terms);		\
+									\
+    if (path != NULL && terms != NULL) {				\
+      into(max_time, d_time, paths, init, brownian_motion,		\
+	   determ_func, stocha_func, path, terms);			\
+    } /* end of if-condition */						\
+    else {								\
+      free(path);							\
+      path = NULL;							\
+    }									\
+									\
+    free(terms);							\
+									\
+    return path;							\
+  }
+
+/*
+ * Same as EULER_MARUYAMA_BATCH_OF, the 'steps + 1' steps being stored
+ * in 'path' instead of a newly allocated array. 'terms' is a scratch
+ * array of '2 * paths' values. Returns 'path', or NULL if max_time is
+ * not positive.
+ */
+#define EULER_MARUYAMA_BATCH_INTO_OF(name, real, func)			\
+  real *								\
+  name(double max_time, double d_time, unsigned int paths,		\
+       const real *init, const real *brownian_motion,			\
+       func determ_func, func stocha_func, real *path, real *terms)	\
+  {									\
+    if (max_time <= 0 || paths == 0) {					\
+      return NULL;							\
+    }									\
+									\
+    unsigned int steps = floor(max_time / d_time);			\
+    const real step = d_time;						\
+    real *restrict drift = terms;					\
+    real *restrict diffusion = terms + paths;				\
+									\
+    for (unsigned int p = 0; p < paths; ++p) {				\
+      path[p] = init[p];						\
+    } /* end of for-loop */						\
+									\
+    for (unsigned int j = 1; j < steps + 1; ++j) {			\
+      const real *restrict prev = path + (size_t)(j - 1) * paths;	\
+      const real *restrict b_prev = brownian_motion			\
+	+ (size_t)(j - 1) * paths;					\
+      const real *restrict b_cur = brownian_motion + (size_t)j * paths; \
+      real *restrict cur = path + (size_t)j * paths;			\
+									\
+      determ_func(j * d_time, prev, drift, paths);			\
+      stocha_func(j * d_time, prev, diffusion, paths);			\
+									\
+      for (unsigned int p = 0; p < paths; ++p) {			\
+	cur[p] = prev[p] + step * drift[p];				\
+	cur[p] += (b_cur[p] - b_prev[p]) * diffusion[p];		\
+      } /* end of for-loop */						\
+    } /* end of for-loop */						\
+									\
+    return path;							\
+  }
+
+EULER_MARUYAMA_BATCH_OF(euler_maruyama_batch, euler_maruyama_batch_into,
+			double, batch_func)
+EULER_MARUYAMA_BATCH_INTO_OF(euler_maruyama_batch_into, double, batch_func)
+EULER_MARUYAMA_BATCH_OF(euler_maruyama_batch_f, euler_maruyama_batch_into_f,
+			float, batch_func_f)
+EULER_MARUYAMA_BATCH_INTO_OF(euler_maruyama_batch_into_f, float,
+			     batch_func_f)
 
 
 double *
@@ -109,24 +251,43 @@ deterministic_ito_integral(double precision, double bound,
   const unsigned int steps = floor(bound / precision);
   double *integral = malloc((steps + 1) * sizeof *integral);
   
-  double d_brownian;
-
   if (integral != NULL)
   {
-    integral[0] = 0; // Integrating over [0, 0] returns 0.
-    
-    for (unsigned int j = 0; j < steps; ++j)
-    {
-      d_brownian = brownian_motion[j + 1] - brownian_motion[j];
-      integral[j + 1] = integral[j];
-      integral[j + 1] += func(j * precision) * d_brownian;
-    } /* end of for-loop */
+    deterministic_ito_integral_into(precision, bound, brownian_motion, func,
+				    integral);
   } /* end of if-condition */
 
   return integral;
 } /* end of deterministic_ito_integral function */
 
 
+double *
+deterministic_ito_integral_into(double precision, double bound,
+				const double *brownian_motion,
+				double (*func)(double real),
+				double *integral)
+{
+  /*
+   * Same as deterministic_ito_integral, the 'steps + 1' values being
+   * stored in 'integral'. Returns 'integral'.
+   */
+
+  const unsigned int steps = floor(bound / precision);
+  double d_brownian;
+
+  integral[0] = 0; // Integrating over [0, 0] returns 0.
+    
+  for (unsigned int j = 0; j < steps; ++j)
+  {
+    d_brownian = brownian_motion[j + 1] - brownian_motion[j];
+    integral[j + 1] = integral[j];
+    integral[j + 1] += func(j * precision) * d_brownian;
+  } /* end of for-loop */
+
+  return integral;
+} /* end of deterministic_ito_integral_into function */
+
+
 double *
 linear_interpolation(double *data_set, unsigned int arr_size,
 		     unsigned int factor)
@@ -135,20 +296,35 @@ linear_interpolation(double *data_set, unsigned int arr_size,
 
   if (ids != NULL && data_set != NULL)
   {
-    for (unsigned int j = 0; j < arr_size; ++j)
-    {
-      ids[factor * j] = data_set[j];
-      if (j > 0)
-      {
-	double increment = data_set[j] - data_set[j - 1];
-	for (unsigned int k = 1; k < factor; ++k)
-	{
-	  ids[(j - 1) * factor + k] = data_set[j - 1];
-	  ids[(j - 1) * factor + k] += (double)k / (double)factor * increment;
-	} /* end of for-loop */
-      } /* end of if-condition */
-    } /* end of for-loop */
+    linear_interpolation_into(data_set, arr_size, factor, ids);
   } /* end of if-condition */
   
   return ids;
 } /* end of interpolated_data_set function */
+
+
+double *
+linear_interpolation_into(const double *data_set, unsigned int arr_size,
+			  unsigned int factor, double *ids)
+{
+  /*
+   * Same as linear_interpolation, the 'factor * (arr_size - 1) + 1'
+   * values being stored in 'ids'. Returns 'ids'.
+   */
+  
+  for (unsigned int j = 0; j < arr_size; ++j)
+  {
+    ids[factor * j] = data_set[j];
+    if (j > 0)
+    {
+      double increment = data_set[j] - data_set[j - 1];
+      for (unsigned int k = 1; k < factor; ++k)
+      {
+	ids[(j - 1) * factor + k] = data_set[j - 1];
+	ids[(j - 1) * factor + k] += (double)k / (double)factor * increment;
+      } /* end of for-loop */
+    } /* end of if-condition */
+  } /* end of for-loop */
+  
+  return ids;
+} /* end of linear_interpolation_into function */
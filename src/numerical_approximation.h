@@ -14,6 +14,8 @@
 #ifndef NUMERICAL_APPROXIMATION_H
 #define NUMERICAL_APPROXIMATION_H
 
+#include <math.h>
+
 
 extern double *
 euler_maruyama_method(double max_time, double d_time, double init,	\
@@ -21,13 +23,264 @@ euler_maruyama_method(double max_time, double d_time, double init,	\
 		      double (*determ_func)(double time, double iter),	\
 		      double (*stocha_func)(double time, double iter));
 
+extern double *
+euler_maruyama_into(double max_time, double d_time, double init,	\
+		    const double *brownian_motion,			\
+		    double (*determ_func)(double time, double iter),	\
+		    double (*stocha_func)(double time, double iter),	\
+		    double *path);
+
+/*
+ * Integration schemes.
+ *
+ * SCHEME_EULER: Euler-Maruyama scheme, strong order 1/2 (1 for
+ *   additive noise).
+ * SCHEME_MILSTEIN: Milstein scheme, strong order 1. Needs the
+ *   derivative of the stochastic term w.r.t. the position.
+ * SCHEME_RUNGE_KUTTA: derivative-free Runge-Kutta scheme (Kloeden
+ *   and Platen, "Numerical solution of stochastic differential
+ *   equations", 1992, (11.1.3)), strong order 1. The derivative of
+ *   the Milstein scheme is replaced by a difference of the stochastic
+ *   term at a supporting value.
+ * SCHEME_ADAPTIVE: Milstein steps, halved as long as the difference
+ *   between one step and two half steps exceeds a tolerance. Values
+ *   of the Brownian motion inside a step are those of a finer path,
+ *   i.e. Brownian bridges refining the grid (Gaines and Lyons,
+ *   "Variable step size control in the numerical solution of
+ *   stochastic differential equations", 1997), so that refining a
+ *   step does not bias the path.
+ */
+typedef enum {SCHEME_EULER=1, SCHEME_MILSTEIN, SCHEME_RUNGE_KUTTA,
+  SCHEME_ADAPTIVE} scheme_kind;
+
+/*
+ * Precision of the approximation.
+ *
+ * PRECISION_DOUBLE: every value is a double.
+ * PRECISION_SINGLE: the approximation is stepped in single precision
+ *   (float), with the float expansion of the terms of the SDE (see
+ *   SDE_TERMS_OF in config.h). Rounding errors (about 1e-7) are far
+ *   below the discretization error of usual steps.
+ */
+typedef enum {PRECISION_DOUBLE=1, PRECISION_SINGLE} precision_kind;
+
+/*
+ * A step of a scheme: returns the approximation at 'time' (the end of
+ * the step) from the approximation 'pos' at 'time - d_time', given
+ * the 'factor + 1' values of the Brownian motion over the step (the
+ * first one at 'time - d_time').
+ *
+ * A kernel: computes a whole path, as euler_maruyama_into, from a
+ * Brownian motion 'factor' times finer than 'd_time' (path[j] uses
+ * brownian_motion[factor * j]). Returns 'path', or NULL if max_time
+ * is not positive.
+ *
+ * Function pointers cannot be inlined, so euler_maruyama_into pays
+ * two indirect calls per step. The macros below define static steps
+ * and kernels calling the terms of the SDE (functions or macros
+ * visible where the macro is expanded) directly, so that the model
+ * inlines into the loop. The Euler-Maruyama kernel is bit-identical
+ * to euler_maruyama_into.
+ *
+ * The *_OF macros compute in the floating type 'real' (float for
+ * PRECISION_SINGLE), times excepted; the others in double.
+ */
+typedef double (*scheme_step)(double time, double d_time, double pos,
+			      const double *brownian_motion,
+			      unsigned int factor);
+
+typedef double *(*scheme_kernel)(double max_time, double d_time, double init,
+				 const double *brownian_motion,
+				 unsigned int factor, double *path);
+
+#define EULER_MARUYAMA_STEP_OF(name, real, determ, stocha)		\
+  static inline real							\
+  name(double time, real d_time, real pos,				\
+       const real *brownian_motion, unsigned int factor)		\
+  {									\
+    real next = pos;							\
+									\
+    next += d_time * (real)determ(time, pos);				\
+    next += (brownian_motion[factor] - brownian_motion[0])		\
+      * (real)stocha(time, pos);					\
+									\
+    return next;							\
+  }
+
+#define MILSTEIN_STEP_OF(name, real, determ, stocha, stocha_derivative) \
+  static inline real							\
+  name(double time, real d_time, real pos,				\
+       const real *brownian_motion, unsigned int factor)		\
+  {									\
+    const real d_brownian = brownian_motion[factor]			\
+      - brownian_motion[0];						\
+    const real diffusion = stocha(time, pos);				\
+    real next = pos;							\
+									\
+    next += d_time * (real)determ(time, pos);				\
+    next += d_brownian * diffusion;					\
+    next += (real)0.5 * diffusion					\
+      * (real)stocha_derivative(time, pos)				\
+      * (d_brownian * d_brownian - d_time);				\
+									\
+    return next;							\
+  }
+
+#define RUNGE_KUTTA_STEP_OF(name, real, determ, stocha)			\
+  static inline real							\
+  name(double time, real d_time, real pos,				\
+       const real *brownian_motion, unsigned int factor)		\
+  {									\
+    const real d_brownian = brownian_motion[factor]			\
+      - brownian_motion[0];						\
+    const real sqrt_step = sqrt(d_time);				\
+    const real drift = d_time * (real)determ(time, pos);		\
+    const real diffusion = stocha(time, pos);				\
+    const real support = pos + drift + diffusion * sqrt_step;		\
+    real next = pos;							\
+									\
+    next += drift;							\
+    next += d_brownian * diffusion;					\
+    next += ((real)stocha(time, support) - diffusion)			\
+      * (d_brownian * d_brownian - d_time) / (2 * sqrt_step);		\
+									\
+    return next;							\
+  }
+
+/*
+ * Adaptive step built on 'step'. 'factor' must be a power of 2; the
+ * step is never refined below the precision of the Brownian motion.
+ */
+#define ADAPTIVE_STEP_OF(name, real, step, tolerance)			\
+  static real								\
+  name(double time, real d_time, real pos,				\
+       const real *brownian_motion, unsigned int factor)		\
+  {									\
+    const unsigned int half = factor / 2;				\
+    real whole, middle, next;						\
+									\
+    whole = step(time, d_time, pos, brownian_motion, factor);		\
+    if (half == 0) {							\
+      return whole;							\
+    }									\
+									\
+    middle = step(time - 0.5 * d_time, (real)0.5 * d_time, pos,	\
+		  brownian_motion, half);				\
+    next = step(time, (real)0.5 * d_time, middle,			\
+		brownian_motion + half, half);				\
+    if (fabs(next - whole) <= (tolerance)) {				\
+      return next;							\
+    }									\
+									\
+    middle = name(time - 0.5 * d_time, (real)0.5 * d_time, pos,	\
+		  brownian_motion, half);				\
+    return name(time, (real)0.5 * d_time, middle,			\
+		brownian_motion + half, half);				\
+  }
+
+#define SCHEME_KERNEL_OF(name, real, step)				\
+  static real *								\
+  name(double max_time, double d_time, real init,			\
+       const real *restrict brownian_motion, unsigned int factor,	\
+       real *restrict path)						\
+  {									\
+    const unsigned int steps = floor(max_time / d_time);		\
+									\
+    if (max_time <= 0) {						\
+      return NULL;							\
+    }									\
+									\
+    path[0] = init;							\
+    for (unsigned int j = 1; j < steps + 1; ++j) {			\
+      path[j] = step(j * d_time, d_time, path[j - 1],			\
+		     brownian_motion + (size_t)factor * (j - 1), factor); \
+    }									\
+									\
+    return path;							\
+  }
+
+#define EULER_MARUYAMA_STEP(name, determ, stocha)			\
+  EULER_MARUYAMA_STEP_OF(name, double, determ, stocha)
+
+#define MILSTEIN_STEP(name, determ, stocha, stocha_derivative)		\
+  MILSTEIN_STEP_OF(name, double, determ, stocha, stocha_derivative)
+
+#define RUNGE_KUTTA_STEP(name, determ, stocha)				\
+  RUNGE_KUTTA_STEP_OF(name, double, determ, stocha)
+
+#define ADAPTIVE_STEP(name, step, tolerance)				\
+  ADAPTIVE_STEP_OF(name, double, step, tolerance)
+
+#define SCHEME_KERNEL(name, step)					\
+  SCHEME_KERNEL_OF(name, double, step)
+
+/*
+ * Batched function: given the time and the positions of 'paths'
+ * paths, stores the 'paths' values of the function in 'out'. The
+ * float ones (batch_func_f) drive euler_maruyama_batch_f, whose lanes
+ * are twice as many per vector register.
+ *
+ * BATCH_FUNC_OF defines the batched function 'name' of the term
+ * 'func' (visible where the macro is expanded), as a plain loop over
+ * the paths that the compiler inlines and vectorizes.
+ */
+typedef void (*batch_func)(double time, const double *pos, double *out,
+			   unsigned int paths);
+
+typedef void (*batch_func_f)(double time, const float *pos, float *out,
+			     unsigned int paths);
+
+#define BATCH_FUNC_OF(name, real, func)					\
+  static inline void							\
+  name(double time, const real *pos, real *out, unsigned int paths)	\
+  {									\
+    for (unsigned int p = 0; p < paths; ++p) {				\
+      out[p] = func(time, pos[p]);					\
+    }									\
+  }
+
+extern double *
+euler_maruyama_batch(double max_time, double d_time, unsigned int paths, \
+		     const double *init, const double *brownian_motion,	\
+		     batch_func determ_func, batch_func stocha_func);
+
+extern double *
+euler_maruyama_batch_into(double max_time, double d_time,		\
+			  unsigned int paths, const double *init,	\
+			  const double *brownian_motion,		\
+			  batch_func determ_func, batch_func stocha_func, \
+			  double *path, double *terms);
+
+extern float *
+euler_maruyama_batch_f(double max_time, double d_time, unsigned int paths, \
+		       const float *init, const float *brownian_motion,	\
+		       batch_func_f determ_func, batch_func_f stocha_func);
+
+extern float *
+euler_maruyama_batch_into_f(double max_time, double d_time,		\
+			    unsigned int paths, const float *init,	\
+			    const float *brownian_motion,		\
+			    batch_func_f determ_func,			\
+			    batch_func_f stocha_func, float *path,	\
+			    float *terms);
+
 extern double *
 deterministic_ito_integral(double precision, double bound,	\
 			   double *brownian_motion,		\
 			   double (*func)(double real));
 
+extern double *
+deterministic_ito_integral_into(double precision, double bound,	\
+				const double *brownian_motion,	\
+				double (*func)(double real),	\
+				double *integral);
+
 extern double *
 linear_interpolation(double *data_set, unsigned int arr_size,	\
 		     unsigned int factor);
 
+extern double *
+linear_interpolation_into(const double *data_set, unsigned int arr_size, \
+			  unsigned int factor, double *ids);
+
 #endif /* NUMERICAL_APPROXIMATION_H */
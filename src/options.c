@@ -0,0 +1,632 @@
+/*
+ * Filename: options.c
+ *
+ * Summary: implements the run-time configuration of a simulation.
+ *
+ * Every parameter has a key, e.g. 'step_precision'. On the command
+ * line, it is given as '--step-precision VALUE' (or '--key=VALUE');
+ * in a configuration file, as a 'step_precision = VALUE' line, '#'
+ * starting a comment. Real values may be written as powers, e.g.
+ * '2^-7', and lists as comma-separated values.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "options.h"
+
+
+#define OPT_MAX_LINE 1024
+/* Configuration files read from configuration files, see 'config'. */
+#define OPT_MAX_DEPTH 8
+
+/* Short options and the key they stand for. */
+static const char *short_options[][2] = {{"-c", "config"}, {"-o", "output"},
+  {"-n", "iter"}, {"-j", "threads"}, {"-s", "seed"}};
+
+
+/* Names of the integration schemes. */
+static const struct
+{
+  const char *name;
+  scheme_kind scheme;
+} scheme_names[] = {{"euler", SCHEME_EULER}, {"milstein", SCHEME_MILSTEIN},
+  {"runge-kutta", SCHEME_RUNGE_KUTTA}, {"adaptive", SCHEME_ADAPTIVE}};
+
+
+/* Names of the precisions. */
+static const struct
+{
+  const char *name;
+  precision_kind precision;
+} precision_names[] = {{"double", PRECISION_DOUBLE},
+  {"single", PRECISION_SINGLE}};
+
+
+/* Names of the row policies. */
+static const struct
+{
+  const char *name;
+  row_policy rows;
+} row_names[] = {{"all", ROWS_ALL}, {"terminal", ROWS_TERMINAL},
+  {"every", ROWS_EVERY}, {"times", ROWS_TIMES}, {"summary", ROWS_SUMMARY}};
+
+
+static int
+parse_real(const char *text, double *value)
+{
+  /* Parse 'x' or 'x^y' (x to the power y), which must be finite. */
+  
+  char *end;
+  double base, exponent;
+
+  errno = 0;
+  base = strtod(text, &end);
+  if (end == text || errno != 0)
+  {
+    return OPT_ERR_VALUE;
+  }
+
+  if (*end == '^')
+  {
+    text = end + 1;
+    exponent = strtod(text, &end);
+    if (end == text || errno != 0)
+    {
+      return OPT_ERR_VALUE;
+    }
+    base = pow(base, exponent);
+  }
+
+  while (isspace((unsigned char)*end))
+  {
+    end++;
+  }
+
+  *value = base;
+  return (*end == '\0' || *end == ',') && isfinite(base) ? 0
+    : OPT_ERR_VALUE;
+} /* end of parse_real function */
+
+
+static int
+parse_uint(const char *text, unsigned long long *value)
+{
+  char *end;
+
+  while (isspace((unsigned char)*text))
+  {
+    text++;
+  }
+  if (*text == '-')
+  {
+    return OPT_ERR_VALUE;
+  }
+  
+  errno = 0;
+  *value = strtoull(text, &end, 10);
+  if (end == text || errno != 0)
+  {
+    return OPT_ERR_VALUE;
+  }
+  
+  while (isspace((unsigned char)*end))
+  {
+    end++;
+  }
+
+  return (*end == '\0' || *end == ',') ? 0 : OPT_ERR_VALUE;
+} /* end of parse_uint function */
+
+
+static int
+parse_unsigned(const char *text, unsigned int *value)
+{
+  unsigned long long number;
+
+  if (parse_uint(text, &number) != 0 || number > 0xFFFFFFFFULL)
+  {
+    return OPT_ERR_VALUE;
+  }
+
+  *value = number;
+  return 0;
+} /* end of parse_unsigned function */
+
+
+static int
+parse_shard(const char *text, unsigned int *shard, unsigned int *shards)
+{
+  /* Parse 'k/N', with 1 <= k <= N. */
+
+  const char *slash = strchr(text, '/');
+  char number[32];
+
+  if (slash == NULL || (size_t)(slash - text) >= sizeof number)
+  {
+    return OPT_ERR_VALUE;
+  }
+  snprintf(number, sizeof number, "%.*s", (int)(slash - text), text);
+
+  if (parse_unsigned(number, shard) != 0
+      || parse_unsigned(slash + 1, shards) != 0
+      || *shard < 1 || *shard > *shards)
+  {
+    return OPT_ERR_VALUE;
+  }
+
+  return 0;
+} /* end of parse_shard function */
+
+
+static int
+parse_real_list(const char *text, double *list, unsigned int *size)
+{
+  /* Parse at most OPT_MAX_SWEEP comma-separated real values. */
+  
+  *size = 0;
+
+  while (text != NULL && *text != '\0')
+  {
+    if (*size == OPT_MAX_SWEEP || parse_real(text, &list[*size]) != 0)
+    {
+      return OPT_ERR_VALUE;
+    }
+    (*size)++;
+    text = strchr(text, ',');
+    text = (text != NULL) ? text + 1 : NULL;
+  } /* end of while-loop */
+
+  return 0;
+} /* end of parse_real_list function */
+
+
+static int
+parse_uint_list(const char *text, unsigned int *list, unsigned int *size)
+{
+  /* Parse at most OPT_MAX_SWEEP comma-separated integer values. */
+  
+  unsigned long long value;
+  
+  *size = 0;
+
+  while (text != NULL && *text != '\0')
+  {
+    if (*size == OPT_MAX_SWEEP || parse_uint(text, &value) != 0
+	|| value > 0xFFFFFFFFULL)
+    {
+      return OPT_ERR_VALUE;
+    }
+    list[(*size)++] = value;
+    text = strchr(text, ',');
+    text = (text != NULL) ? text + 1 : NULL;
+  } /* end of while-loop */
+
+  return 0;
+} /* end of parse_uint_list function */
+
+
+static int
+parse_flag(const char *text, int *flag)
+{
+  /* A flag without value is set. */
+  
+  if (text == NULL || strcmp(text, "1") == 0 || strcmp(text, "yes") == 0
+      || strcmp(text, "true") == 0)
+  {
+    *flag = 1;
+  }
+  else if (strcmp(text, "0") == 0 || strcmp(text, "no") == 0
+	   || strcmp(text, "false") == 0)
+  {
+    *flag = 0;
+  }
+  else
+  {
+    return OPT_ERR_VALUE;
+  }
+
+  return 0;
+} /* end of parse_flag function */
+
+
+int
+set_option(run_config *config, const char *key, const char *value)
+{
+  /*
+   * Set the parameter 'key' ('-' and '_' are interchangeable) to
+   * 'value'. Only flags accept a NULL value.
+   *
+   * Returns 0 on success, a negative error code otherwise.
+   */
+  
+  char name[64];
+  unsigned long long number;
+  unsigned int k;
+
+  for (k = 0; key[k] != '\0' && k < sizeof name - 1; ++k)
+  {
+    name[k] = (key[k] == '-') ? '_' : key[k];
+  }
+  name[k] = '\0';
+
+  if (strcmp(name, "use_time") == 0)
+  {
+    return parse_flag(value, &config->use_time);
+  }
+  else if (strcmp(name, "resume") == 0)
+  {
+    return parse_flag(value, &config->resume);
+  }
+  else if (strcmp(name, "antithetic") == 0)
+  {
+    return parse_flag(value, &config->antithetic);
+  }
+
+  if (value == NULL)
+  {
+    return OPT_ERR_VALUE;
+  }
+
+  if (strncmp(name, "sweep_", 6) != 0
+      && strcmp(name, "observation_times") != 0 && strchr(value, ',') != NULL)
+  {
+    return OPT_ERR_VALUE;
+  }
+
+  if (strcmp(name, "config") == 0)
+  {
+    return parse_config_file(config, value);
+  }
+  else if (strcmp(name, "output") == 0 || strcmp(name, "filepath") == 0)
+  {
+    if (strlen(value) >= OPT_MAX_PATH || value[0] == '\0')
+    {
+      return OPT_ERR_VALUE;
+    }
+    strcpy(config->filepath, value);
+    return 0;
+  }
+  else if (strcmp(name, "seed") == 0)
+  {
+    if (parse_uint(value, &number) != 0)
+    {
+      return OPT_ERR_VALUE;
+    }
+    config->seed = number;
+    config->use_time = 0;
+    return 0;
+  }
+  else if (strcmp(name, "iter") == 0)
+  {
+    return parse_unsigned(value, &config->iter);
+  }
+  else if (strcmp(name, "threads") == 0)
+  {
+    return parse_unsigned(value, &config->threads);
+  }
+  else if (strcmp(name, "writers") == 0)
+  {
+    return parse_unsigned(value, &config->writers);
+  }
+  else if (strcmp(name, "checkpoint") == 0)
+  {
+    return parse_unsigned(value, &config->checkpoint);
+  }
+  else if (strcmp(name, "shard") == 0)
+  {
+    return parse_shard(value, &config->shard, &config->shards);
+  }
+  else if (strcmp(name, "float_prec") == 0)
+  {
+    return parse_unsigned(value, &config->float_prec);
+  }
+  else if (strcmp(name, "time_bound") == 0)
+  {
+    return parse_real(value, &config->time_bound);
+  }
+  else if (strcmp(name, "step_precision") == 0)
+  {
+    return parse_real(value, &config->step_precision);
+  }
+  else if (strcmp(name, "brownian_precision") == 0)
+  {
+    return parse_real(value, &config->brownian_precision);
+  }
+  else if (strcmp(name, "scheme") == 0)
+  {
+    for (k = 0; k < sizeof scheme_names / sizeof *scheme_names; ++k)
+    {
+      if (strcmp(value, scheme_names[k].name) == 0)
+      {
+	config->scheme = scheme_names[k].scheme;
+	return 0;
+      }
+    }
+    return OPT_ERR_VALUE;
+  }
+  else if (strcmp(name, "precision") == 0)
+  {
+    for (k = 0; k < sizeof precision_names / sizeof *precision_names; ++k)
+    {
+      if (strcmp(value, precision_names[k].name) == 0)
+      {
+	config->precision = precision_names[k].precision;
+	return 0;
+      }
+    }
+    return OPT_ERR_VALUE;
+  }
+  else if (strcmp(name, "mlmc") == 0)
+  {
+    return parse_real(value, &config->mlmc_epsilon);
+  }
+  else if (strcmp(name, "qmc") == 0 || strcmp(name, "qmc_replicates") == 0)
+  {
+    return parse_unsigned(value, &config->qmc_replicates);
+  }
+  else if (strcmp(name, "strata") == 0)
+  {
+    return parse_unsigned(value, &config->strata);
+  }
+  else if (strcmp(name, "rows") == 0)
+  {
+    for (k = 0; k < sizeof row_names / sizeof *row_names; ++k)
+    {
+      if (strcmp(value, row_names[k].name) == 0)
+      {
+	config->rows = row_names[k].rows;
+	return 0;
+      }
+    }
+    return OPT_ERR_VALUE;
+  }
+  else if (strcmp(name, "rows_step") == 0)
+  {
+    return parse_unsigned(value, &config->rows_step);
+  }
+  else if (strcmp(name, "observation_times") == 0)
+  {
+    return parse_real_list(value, config->observation_times,
+			   &config->observation_size);
+  }
+  else if (strcmp(name, "sweep_steps") == 0)
+  {
+    return parse_real_list(value, config->sweep_steps,
+			   &config->sweep_steps_size);
+  }
+  else if (strcmp(name, "sweep_brownian") == 0)
+  {
+    return parse_real_list(value, config->sweep_brownian,
+			   &config->sweep_brownian_size);
+  }
+  else if (strcmp(name, "sweep_iter") == 0)
+  {
+    return parse_uint_list(value, config->sweep_iter,
+			   &config->sweep_iter_size);
+  }
+
+  return OPT_ERR_UNKNOWN;
+} /* end of set_option function */
+
+
+int
+parse_config_file(run_config *config, const char *filename)
+{
+  /*
+   * Read 'key = value' lines. Empty lines and text following '#' are
+   * ignored. A 'config' line reads another file, up to OPT_MAX_DEPTH
+   * files deep.
+   *
+   * Returns 0 on success, a negative error code otherwise (the line
+   * is reported on the standard error).
+   */
+  
+  static unsigned int depth = 0;
+  FILE *input;
+  char line[OPT_MAX_LINE];
+  char *key, *value, *end;
+  unsigned int number = 0;
+  int status = 0;
+
+  if (depth >= OPT_MAX_DEPTH)
+  {
+    fprintf(stderr, "Fatal:   Configuration files nested too deep (%s).\n",
+	    filename);
+    return OPT_ERR_FILE;
+  }
+
+  input = fopen(filename, "r");
+  if (input == NULL)
+  {
+    fprintf(stderr, "Fatal:   Cannot open configuration file %s.\n",
+	    filename);
+    return OPT_ERR_FILE;
+  }
+
+  depth++;
+  while (status == 0 && fgets(line, OPT_MAX_LINE, input) != NULL)
+  {
+    number++;
+    
+    if ((end = strchr(line, '#')) != NULL)
+    {
+      *end = '\0';
+    }
+
+    key = line;
+    while (isspace((unsigned char)*key))
+    {
+      key++;
+    }
+    if (*key == '\0')
+    {
+      continue;
+    }
+
+    value = strchr(key, '=');
+    if (value != NULL)
+    {
+      *value++ = '\0';
+      while (isspace((unsigned char)*value))
+      {
+	value++;
+      }
+      end = value + strlen(value);
+      while (end > value && isspace((unsigned char)end[-1]))
+      {
+	*--end = '\0';
+      }
+    }
+    
+    end = key + strlen(key);
+    while (end > key && isspace((unsigned char)end[-1]))
+    {
+      *--end = '\0';
+    }
+
+    status = set_option(config, key, value);
+    if (status != 0)
+    {
+      fprintf(stderr, "Fatal:   %s:%u: invalid line for '%s'.\n", filename,
+	      number, key);
+    }
+  } /* end of while-loop */
+  depth--;
+
+  fclose(input);
+  
+  return status;
+} /* end of parse_config_file function */
+
+
+int
+parse_options(run_config *config, int argc, char **argv)
+{
+  /*
+   * Read the command line. Options are processed in order, so that
+   * an option given after '--config FILE' overrides the file.
+   *
+   * Returns 0 on success, OPT_HELP if the usage was requested, a
+   * negative error code otherwise (reported on the standard error).
+   */
+
+  const char *key, *value;
+  char name[64];
+  const char *equal;
+  int status;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    key = NULL;
+    value = NULL;
+    
+    if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0)
+    {
+      return OPT_HELP;
+    }
+
+    for (unsigned int k = 0; k < sizeof short_options
+	   / sizeof *short_options; ++k)
+    {
+      if (strcmp(argv[i], short_options[k][0]) == 0)
+      {
+	key = short_options[k][1];
+      }
+    }
+
+    if (key == NULL && strncmp(argv[i], "--", 2) == 0)
+    {
+      key = argv[i] + 2;
+      equal = strchr(key, '=');
+      
+      if (equal != NULL)
+      {
+	snprintf(name, sizeof name, "%.*s", (int)(equal - key), key);
+	key = name;
+	value = equal + 1;
+      }
+    }
+
+    if (key == NULL)
+    {
+      fprintf(stderr, "Fatal:   Unexpected argument '%s'.\n", argv[i]);
+      return OPT_ERR_UNKNOWN;
+    }
+
+    /* Flags may go without value. */
+    if (value == NULL && i + 1 < argc
+	&& strcmp(key, "use-time") != 0 && strcmp(key, "use_time") != 0
+	&& strcmp(key, "resume") != 0 && strcmp(key, "antithetic") != 0)
+    {
+      value = argv[++i];
+    }
+
+    status = set_option(config, key, value);
+    if (status == OPT_ERR_UNKNOWN)
+    {
+      fprintf(stderr, "Fatal:   Unknown option '%s'.\n", key);
+      return status;
+    }
+    else if (status != 0)
+    {
+      fprintf(stderr, "Fatal:   Invalid value for option '%s'.\n", key);
+      return status;
+    }
+  } /* end of for-loop */
+
+  return 0;
+} /* end of parse_options function */
+
+
+void
+print_usage(const char *program)
+{
+  printf("Usage: %s [OPTION VALUE]...\n\n", program);
+  printf("Options override the defaults set in config.h.\n\n");
+  printf("  -c, --config FILE             read 'key = value' lines from FILE\n");
+  printf("  -o, --output DIR              directory of output data\n");
+  printf("  -n, --iter N                  number of trajectories\n");
+  printf("  -j, --threads N               number of threads (0: every core)\n");
+  printf("      --writers N               number of writer threads (0: none)\n");
+  printf("  -s, --seed S                  seed of the generator\n");
+  printf("      --use-time                use a seed based on launch time\n");
+  printf("      --checkpoint N            store a checkpoint every N\n");
+  printf("                                trajectories (0: none)\n");
+  printf("      --resume                  resume from the last checkpoint\n");
+  printf("      --shard K/N               compute the K-th of N parts of the\n");
+  printf("                                trajectories (see merge_shards)\n");
+  printf("      --time-bound T            time bound\n");
+  printf("      --step-precision H        step of the approximation\n");
+  printf("      --brownian-precision H    step of the Brownian motion\n");
+  printf("      --float-prec P            printed precision\n");
+  printf("      --scheme NAME             euler, milstein, runge-kutta or\n");
+  printf("                                adaptive\n");
+  printf("      --precision NAME          double or single (see PRECISION)\n");
+  printf("      --mlmc EPSILON            multilevel Monte Carlo estimate of\n");
+  printf("                                E[f(X_T)] with RMSE below EPSILON\n");
+  printf("      --qmc R                   quasi-Monte Carlo with R replicates\n");
+  printf("      --antithetic              antithetic pairs of trajectories\n");
+  printf("      --strata S                stratify W(T) in S strata\n");
+  printf("      --rows POLICY             rows stored per trajectory: all,\n");
+  printf("                                terminal, every, times or summary\n");
+  printf("      --rows-step K             every K-th row (with --rows every)\n");
+  printf("      --observation-times T1,...\n");
+  printf("                                times of the rows stored with\n");
+  printf("                                --rows times\n");
+  printf("      --sweep-steps H1,H2,...   sweep over these steps\n");
+  printf("      --sweep-brownian H1,...   Brownian steps of the sweep\n");
+  printf("      --sweep-iter N1,N2,...    numbers of trajectories of the sweep\n");
+  printf("  -h, --help                    print this help\n\n");
+  printf("Real values may be written as powers, e.g. 2^-7.\n");
+} /* end of print_usage function */
@@ -0,0 +1,110 @@
+/*
+ * Filename: options.h
+ *
+ * Summary: defines the run-time configuration of a simulation, read
+ * from the command line and from configuration files.
+ *
+ * The values of config.h are the defaults; every value given at run
+ * time overrides them, so that a parameter sweep needs no rebuild.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+#include <stdint.h>
+
+#include "data_manipulation.h"
+#include "numerical_approximation.h"
+
+
+#define OPT_MAX_SWEEP 32
+#define OPT_MAX_PATH 4096
+
+typedef enum {OPT_HELP=1, OPT_ERR_UNKNOWN=-1024, OPT_ERR_VALUE, OPT_ERR_FILE}
+  opt_error_t;
+
+struct run_config
+{
+  char filepath[OPT_MAX_PATH];
+  uint64_t seed;
+  int use_time;
+  unsigned int iter;
+  unsigned int threads;
+  unsigned int writers;
+  unsigned int float_prec;
+  double time_bound;
+  double step_precision;
+  double brownian_precision;
+  scheme_kind scheme;
+  precision_kind precision;
+
+  /* Target root mean square error of the MLMC estimator, 0 if off. */
+  double mlmc_epsilon;
+
+  /*
+   * Trajectories between two checkpoints, 0 if off, and whether to
+   * resume from the last one (see CHECKPOINT in config.h).
+   */
+  unsigned int checkpoint;
+  int resume;
+
+  /*
+   * Shard 'shard' (from 1) of 'shards': the part of the trajectories
+   * computed by this process, see --shard.
+   */
+  unsigned int shard;
+  unsigned int shards;
+
+  /* Number of randomized quasi-Monte Carlo replicates, 0 if off. */
+  unsigned int qmc_replicates;
+
+  /*
+   * Variance reduction: antithetic pairs of paths, and the number of
+   * strata of W(T), 0 if off (see ANTITHETIC and STRATA in config.h).
+   */
+  int antithetic;
+  unsigned int strata;
+
+  /* Rows stored per trajectory (see ROWS in config.h). */
+  row_policy rows;
+  unsigned int rows_step;
+  unsigned int observation_size;
+  double observation_times[OPT_MAX_SWEEP];
+
+  /*
+   * Sweep grid. When sweep_steps is not empty, every (brownian
+   * precision, number of iterations) pair of the grid is simulated
+   * once, and every step precision is computed on the same Brownian
+   * paths. Empty brownian or iteration lists default to the single
+   * values above.
+   */
+  unsigned int sweep_steps_size;
+  double sweep_steps[OPT_MAX_SWEEP];
+  unsigned int sweep_brownian_size;
+  double sweep_brownian[OPT_MAX_SWEEP];
+  unsigned int sweep_iter_size;
+  unsigned int sweep_iter[OPT_MAX_SWEEP];
+};
+
+typedef struct run_config run_config;
+
+extern int
+set_option(run_config *config, const char *key, const char *value);
+
+extern int
+parse_config_file(run_config *config, const char *filename);
+
+extern int
+parse_options(run_config *config, int argc, char **argv);
+
+extern void
+print_usage(const char *program);
+
+
+#endif /* OPTIONS_H */
@@ -0,0 +1,223 @@
+/*
+ * Filename: prng.c
+ *
+ * Summary: implements the pseudo-random number generators used to
+ * simulate Brownian trajectories.
+ *
+ * Two generators are available: the counter-based Philox4x32-10
+ * generator (Salmon et al., "Parallel random numbers: as easy as 1,
+ * 2, 3", 2011) and the xoshiro256** generator (Blackman and Vigna,
+ * 2018). Both of them have a period far beyond the number of random
+ * numbers drawn by this program, unlike rand().
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#include "prng.h"
+
+
+#define PHILOX_M0 0xD2511F53U
+#define PHILOX_M1 0xCD9E8D57U
+#define PHILOX_W0 0x9E3779B9U
+#define PHILOX_W1 0xBB67AE85U
+#define PHILOX_ROUNDS 10
+
+
+static uint64_t
+splitmix64(uint64_t *x)
+{
+  /*
+   * Used to expand a 64-bit seed into a full xoshiro256** state, as
+   * recommended by the authors of the generator.
+   */
+
+  uint64_t z = (*x += 0x9E3779B97F4A7C15ULL);
+
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+  return z ^ (z >> 31);
+} /* end of splitmix64 function */
+
+
+static uint64_t
+rotl(uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+} /* end of rotl function */
+
+
+static void
+philox_block(prng_state *rng)
+{
+  /*
+   * Compute the block number 'rng->counter' of the stream: the
+   * counter is (counter, stream) seen as four 32-bit words, the key
+   * is the seed seen as two 32-bit words.
+   */
+
+  uint32_t ctr[4], key[2];
+  uint64_t prod0, prod1;
+
+  ctr[0] = (uint32_t)rng->counter;
+  ctr[1] = (uint32_t)(rng->counter >> 32);
+  ctr[2] = (uint32_t)rng->stream;
+  ctr[3] = (uint32_t)(rng->stream >> 32);
+  key[0] = (uint32_t)rng->seed;
+  key[1] = (uint32_t)(rng->seed >> 32);
+
+  for (unsigned int r = 0; r < PHILOX_ROUNDS; ++r)
+  {
+    prod0 = (uint64_t)PHILOX_M0 * ctr[0];
+    prod1 = (uint64_t)PHILOX_M1 * ctr[2];
+
+    ctr[0] = (uint32_t)(prod1 >> 32) ^ ctr[1] ^ key[0];
+    ctr[1] = (uint32_t)prod1;
+    ctr[2] = (uint32_t)(prod0 >> 32) ^ ctr[3] ^ key[1];
+    ctr[3] = (uint32_t)prod0;
+
+    key[0] += PHILOX_W0;
+    key[1] += PHILOX_W1;
+  } /* end of for-loop */
+
+  rng->block[0] = ((uint64_t)ctr[1] << 32) | ctr[0];
+  rng->block[1] = ((uint64_t)ctr[3] << 32) | ctr[2];
+} /* end of philox_block function */
+
+
+void
+prng_init(prng_state *rng, prng_kind kind, uint64_t seed, uint64_t stream)
+{
+  /*
+   * Initialize 'rng' so that it draws the stream number 'stream' of
+   * the generator 'kind' seeded with 'seed'. Two different streams
+   * never share any random number (Philox) or are statistically
+   * independent (xoshiro256**).
+   */
+
+  uint64_t mix;
+
+  rng->kind = kind;
+  rng->seed = seed;
+  rng->stream = stream;
+  rng->counter = 0;
+  rng->used = 2;
+
+  mix = seed;
+  mix ^= splitmix64(&stream);
+  for (unsigned int j = 0; j < 4; ++j)
+  {
+    rng->state[j] = splitmix64(&mix);
+  }
+} /* end of prng_init function */
+
+
+void
+prng_seek(prng_state *rng, uint64_t position)
+{
+  /*
+   * Position the stream so that the next call to prng_next returns
+   * the 'position'-th 64-bit word of the stream (starting from 0).
+   *
+   * Constant time for PRNG_PHILOX. For PRNG_XOSHIRO, the stream is
+   * restarted and 'position' words are discarded.
+   */
+
+  if (rng->kind == PRNG_PHILOX)
+  {
+    rng->counter = position / 2;
+    rng->used = position % 2;
+    philox_block(rng);
+    rng->counter++;
+  }
+  else
+  {
+    prng_init(rng, rng->kind, rng->seed, rng->stream);
+    for (uint64_t j = 0; j < position; ++j)
+    {
+      prng_next(rng);
+    }
+  }
+} /* end of prng_seek function */
+
+
+uint64_t
+prng_next(prng_state *rng)
+{
+  /*
+   * Returns the next 64-bit word of the stream.
+   */
+
+  uint64_t *s = rng->state;
+  uint64_t result, t;
+
+  if (rng->kind == PRNG_PHILOX)
+  {
+    if (rng->used == 2)
+    {
+      philox_block(rng);
+      rng->counter++;
+      rng->used = 0;
+    }
+    return rng->block[rng->used++];
+  }
+
+  result = rotl(s[1] * 5, 7) * 9;
+  t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+
+  return result;
+} /* end of prng_next function */
+
+
+double
+prng_uniform(prng_state *rng)
+{
+  /*
+   * Returns a number uniformly distributed over the open interval
+   * (0, 1), built from the 53 upper bits of the next word.
+   */
+
+  return ((double)(prng_next(rng) >> 11) + 0.5) * 0x1.0p-53;
+} /* end of prng_uniform function */
+
+
+double
+prng_uniform_at(const prng_state *rng, uint64_t position)
+{
+  /*
+   * Returns a number uniformly distributed over (0, 1) attached to
+   * 'position', leaving 'rng' untouched: the same position always
+   * gives the same number, whatever was drawn before.
+   *
+   * PRNG_PHILOX: the 'position'-th word of the stream, in constant
+   *   time.
+   * PRNG_XOSHIRO: the stream cannot be positioned cheaply, hence the
+   *   first word of a stream seeded by hashing (stream, position).
+   */
+
+  prng_state at = *rng;
+  uint64_t mix;
+
+  if (rng->kind == PRNG_PHILOX)
+  {
+    prng_seek(&at, position);
+  }
+  else
+  {
+    mix = rng->stream ^ (position * 0xD1B54A32D192ED03ULL);
+    prng_init(&at, rng->kind, rng->seed, splitmix64(&mix));
+  }
+
+  return prng_uniform(&at);
+} /* end of prng_uniform_at function */
@@ -0,0 +1,69 @@
+/*
+ * Filename: prng.h
+ *
+ * Summary: defines the pseudo-random number generators used to
+ * simulate Brownian trajectories.
+ *
+ * Every generator is driven by a (seed, stream) pair, so that each
+ * simulated path owns an independent stream of random numbers and may
+ * be reproduced on its own, whatever the order in which paths are
+ * computed.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#ifndef PRNG_H
+#define PRNG_H
+
+#include <stdint.h>
+
+
+typedef enum {PRNG_PHILOX=1, PRNG_XOSHIRO} prng_kind;
+
+struct prng_state
+{
+  /*
+   * State of a generator. Do not write in members manually, prefer
+   * using functions below.
+   *
+   * PRNG_PHILOX: Philox4x32-10 counter-based generator. The key is
+   *   built from the seed, the 128-bit counter from the stream and
+   *   the block position, hence the stream can be positioned
+   *   anywhere in constant time.
+   *
+   * PRNG_XOSHIRO: xoshiro256** generator. Streams are seeded by
+   *   hashing (seed, stream) with splitmix64.
+   */
+
+  prng_kind kind;
+  uint64_t seed;
+  uint64_t stream;
+  uint64_t state[4]; /* xoshiro256** state */
+  uint64_t counter;  /* Philox block counter */
+  uint64_t block[2]; /* last Philox block */
+  unsigned int used; /* number of words already drawn from block */
+};
+
+typedef struct prng_state prng_state;
+
+extern void
+prng_init(prng_state *rng, prng_kind kind, uint64_t seed, uint64_t stream);
+
+extern void
+prng_seek(prng_state *rng, uint64_t position);
+
+extern uint64_t
+prng_next(prng_state *rng);
+
+extern double
+prng_uniform(prng_state *rng);
+
+extern double
+prng_uniform_at(const prng_state *rng, uint64_t position);
+
+
+#endif /* PRNG_H */
@@ -0,0 +1,138 @@
+/*
+ * Filename: reference.c
+ *
+ * Summary: implements the closed-form reference solutions of linear
+ * SDEs.
+ *
+ * Paths are computed in lockstep, step by step: the loop over the
+ * paths of a step has no transcendental call for additive noise and
+ * is vectorized by the compiler.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#include <stddef.h>
+
+#include "reference.h"
+
+
+int
+reference_plan_init(reference_plan *plan, const linear_sde *sde, double step)
+{
+  /*
+   * Compute the constants of 'sde' over a step 'step' in 'plan'.
+   *
+   * Returns 0 on success, REFERENCE_ERR_NO_CLOSED_FORM if the noise
+   * is neither additive nor multiplicative (see reference.h).
+   */
+
+  plan->multiplicative = sde->c != 0;
+  if (plan->multiplicative)
+  {
+    if (sde->b != 0 || sde->d != 0)
+    {
+      return REFERENCE_ERR_NO_CLOSED_FORM;
+    }
+    plan->decay = 0;
+    plan->shift = 0;
+    plan->noise = sde->c;
+    plan->drift = (sde->a - 0.5 * sde->c * sde->c) * step;
+    return 0;
+  }
+
+  plan->decay = exp(sde->a * step);
+  plan->shift = sde->a != 0 ? sde->b * expm1(sde->a * step) / sde->a
+    : sde->b * step;
+  plan->noise = sde->d * plan->decay;
+  plan->drift = 0;
+
+  return 0;
+} /* end of reference_plan_init function */
+
+
+double *
+reference_linear_batch(const reference_plan *plan, unsigned int steps,
+		       unsigned int paths, const double *init,
+		       const double *brownian_motion, double *path)
+{
+  /*
+   * Compute the reference solution of 'paths' paths at once, over
+   * 'steps' steps of the plan.
+   *
+   * Parameters
+   * ----------
+   *
+   * init : array of double
+   *   Initial values, one per path.
+   *
+   * brownian_motion : array of double
+   *   'steps + 1' blocks of 'paths' values, value j of path p being
+   *   at j * paths + p (as in euler_maruyama_batch).
+   *
+   * path : array of double
+   *   Output, same layout as 'brownian_motion'.
+   *
+   *
+   * Returns
+   * -------
+   *
+   * 'path'. With one path, the values are the ones of
+   * reference_linear_step, applied step by step.
+   */
+
+  const double decay = plan->decay, shift = plan->shift;
+  const double noise = plan->noise, drift = plan->drift;
+
+  for (unsigned int p = 0; p < paths; ++p)
+  {
+    path[p] = init[p];
+  }
+
+  for (unsigned int j = 1; j <= steps; ++j)
+  {
+    const double *restrict prev = path + (size_t)(j - 1) * paths;
+    const double *restrict b_prev = brownian_motion
+      + (size_t)(j - 1) * paths;
+    const double *restrict b_cur = brownian_motion + (size_t)j * paths;
+    double *restrict cur = path + (size_t)j * paths;
+
+    if (plan->multiplicative)
+    {
+      for (unsigned int p = 0; p < paths; ++p)
+      {
+	cur[p] = prev[p] * exp(drift + noise * (b_cur[p] - b_prev[p]));
+      }
+      continue;
+    }
+
+    for (unsigned int p = 0; p < paths; ++p)
+    {
+      cur[p] = decay * prev[p] + shift + noise * (b_cur[p] - b_prev[p]);
+    }
+  } /* end of for-loop */
+
+  return path;
+} /* end of reference_linear_batch function */
+
+
+double
+reference_linear_mean(const linear_sde *sde, double init, double time)
+{
+  /*
+   * Returns E[X_time] for the solution of 'sde' from 'init', i.e. the
+   * solution of dm/dt = a m + b whatever the noise.
+   */
+
+  const double decay = exp(sde->a * time);
+
+  if (sde->a == 0)
+  {
+    return init + sde->b * time;
+  }
+
+  return decay * init + sde->b * expm1(sde->a * time) / sde->a;
+} /* end of reference_linear_mean function */
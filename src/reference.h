@@ -0,0 +1,109 @@
+/*
+ * Filename: reference.h
+ *
+ * Summary: defines the reference solutions computed along the
+ * approximations (see COMPARE in config.h), from the same Brownian
+ * increments.
+ *
+ * Linear SDEs,
+ *
+ *   dX_t = (a X_t + b) dt + (c X_t + d) dW_t,
+ *
+ * have a closed-form solution when the noise is additive (c = 0,
+ * e.g. Ornstein-Uhlenbeck) or multiplicative (b = d = 0, geometric
+ * Brownian motion). It is computed recursively over a step h:
+ *
+ *   additive:        X_{t+h} = e^{a h} X_t + b (e^{a h} - 1) / a
+ *                              + d e^{a h} (W_{t+h} - W_t),
+ *   multiplicative:  X_{t+h} = X_t exp((a - c^2 / 2) h
+ *                              + c (W_{t+h} - W_t)),
+ *
+ * the constants depending on h only being computed once (see
+ * reference_plan_init). The additive stochastic integral is taken at
+ * the left end of the step, as in the reference process of config.h.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#ifndef REFERENCE_H
+#define REFERENCE_H
+
+#include <math.h>
+
+
+typedef enum {REFERENCE_ERR_NO_CLOSED_FORM=-2560} reference_error_t;
+
+/*
+ * Reference solutions.
+ *
+ * REFERENCE_CUSTOM: the functions reference_start, reference_update
+ *   and reference_value of config.h, one Brownian increment at a
+ *   time.
+ * REFERENCE_LINEAR: the closed-form solution of a linear SDE (see
+ *   above), by reference_linear_batch.
+ */
+typedef enum {REFERENCE_CUSTOM=1, REFERENCE_LINEAR} reference_kind;
+
+struct linear_sde
+{
+  /* dX_t = (a X_t + b) dt + (c X_t + d) dW_t. */
+
+  double a;
+  double b;
+  double c;
+  double d;
+};
+
+struct reference_plan
+{
+  /*
+   * Constants of a linear SDE over a step, see reference_plan_init.
+   * Do not write in members manually.
+   */
+
+  double decay;          /* additive: e^{a h} */
+  double shift;          /* additive: b (e^{a h} - 1) / a */
+  double noise;          /* additive: d e^{a h}; multiplicative: c */
+  double drift;          /* multiplicative: (a - c^2 / 2) h */
+  int multiplicative;
+};
+
+typedef struct linear_sde linear_sde;
+typedef struct reference_plan reference_plan;
+
+
+static inline double
+reference_linear_step(const reference_plan *plan, double pos,
+		      double d_brownian)
+{
+  /*
+   * The solution at the end of a step from 'pos' at its beginning,
+   * 'd_brownian' being the increment of the Brownian motion over it.
+   */
+
+  if (plan->multiplicative)
+  {
+    return pos * exp(plan->drift + plan->noise * d_brownian);
+  }
+
+  return plan->decay * pos + plan->shift + plan->noise * d_brownian;
+} /* end of reference_linear_step function */
+
+
+extern int
+reference_plan_init(reference_plan *plan, const linear_sde *sde, double step);
+
+extern double *
+reference_linear_batch(const reference_plan *plan, unsigned int steps,
+		       unsigned int paths, const double *init,
+		       const double *brownian_motion, double *path);
+
+extern double
+reference_linear_mean(const linear_sde *sde, double init, double time);
+
+
+#endif /* REFERENCE_H */
@@ -0,0 +1,198 @@
+/*
+ * Filename: sobol.c
+ *
+ * Summary: implements scrambled Sobol' sequences, used to build
+ * Brownian paths by quasi-Monte Carlo.
+ *
+ * Direction numbers are those of Joe and Kuo (see sobol_table.c).
+ * Points are scrambled by the hash-based approximation of Owen's
+ * nested uniform scrambling of Burley ("Practical hash-based Owen
+ * scrambling", JCGT 9(4), 2020): every replicate is an independent
+ * randomization of the sequence, uniformly distributed over the unit
+ * cube, while keeping its low discrepancy. Means of independent
+ * replicates give confidence intervals.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#include <stdlib.h>
+
+#include "sobol.h"
+
+
+/* Streams of the scrambling seeds, disjoint from the paths' ones. */
+#define SOBOL_STREAM (1ULL << 63)
+
+
+static uint32_t
+reverse_bits(uint32_t x)
+{
+  x = ((x >> 1) & 0x55555555U) | ((x & 0x55555555U) << 1);
+  x = ((x >> 2) & 0x33333333U) | ((x & 0x33333333U) << 2);
+  x = ((x >> 4) & 0x0F0F0F0FU) | ((x & 0x0F0F0F0FU) << 4);
+  x = ((x >> 8) & 0x00FF00FFU) | ((x & 0x00FF00FFU) << 8);
+  
+  return (x >> 16) | (x << 16);
+} /* end of reverse_bits function */
+
+
+static uint32_t
+owen_scramble(uint32_t x, uint32_t seed)
+{
+  /*
+   * Every bit is flipped according to a hash of the bits above it
+   * (below it once reversed), as in a nested uniform scrambling.
+   */
+  
+  x = reverse_bits(x);
+  x ^= x * 0x3D20ADEAU;
+  x += seed;
+  x *= (seed >> 16) | 1;
+  x ^= x * 0x05526C56U;
+  x ^= x * 0x53A22864U;
+  
+  return reverse_bits(x);
+} /* end of owen_scramble function */
+
+
+static void
+sobol_directions(uint32_t *v, unsigned int d)
+{
+  /*
+   * Direction numbers v_k = m_k 2^(32 - k) of the coordinate d (from
+   * 0, the first coordinate being the van der Corput sequence), m_k
+   * following the recurrence of the primitive polynomial.
+   */
+
+  unsigned int degree = 0;
+  uint32_t poly, m[SOBOL_BITS];
+
+  if (d == 0)
+  {
+    for (unsigned int k = 0; k < SOBOL_BITS; ++k)
+    {
+      v[k] = 1U << (SOBOL_BITS - 1 - k);
+    }
+    return;
+  }
+
+  poly = sobol_polynomials[d - 1];
+  while (poly >> (degree + 1))
+  {
+    degree++;
+  }
+  
+  for (unsigned int k = 0; k < SOBOL_BITS; ++k)
+  {
+    if (k < degree)
+    {
+      m[k] = sobol_initial[d - 1][k];
+      continue;
+    }
+    
+    m[k] = m[k - degree] ^ (m[k - degree] << degree);
+    for (unsigned int j = 1; j < degree; ++j)
+    {
+      if ((poly >> (degree - j)) & 1)
+      {
+	m[k] ^= m[k - j] << j;
+      }
+    }
+  }
+
+  for (unsigned int k = 0; k < SOBOL_BITS; ++k)
+  {
+    v[k] = m[k] << (SOBOL_BITS - 1 - k);
+  }
+} /* end of sobol_directions function */
+
+
+int
+sobol_init(sobol_sequence *seq, unsigned int dimension,
+	   unsigned int replicates, prng_kind kind, uint64_t seed)
+{
+  /*
+   * Compute the direction numbers of the first 'dimension'
+   * coordinates (at most SOBOL_MAX_DIMENSION) and draw the scrambling
+   * seeds of 'replicates' replicates from the generator. Returns 0 on
+   * success, SOBOL_ERR_ALLOC otherwise.
+   */
+
+  prng_state rng;
+  
+  if (dimension > SOBOL_MAX_DIMENSION)
+  {
+    dimension = SOBOL_MAX_DIMENSION;
+  }
+
+  seq->dimension = dimension;
+  seq->replicates = replicates;
+  seq->directions = malloc((size_t)dimension * SOBOL_BITS
+			   * sizeof *seq->directions);
+  seq->scrambles = malloc((size_t)dimension * replicates
+			  * sizeof *seq->scrambles);
+
+  if (seq->directions == NULL || seq->scrambles == NULL)
+  {
+    sobol_free(seq);
+    return SOBOL_ERR_ALLOC;
+  }
+
+  for (unsigned int d = 0; d < dimension; ++d)
+  {
+    sobol_directions(seq->directions + (size_t)d * SOBOL_BITS, d);
+  }
+
+  for (unsigned int r = 0; r < replicates; ++r)
+  {
+    prng_init(&rng, kind, seed, SOBOL_STREAM | r);
+    for (unsigned int d = 0; d < dimension; ++d)
+    {
+      seq->scrambles[(size_t)r * dimension + d] = prng_next(&rng) >> 32;
+    }
+  }
+
+  return 0;
+} /* end of sobol_init function */
+
+
+void
+sobol_free(sobol_sequence *seq)
+{
+  free(seq->directions);
+  free(seq->scrambles);
+  seq->directions = NULL;
+  seq->scrambles = NULL;
+} /* end of sobol_free function */
+
+
+double
+sobol_uniform(const sobol_sequence *seq, unsigned int replicate,
+	      uint32_t point, unsigned int coordinate)
+{
+  /*
+   * Coordinate 'coordinate' of the point number 'point' of the
+   * replicate, in (0, 1). Points are computed directly from their
+   * index, so that they may be drawn in any order.
+   */
+
+  const uint32_t *v = seq->directions + (size_t)coordinate * SOBOL_BITS;
+  uint32_t x = 0;
+
+  for (unsigned int k = 0; point != 0; ++k, point >>= 1)
+  {
+    if (point & 1)
+    {
+      x ^= v[k];
+    }
+  }
+
+  x = owen_scramble(x, seq->scrambles[(size_t)replicate * seq->dimension
+				      + coordinate]);
+  
+  return ((double)x + 0.5) * 0x1.0p-32;
+} /* end of sobol_uniform function */
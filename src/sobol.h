@@ -0,0 +1,63 @@
+/*
+ * Filename: sobol.h
+ *
+ * Summary: defines scrambled Sobol' sequences, used to build Brownian
+ * paths by quasi-Monte Carlo.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#ifndef SOBOL_H
+#define SOBOL_H
+
+#include <stdint.h>
+
+#include "prng.h"
+
+
+#define SOBOL_MAX_DIMENSION 1024
+#define SOBOL_MAX_DEGREE 13
+#define SOBOL_BITS 32
+
+typedef enum {SOBOL_ERR_ALLOC=-1792} sobol_error_t;
+
+struct sobol_sequence
+{
+  /*
+   * The first 'dimension' coordinates of the Sobol' sequence, with
+   * 'replicates' independent scramblings.
+   *
+   * directions[d * SOBOL_BITS + k] is the k-th direction number of
+   * the coordinate d, scrambles[r * dimension + d] the seed of the
+   * scrambling of the coordinate d in the replicate r.
+   */
+
+  unsigned int dimension;
+  unsigned int replicates;
+  uint32_t *directions;
+  uint32_t *scrambles;
+};
+
+typedef struct sobol_sequence sobol_sequence;
+
+extern const unsigned short sobol_polynomials[SOBOL_MAX_DIMENSION - 1];
+extern const unsigned short
+sobol_initial[SOBOL_MAX_DIMENSION - 1][SOBOL_MAX_DEGREE];
+
+extern int
+sobol_init(sobol_sequence *seq, unsigned int dimension,
+	   unsigned int replicates, prng_kind kind, uint64_t seed);
+
+extern void
+sobol_free(sobol_sequence *seq);
+
+extern double
+sobol_uniform(const sobol_sequence *seq, unsigned int replicate,
+	      uint32_t point, unsigned int coordinate);
+
+
+#endif /* SOBOL_H */
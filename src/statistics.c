@@ -0,0 +1,698 @@
+/*
+ * Filename: statistics.c
+ *
+ * Summary: implements online estimators of the mean and the variance
+ * of a quantity computed along a Monte Carlo simulation.
+ *
+ * Values are pushed one at a time with Welford's algorithm, and two
+ * accumulators may be merged (Chan et al.), e.g. accumulators filled
+ * by different threads. Merging is exact up to rounding, so merging
+ * always in the same order gives bit-identical results. The updates
+ * of the mean and of the sum of squares are compensated (Kahan), so
+ * that pushing millions of values into one accumulator does not lose
+ * their last digits.
+ *
+ * The accumulators of the blocks of a run are stored in a file
+ * (little-endian, whatever the host, so that shards computed on
+ * different nodes are merged on any of them):
+ *
+ *   magic string "EDSSTAT\0"                 (8 bytes)
+ *   version (4)                              (uint32)
+ *   reserved                                 (uint32)
+ *   seed, iter                               (2 uint64)
+ *   step, confidence                         (2 float64)
+ *   quantities, profile_size, blocks, first,
+ *   last, replicates, float_prec, precision,
+ *   functional, antithetic, control, strata  (12 uint32)
+ *   control_mean                             (float64)
+ *   the blocks 'first' to 'last' - 1, every
+ *   accumulator as count (uint64), mean, m2,
+ *   mean_error and m2_error (4 float64)
+ *
+ * so that the shards of a run are merged afterwards, as if the run
+ * was computed at once.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "statistics.h"
+
+
+/* Bytes of the header of a file, and of an accumulator in a file. */
+#define STAT_HEADER_SIZE 104
+#define STAT_ACC_SIZE 40
+
+
+/* Labels of the quantities at time T, see struct stat_blocks. */
+static const char *const quantity_names[STAT_QUANTITIES] = {"approximation",
+  "reference", "strong_error", "weak_error"};
+
+/* Labels of f(X_T), plain then with variance reduction (stat_reduce). */
+static const char *const functional_names[2] = {"functional",
+  "functional_reduced"};
+
+
+void
+acc_init(accumulator *acc)
+{
+  acc->count = 0;
+  acc->mean = 0.0;
+  acc->m2 = 0.0;
+  acc->mean_error = 0.0;
+  acc->m2_error = 0.0;
+} /* end of acc_init function */
+
+
+static inline void
+compensated_add(double *sum, double *error, double term)
+{
+  /* Kahan summation: *error holds what *sum lost to rounding. */
+  
+  const double corrected = term - *error;
+  const double next = *sum + corrected;
+
+  *error = (next - *sum) - corrected;
+  *sum = next;
+} /* end of compensated_add function */
+
+
+void
+acc_push(accumulator *acc, double value)
+{
+  double delta = value - acc->mean;
+
+  acc->count++;
+  compensated_add(&acc->mean, &acc->mean_error, delta / acc->count);
+  compensated_add(&acc->m2, &acc->m2_error, delta * (value - acc->mean));
+} /* end of acc_push function */
+
+
+void
+acc_merge(accumulator *acc, const accumulator *other)
+{
+  /*
+   * Add the values pushed in 'other' to 'acc'. The compensations of
+   * both are folded in the merged mean and sum of squares.
+   */
+  
+  unsigned long long count = acc->count + other->count;
+  const double mean = acc->mean - acc->mean_error;
+  double delta = (other->mean - other->mean_error) - mean;
+
+  if (other->count == 0)
+  {
+    return;
+  }
+
+  acc->mean = mean + delta * ((double)other->count / count);
+  acc->m2 = (acc->m2 - acc->m2_error) + (other->m2 - other->m2_error)
+    + delta * delta * ((double)acc->count * other->count / count);
+  acc->mean_error = 0.0;
+  acc->m2_error = 0.0;
+  acc->count = count;
+} /* end of acc_merge function */
+
+
+double
+acc_variance(const accumulator *acc)
+{
+  /* Unbiased estimator of the variance. */
+  
+  if (acc->count < 2)
+  {
+    return 0.0;
+  }
+
+  return acc->m2 / (acc->count - 1);
+} /* end of acc_variance function */
+
+
+double
+acc_half_width(const accumulator *acc, double confidence)
+{
+  /*
+   * Half width of the (asymptotic, normal) confidence interval of
+   * level 'confidence' around the mean, e.g. 0.95.
+   */
+
+  if (acc->count == 0)
+  {
+    return 0.0;
+  }
+  
+  return normal_quantile(0.5 + 0.5 * confidence)
+    * sqrt(acc_variance(acc) / acc->count);
+} /* end of acc_half_width function */
+
+
+double
+normal_quantile(double p)
+{
+  /*
+   * Quantile function of the standard normal distribution, over the
+   * open interval (0, 1).
+   *
+   * Rational approximation of P. J. Acklam (relative error below
+   * 1.15e-9), refined by one step of Halley's method using erfc.
+   */
+
+  static const double a[6] = {-3.969683028665376e+01, 2.209460984245205e+02,
+    -2.759285104469687e+02, 1.383577518672690e+02, -3.066479806614716e+01,
+    2.506628277459239e+00};
+  static const double b[5] = {-5.447609879822406e+01, 1.615858368580409e+02,
+    -1.556989798598866e+02, 6.680131188771972e+01, -1.328068155288572e+01};
+  static const double c[6] = {-7.784894002430293e-03, -3.223964580411365e-01,
+    -2.400758277161838e+00, -2.549732539343734e+00, 4.374664141464968e+00,
+    2.938163982698783e+00};
+  static const double d[4] = {7.784695709041462e-03, 3.224671290700398e-01,
+    2.445134137142996e+00, 3.754408661907416e+00};
+  const double p_low = 0.02425;
+
+  double q, r, x, e, u;
+
+  if (p <= 0.0)
+  {
+    return -HUGE_VAL;
+  }
+  if (p >= 1.0)
+  {
+    return HUGE_VAL;
+  }
+
+  if (p < p_low)
+  {
+    q = sqrt(-2.0 * log(p));
+    x = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5])
+      / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+  }
+  else if (p <= 1.0 - p_low)
+  {
+    q = p - 0.5;
+    r = q * q;
+    x = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5])
+      * q / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r
+	     + 1.0);
+  }
+  else
+  {
+    q = sqrt(-2.0 * log(1.0 - p));
+    x = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5])
+      / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+  }
+
+  e = 0.5 * erfc(-x / sqrt(2.0)) - p;
+  u = e * 2.50662827463100050242 * exp(0.5 * x * x); /* sqrt(2 pi) */
+
+  return x - u / (1.0 + 0.5 * x * u);
+} /* end of normal_quantile function */
+
+
+int
+print_acc_in_csv(FILE *output, const char *label, const accumulator *acc,
+		 double confidence, unsigned int precision)
+{
+  /*
+   * Print one line 'label,count,mean,variance,low,high' where [low,
+   * high] is the confidence interval of level 'confidence' around
+   * the mean.
+   */
+
+  double half_width = acc_half_width(acc, confidence);
+
+  if (output == NULL)
+  {
+    return -1;
+  }
+  
+  return fprintf(output, "%s,%llu,%.*f,%.*f,%.*f,%.*f\n", label, acc->count,
+		 (int)precision, acc->mean,
+		 (int)precision, acc_variance(acc),
+		 (int)precision, acc->mean - half_width,
+		 (int)precision, acc->mean + half_width);
+} /* end of print_acc_in_csv function */
+
+
+size_t
+stat_block_size(const stat_blocks *set)
+{
+  /* Number of accumulators of a block. */
+
+  return (size_t)set->quantities + set->profile_size;
+} /* end of stat_block_size function */
+
+
+int
+stat_blocks_init(stat_blocks *set)
+{
+  /*
+   * Allocate the (empty) accumulators of every block of 'set', whose
+   * other members are set. MUST BE FREE'D with stat_blocks_free!
+   *
+   * Returns 0 on success, STAT_ERR_ALLOC otherwise.
+   */
+
+  set->data = NULL;
+  if (set->quantities > STAT_QUANTITIES + STAT_REDUCED
+      || (set->functional > 0
+	  && set->functional + STAT_REDUCED != set->quantities))
+  {
+    return STAT_ERR_ALLOC;
+  }
+
+  /* Zeroed accumulators are empty accumulators (see acc_init). */
+  set->data = calloc((size_t)set->blocks * stat_block_size(set),
+		     sizeof *set->data);
+
+  return set->data != NULL || set->blocks == 0 ? 0 : STAT_ERR_ALLOC;
+} /* end of stat_blocks_init function */
+
+
+void
+stat_blocks_free(stat_blocks *set)
+{
+  free(set->data);
+  set->data = NULL;
+} /* end of stat_blocks_free function */
+
+
+static void
+store_le(unsigned char *dest, uint64_t value, unsigned int bytes)
+{
+  for (unsigned int k = 0; k < bytes; ++k)
+  {
+    dest[k] = (unsigned char)(value >> (8 * k));
+  }
+} /* end of store_le function */
+
+
+static uint64_t
+load_le(const unsigned char *src, unsigned int bytes)
+{
+  uint64_t value = 0;
+  
+  for (unsigned int k = 0; k < bytes; ++k)
+  {
+    value |= (uint64_t)src[k] << (8 * k);
+  }
+
+  return value;
+} /* end of load_le function */
+
+
+static void
+store_double(unsigned char *dest, double value)
+{
+  uint64_t bits;
+
+  memcpy(&bits, &value, sizeof bits);
+  store_le(dest, bits, 8);
+} /* end of store_double function */
+
+
+static double
+load_double(const unsigned char *src)
+{
+  const uint64_t bits = load_le(src, 8);
+  double value;
+
+  memcpy(&value, &bits, sizeof value);
+  return value;
+} /* end of load_double function */
+
+
+static void
+store_stat_header(unsigned char *dest, const stat_blocks *set)
+{
+  /* The first STAT_HEADER_SIZE bytes of a file, see above. */
+
+  const uint32_t fields[12] = {set->quantities, set->profile_size,
+    set->blocks, set->first, set->last, set->replicates, set->float_prec,
+    set->precision, set->functional, set->antithetic, set->control,
+    set->strata};
+
+  memcpy(dest, STAT_MAGIC, 8);
+  store_le(dest + 8, STAT_VERSION, 4);
+  store_le(dest + 12, 0, 4);
+  store_le(dest + 16, set->seed, 8);
+  store_le(dest + 24, set->iter, 8);
+  store_double(dest + 32, set->step);
+  store_double(dest + 40, set->confidence);
+  for (unsigned int k = 0; k < 12; ++k)
+  {
+    store_le(dest + 48 + 4 * k, fields[k], 4);
+  }
+  store_double(dest + 96, set->control_mean);
+} /* end of store_stat_header function */
+
+
+static int
+load_stat_header(const unsigned char *src, stat_blocks *set)
+{
+  /* Read a header stored by store_stat_header. Returns 0 if valid. */
+
+  uint32_t *fields[12] = {&set->quantities, &set->profile_size,
+    &set->blocks, &set->first, &set->last, &set->replicates,
+    &set->float_prec, &set->precision, &set->functional, &set->antithetic,
+    &set->control, &set->strata};
+
+  if (memcmp(src, STAT_MAGIC, 8) != 0 || load_le(src + 8, 4) != STAT_VERSION)
+  {
+    return STAT_ERR_FORMAT;
+  }
+
+  set->seed = load_le(src + 16, 8);
+  set->iter = load_le(src + 24, 8);
+  set->step = load_double(src + 32);
+  set->confidence = load_double(src + 40);
+  for (unsigned int k = 0; k < 12; ++k)
+  {
+    *fields[k] = load_le(src + 48 + 4 * k, 4);
+  }
+  set->control_mean = load_double(src + 96);
+
+  return set->first > set->last || set->last > set->blocks
+    ? STAT_ERR_FORMAT : 0;
+} /* end of load_stat_header function */
+
+
+int
+stat_blocks_store(const char *filename, const stat_blocks *set)
+{
+  /*
+   * Store the blocks 'first' to 'last' - 1 of 'set' in 'filename'.
+   * Returns 0 on success, STAT_ERR_OPEN otherwise.
+   */
+
+  const size_t size = stat_block_size(set);
+  const accumulator *acc = set->data + set->first * size;
+  const accumulator *end = set->data + set->last * size;
+  unsigned char header[STAT_HEADER_SIZE], bytes[STAT_ACC_SIZE];
+  FILE *output = fopen(filename, "wb");
+  int status = 0;
+
+  if (output == NULL)
+  {
+    return STAT_ERR_OPEN;
+  }
+
+  store_stat_header(header, set);
+  if (fwrite(header, sizeof header, 1, output) != 1)
+  {
+    status = STAT_ERR_OPEN;
+  }
+
+  for (; status == 0 && acc < end; ++acc)
+  {
+    store_le(bytes, acc->count, 8);
+    store_double(bytes + 8, acc->mean);
+    store_double(bytes + 16, acc->m2);
+    store_double(bytes + 24, acc->mean_error);
+    store_double(bytes + 32, acc->m2_error);
+    if (fwrite(bytes, sizeof bytes, 1, output) != 1)
+    {
+      status = STAT_ERR_OPEN;
+    }
+  } /* end of for-loop */
+
+  if (fclose(output) != 0)
+  {
+    status = STAT_ERR_OPEN;
+  }
+
+  return status;
+} /* end of stat_blocks_store function */
+
+
+int
+stat_blocks_load(const char *filename, stat_blocks *set)
+{
+  /*
+   * Read the blocks stored in 'filename' in 'set', the others being
+   * empty. MUST BE FREE'D with stat_blocks_free!
+   *
+   * Returns 0 on success, a negative error code otherwise.
+   */
+
+  FILE *input = fopen(filename, "rb");
+  unsigned char header[STAT_HEADER_SIZE], bytes[STAT_ACC_SIZE];
+  accumulator *acc, *end;
+  size_t size;
+  int status = 0;
+
+  set->data = NULL;
+  if (input == NULL)
+  {
+    return STAT_ERR_OPEN;
+  }
+
+  if (fread(header, sizeof header, 1, input) != 1
+      || load_stat_header(header, set) != 0)
+  {
+    fclose(input);
+    return STAT_ERR_FORMAT;
+  }
+
+  status = stat_blocks_init(set);
+  size = stat_block_size(set);
+  acc = set->data + set->first * size;
+  end = set->data + set->last * size;
+  for (; status == 0 && acc < end; ++acc)
+  {
+    if (fread(bytes, sizeof bytes, 1, input) != 1)
+    {
+      stat_blocks_free(set);
+      status = STAT_ERR_FORMAT;
+      break;
+    }
+    acc->count = load_le(bytes, 8);
+    acc->mean = load_double(bytes + 8);
+    acc->m2 = load_double(bytes + 16);
+    acc->mean_error = load_double(bytes + 24);
+    acc->m2_error = load_double(bytes + 32);
+  } /* end of for-loop */
+
+  fclose(input);
+
+  return status;
+} /* end of stat_blocks_load function */
+
+
+void
+stat_merge(const stat_blocks *set, accumulator *total)
+{
+  /*
+   * Merge the blocks 'first' to 'last' - 1 of 'set', in order, into
+   * 'total' (the accumulators of a block). With replicates, the
+   * quantities at time T are the replicates' means instead.
+   */
+
+  const size_t size = stat_block_size(set);
+  const accumulator *block;
+
+  for (size_t k = 0; k < size; ++k)
+  {
+    acc_init(&total[k]);
+  }
+
+  for (unsigned int b = set->first; b < set->last; ++b)
+  {
+    block = set->data + b * size;
+    for (size_t k = 0; k < size; ++k)
+    {
+      acc_merge(&total[k], &block[k]);
+    }
+  }
+
+  if (set->replicates == 0)
+  {
+    return;
+  }
+
+  for (unsigned int k = 0; k < set->quantities; ++k)
+  {
+    acc_init(&total[k]);
+    for (unsigned int b = set->first; b < set->last; ++b)
+    {
+      acc_push(&total[k], set->data[b * size + k].mean);
+    }
+  }
+} /* end of stat_merge function */
+
+
+void
+stat_reduce(const stat_blocks *set, const accumulator *total,
+	    accumulator *reduced)
+{
+  /*
+   * Estimator of E[f(X_T)] with variance reduction, from the samples
+   * of the blocks 'first' to 'last' - 1 (see struct stat_blocks) and
+   * their merge 'total' (see stat_merge), as an accumulator of every
+   * path: its variance is the variance of the estimator times the
+   * number of paths, so that acc_half_width gives its confidence
+   * interval, and the variance of f(X_T) divided by it is the gain in
+   * effective sample size.
+   *
+   * Strata (the blocks, if set->strata > 0, the whole run otherwise)
+   * are equally likely. With the s-th of S strata of n_s samples,
+   *
+   *   F = sum_s mean_s(f) / S - beta (sum_s mean_s(Z) / S - E[Z]),
+   *   Var(F) = (sum_s Var_s(f - beta Z) / n_s) / S^2,
+   *
+   * beta = sum_s Cov_s(f, Z) / n_s / sum_s Var_s(Z) / n_s minimizing
+   * Var(F) (0 without control variate). Covariances are the halved
+   * differences Var(f + Z) - Var(f) - Var(Z).
+   */
+
+  const size_t size = stat_block_size(set);
+  const unsigned int end = set->strata > 0 ? set->last : 1;
+  const accumulator *sample;
+  unsigned long long paths = total[set->functional].count;
+  double mean = 0, control = 0, variance = 0, variance_z = 0;
+  double covariance = 0, beta = 0, n;
+  unsigned int used = 0;
+
+  acc_init(reduced);
+  if (set->functional == 0)
+  {
+    return;
+  }
+
+  for (unsigned int s = set->strata > 0 ? set->first : 0; s < end; ++s)
+  {
+    sample = (set->strata > 0 ? set->data + s * size : total)
+      + set->functional + 1;
+    if (sample[0].count == 0)
+    {
+      continue;
+    }
+
+    n = sample[0].count;
+    used++;
+    mean += sample[0].mean;
+    control += sample[1].mean;
+    variance += acc_variance(&sample[0]) / n;
+    variance_z += acc_variance(&sample[1]) / n;
+    covariance += 0.5 * (acc_variance(&sample[2]) - acc_variance(&sample[0])
+			 - acc_variance(&sample[1])) / n;
+  } /* end of for-loop */
+
+  if (used == 0)
+  {
+    return;
+  }
+
+  if (set->control && variance_z > 0)
+  {
+    beta = covariance / variance_z;
+  }
+
+  reduced->count = paths;
+  reduced->mean = mean / used - beta * (control / used - set->control_mean);
+  reduced->m2 = (variance - beta * covariance) / ((double)used * used)
+    * paths * (paths - 1.0);
+} /* end of stat_reduce function */
+
+
+double
+stat_ess_gain(const accumulator *plain, const accumulator *reduced)
+{
+  /*
+   * Gain in effective sample size of the estimator 'reduced' of
+   * f(X_T) with variance reduction (see stat_reduce) over the plain
+   * one: the ratio of their variances, or INFINITY if the variance of
+   * 'reduced' vanishes, or is within the rounding of the plain one
+   * (e.g. an antithetic linear f: the reduced estimator is exact).
+   */
+
+  const double variance = acc_variance(reduced);
+
+  return variance <= DBL_EPSILON * acc_variance(plain) ? INFINITY
+    : acc_variance(plain) / variance;
+} /* end of stat_ess_gain function */
+
+
+int
+stat_write_csv(const char *directory, const stat_blocks *set,
+	       const accumulator *total)
+{
+  /*
+   * Store the estimators 'total' (see stat_merge) in
+   * 'directory/summary.csv' (one line per quantity at time T, f(X_T)
+   * with and without variance reduction last, see stat_reduce) and
+   * the time profile in 'directory/profile.csv' (one line per step).
+   * Each line reads 'label, count, mean, variance, lower and upper
+   * bounds of the confidence interval', but the last 'ess_gain' one
+   * of summary.csv, which holds the gain in effective sample size of
+   * variance reduction (see stat_ess_gain, 'exact' if infinite) in
+   * place of the mean.
+   *
+   * Returns 0 on success, STAT_ERR_OPEN otherwise.
+   */
+
+  char filename[4096 + 16];
+  char label[64];
+  const unsigned int quantities = set->functional > 0 ? set->functional
+    : set->quantities;
+  accumulator reduced;
+  double gain;
+  FILE *output;
+
+  snprintf(filename, sizeof filename, "%s/summary.csv", directory);
+  output = fopen(filename, "w");
+  if (output == NULL)
+  {
+    return STAT_ERR_OPEN;
+  }
+  fprintf(output, "quantity,count,mean,variance,ci_low,ci_high\n");
+  for (unsigned int k = 0; k < quantities; ++k)
+  {
+    print_acc_in_csv(output, quantity_names[k], &total[k], set->confidence,
+		     set->float_prec);
+  }
+  if (set->functional > 0)
+  {
+    stat_reduce(set, total, &reduced);
+    print_acc_in_csv(output, functional_names[0], &total[set->functional],
+		     set->confidence, set->float_prec);
+    print_acc_in_csv(output, functional_names[1], &reduced, set->confidence,
+		     set->float_prec);
+    gain = stat_ess_gain(&total[set->functional], &reduced);
+    if (isinf(gain))
+    {
+      fprintf(output, "ess_gain,%llu,exact,,,\n", reduced.count);
+    }
+    else
+    {
+      fprintf(output, "ess_gain,%llu,%.4g,,,\n", reduced.count, gain);
+    }
+  }
+  fclose(output);
+
+  snprintf(filename, sizeof filename, "%s/profile.csv", directory);
+  output = fopen(filename, "w");
+  if (output == NULL)
+  {
+    return STAT_ERR_OPEN;
+  }
+  fprintf(output, "time,count,mean,variance,ci_low,ci_high\n");
+  for (unsigned int j = 0; j < set->profile_size; ++j)
+  {
+    snprintf(label, sizeof label, "%.*f", (int)set->float_prec,
+	     j * set->step);
+    print_acc_in_csv(output, label, &total[set->quantities + j],
+		     set->confidence, set->float_prec);
+  }
+  fclose(output);
+
+  return 0;
+} /* end of stat_write_csv function */
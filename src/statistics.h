@@ -0,0 +1,138 @@
+/*
+ * Filename: statistics.h
+ *
+ * Summary: defines online estimators of the mean and the variance of
+ * a quantity computed along a Monte Carlo simulation.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+
+#define STAT_MAGIC "EDSSTAT\0"
+#define STAT_VERSION 4
+#define STAT_QUANTITIES 4
+#define STAT_REDUCED 4
+
+typedef enum {STAT_ERR_OPEN=-3072, STAT_ERR_FORMAT, STAT_ERR_ALLOC}
+  stat_error_t;
+
+struct accumulator
+{
+  /*
+   * Running count, mean and sum of squared deviations from the mean
+   * (Welford), with the rounding errors of the last two (Kahan). Do
+   * not write in members manually, prefer using functions below.
+   */
+  
+  unsigned long long count;
+  double mean;
+  double m2;
+  double mean_error;
+  double m2_error;
+};
+
+struct stat_blocks
+{
+  /*
+   * Accumulators of a run split in 'blocks' blocks of paths (the
+   * replicates if 'replicates' > 0, the strata if 'strata' > 0), of
+   * which the blocks 'first' to 'last' - 1 were computed, e.g. by a
+   * shard of the run. Every block holds 'quantities' accumulators at
+   * time T (approximation, then reference, strong and weak errors),
+   * then 'profile_size' of the time profile, one every 'step'.
+   *
+   * With variance reduction, the STAT_REDUCED quantities from
+   * 'functional' (0 otherwise) are f(X_T) for every path, then for
+   * every sample (a pair of antithetic paths, averaged, or a path)
+   * f(X_T), the control variate Z and f(X_T) + Z (see stat_reduce).
+   *
+   * Blocks computed by several shards are merged, in order, into the
+   * estimators of the whole run (see stat_merge).
+   */
+
+  uint64_t seed;
+  uint64_t iter;
+  double step;
+  double confidence;
+  uint32_t quantities;
+  uint32_t profile_size;
+  uint32_t blocks;
+  uint32_t first;
+  uint32_t last;
+  uint32_t replicates;
+  uint32_t float_prec;
+  uint32_t precision;       /* see precision_kind */
+  uint32_t functional;
+  uint32_t antithetic;
+  uint32_t control;         /* 1 if Z is a control variate */
+  uint32_t strata;
+  double control_mean;      /* E[Z] */
+  struct accumulator *data; /* every block, one after the other */
+};
+
+typedef struct accumulator accumulator;
+typedef struct stat_blocks stat_blocks;
+
+extern void
+acc_init(accumulator *acc);
+
+extern void
+acc_push(accumulator *acc, double value);
+
+extern void
+acc_merge(accumulator *acc, const accumulator *other);
+
+extern double
+acc_variance(const accumulator *acc);
+
+extern double
+acc_half_width(const accumulator *acc, double confidence);
+
+extern double
+normal_quantile(double p);
+
+extern int
+print_acc_in_csv(FILE *output, const char *label, const accumulator *acc,
+		 double confidence, unsigned int precision);
+
+extern size_t
+stat_block_size(const stat_blocks *set);
+
+extern int
+stat_blocks_init(stat_blocks *set);
+
+extern void
+stat_blocks_free(stat_blocks *set);
+
+extern int
+stat_blocks_store(const char *filename, const stat_blocks *set);
+
+extern int
+stat_blocks_load(const char *filename, stat_blocks *set);
+
+extern void
+stat_merge(const stat_blocks *set, accumulator *total);
+
+extern void
+stat_reduce(const stat_blocks *set, const accumulator *total,
+	    accumulator *reduced);
+
+extern double
+stat_ess_gain(const accumulator *plain, const accumulator *reduced);
+
+extern int
+stat_write_csv(const char *directory, const stat_blocks *set,
+	       const accumulator *total);
+
+
+#endif /* STATISTICS_H */
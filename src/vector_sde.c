@@ -0,0 +1,296 @@
+/*
+ * Filename: vector_sde.c
+ *
+ * Summary: implements the approximation of systems of stochastic
+ * differential equations driven by correlated Brownian motions.
+ *
+ * Paths are computed by batches, in lockstep, by the Euler-Maruyama
+ * scheme. Correlated increments are L Z, Z being standard normal and
+ * L the Cholesky factor of the correlation matrix.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "brownian_path.h"
+#include "vector_sde.h"
+
+
+int
+cholesky_factor(const double *matrix, unsigned int size, double *lower)
+{
+  /*
+   * Store in 'lower' the lower triangular L such that L L^T =
+   * 'matrix' (size x size, symmetric, row by row).
+   *
+   * Returns 0 on success, VECTOR_ERR_NOT_POSITIVE if 'matrix' is not
+   * positive definite.
+   */
+
+  double sum;
+
+  for (unsigned int i = 0; i < size; ++i)
+  {
+    for (unsigned int j = 0; j < size; ++j)
+    {
+      if (j > i)
+      {
+	lower[i * size + j] = 0;
+	continue;
+      }
+
+      sum = matrix[i * size + j];
+      for (unsigned int k = 0; k < j; ++k)
+      {
+	sum -= lower[i * size + k] * lower[j * size + k];
+      }
+
+      if (i == j)
+      {
+	if (!(sum > 0))
+	{
+	  return VECTOR_ERR_NOT_POSITIVE;
+	}
+	lower[i * size + i] = sqrt(sum);
+      }
+      else
+      {
+	lower[i * size + j] = sum / lower[j * size + j];
+      }
+    } /* end of for-loop */
+  } /* end of for-loop */
+
+  return 0;
+} /* end of cholesky_factor function */
+
+
+void
+matrix_vector(unsigned int rows, unsigned int cols, const double *matrix,
+	      const double *vector, double *out)
+{
+  /*
+   * Add the product of 'matrix' (rows x cols, row by row) and
+   * 'vector' to 'out', one column at a time.
+   */
+
+  for (unsigned int r = 0; r < rows; ++r)
+  {
+    for (unsigned int c = 0; c < cols; ++c)
+    {
+      out[r] += matrix[r * cols + c] * vector[c];
+    }
+  }
+} /* end of matrix_vector function */
+
+
+size_t
+vector_index(const vector_sde *sde, unsigned int paths, unsigned int width,
+	     unsigned int p, unsigned int k)
+{
+  /*
+   * Index of the value k of the path p in a block of 'paths' paths
+   * of 'width' values each (d for states, m for Brownian motions),
+   * see vector_layout.
+   */
+
+  return sde->layout == LAYOUT_SOA ? (size_t)k * paths + p
+    : (size_t)p * width + k;
+} /* end of vector_index function */
+
+
+double *
+vector_brownian_into(const vector_sde *sde, prng_state *rng,
+		     double max_time, double brownian_prec,
+		     unsigned int paths, unsigned int p,
+		     double *brownian_motion)
+{
+  /*
+   * Simulate the m correlated Brownian motions of the path p of a
+   * batch of 'paths' paths, every 'brownian_prec' over [0, max_time]:
+   * step j of the batch starts at j * paths * m. Normal numbers are
+   * drawn step by step, then factor by factor. Returns
+   * 'brownian_motion'.
+   *
+   * With m = 1, the motion is the one of brownian_path_into.
+   */
+
+  const unsigned int length = floor(max_time / brownian_prec) + 1;
+  const unsigned int m = sde->factors;
+  const size_t block = (size_t)paths * m;
+  const double scale = sqrt(brownian_prec);
+  const double *lower = sde->cholesky;
+  double *cur, *prev, sum;
+
+  for (unsigned int f = 0; f < m; ++f)
+  {
+    brownian_motion[vector_index(sde, paths, m, p, f)] = 0;
+  }
+
+  for (unsigned int i = 1; i < length; ++i)
+  {
+    prev = brownian_motion + (i - 1) * block;
+    cur = brownian_motion + i * block;
+
+    for (unsigned int f = 0; f < m; ++f)
+    {
+      cur[vector_index(sde, paths, m, p, f)] = rand_normal(rng);
+    }
+
+    /* L Z in place, from the last factor since L is lower. */
+    for (unsigned int f = m; f-- > 0;)
+    {
+      sum = 0;
+      for (unsigned int g = 0; g <= f; ++g)
+      {
+	sum += lower[f * m + g] * cur[vector_index(sde, paths, m, p, g)];
+      }
+      cur[vector_index(sde, paths, m, p, f)] = sum;
+    }
+
+    for (unsigned int f = 0; f < m; ++f)
+    {
+      const size_t at = vector_index(sde, paths, m, p, f);
+      cur[at] = prev[at] + scale * cur[at];
+    }
+  } /* end of for-loop */
+
+  return brownian_motion;
+} /* end of vector_brownian_into function */
+
+
+size_t
+vector_scratch_size(const vector_sde *sde, unsigned int paths)
+{
+  /* Number of doubles of the scratch of vector_euler_maruyama_into. */
+
+  const size_t d = sde->dimension, m = sde->factors;
+
+  return 2 * d + d * m + m + d * paths + d * m * paths;
+} /* end of vector_scratch_size function */
+
+
+double *
+vector_euler_maruyama_into(const vector_sde *sde, double max_time,
+			   double d_time, unsigned int paths,
+			   const double *init, const double *brownian_motion,
+			   unsigned int factor, double *path,
+			   double *scratch)
+{
+  /*
+   * Compute 'paths' pathwise approximations at once using
+   * Euler-Maruyama method.
+   *
+   * Parameters
+   * ----------
+   *
+   * max_time, d_time : double
+   *   See euler_maruyama_method.
+   *
+   * paths : unsigned int
+   *   Number of paths computed at once.
+   *
+   * init : array of double
+   *   Initial states ('paths * d' values, see vector_layout).
+   *
+   * brownian_motion : array of double
+   *   Brownian motions of the paths (see vector_brownian_into), with
+   *   precision d_time / factor.
+   *
+   * path : array of double
+   *   Output, 'steps + 1' blocks of 'paths * d' values.
+   *
+   * scratch : array of double
+   *   vector_scratch_size(sde, paths) values.
+   *
+   *
+   * Returns
+   * -------
+   *
+   * 'path', or NULL if max_time is not positive. Values do not
+   * depend on the layout nor on the number of paths; with d = m = 1,
+   * they are the ones of euler_maruyama_into.
+   */
+
+  if (max_time <= 0 || paths == 0) {
+    return NULL;
+  }
+
+  const unsigned int steps = floor(max_time / d_time);
+  const unsigned int d = sde->dimension, m = sde->factors;
+  const size_t states = (size_t)paths * d;
+  const size_t noises = (size_t)paths * m;
+  double *pos = scratch;
+  double *drift = pos + d;
+  double *matrix = drift + d;
+  double *d_brownian = matrix + (size_t)d * m;
+  double *restrict drifts = d_brownian + m;
+  double *restrict diffusions = drifts + states;
+
+  memcpy(path, init, states * sizeof *path);
+
+  for (unsigned int j = 1; j < steps + 1; ++j) {
+    const double time = j * d_time;
+    const double *restrict prev = path + (j - 1) * states;
+    const double *restrict b_prev = brownian_motion
+      + (size_t)(j - 1) * factor * noises;
+    const double *restrict b_cur = brownian_motion
+      + (size_t)j * factor * noises;
+    double *restrict cur = path + j * states;
+
+    if (sde->layout == LAYOUT_INTERLEAVED) {
+      for (unsigned int p = 0; p < paths; ++p) {
+	sde->drift(time, prev + p * d, drift);
+	sde->diffusion(time, prev + p * d, matrix);
+	for (unsigned int f = 0; f < m; ++f) {
+	  d_brownian[f] = b_cur[p * m + f] - b_prev[p * m + f];
+	}
+
+	for (unsigned int k = 0; k < d; ++k) {
+	  cur[p * d + k] = prev[p * d + k] + d_time * drift[k];
+	}
+	matrix_vector(d, m, matrix, d_brownian, cur + p * d);
+      } /* end of for-loop */
+      continue;
+    }
+
+    /* Structure of arrays: evaluate the model path by path... */
+    for (unsigned int p = 0; p < paths; ++p) {
+      for (unsigned int k = 0; k < d; ++k) {
+	pos[k] = prev[k * paths + p];
+      }
+      sde->drift(time, pos, drift);
+      sde->diffusion(time, pos, matrix);
+      for (unsigned int k = 0; k < d; ++k) {
+	drifts[k * paths + p] = drift[k];
+      }
+      for (size_t km = 0; km < (size_t)d * m; ++km) {
+	diffusions[km * paths + p] = matrix[km];
+      }
+    } /* end of for-loop */
+
+    /* ...then update every path at once, as matrix_vector does. */
+    for (unsigned int k = 0; k < d; ++k) {
+      for (unsigned int p = 0; p < paths; ++p) {
+	cur[k * paths + p] = prev[k * paths + p]
+	  + d_time * drifts[k * paths + p];
+      }
+      for (unsigned int f = 0; f < m; ++f) {
+	const double *restrict column = diffusions
+	  + ((size_t)k * m + f) * paths;
+
+	for (unsigned int p = 0; p < paths; ++p) {
+	  cur[k * paths + p] += column[p]
+	    * (b_cur[f * paths + p] - b_prev[f * paths + p]);
+	}
+      }
+    } /* end of for-loop */
+  } /* end of for-loop */
+
+  return path;
+} /* end of vector_euler_maruyama_into function */
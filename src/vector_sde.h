@@ -0,0 +1,89 @@
+/*
+ * Filename: vector_sde.h
+ *
+ * Summary: defines the approximation of systems of stochastic
+ * differential equations,
+ *
+ *   dX_t = a(t, X_t) dt + B(t, X_t) dW_t,
+ *
+ * X being d-dimensional, B a d x m matrix and W an m-dimensional
+ * Brownian motion whose increments are correlated.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#ifndef VECTOR_SDE_H
+#define VECTOR_SDE_H
+
+#include <stddef.h>
+
+#include "prng.h"
+
+
+typedef enum {VECTOR_ERR_NOT_POSITIVE=-2048} vector_error_t;
+
+/*
+ * Layout of the states of a batch of paths at a given step.
+ *
+ * LAYOUT_INTERLEAVED: the d values of a path are contiguous, value k
+ *   of path p being at p * d + k.
+ * LAYOUT_SOA: value k of every path is contiguous, value k of path p
+ *   being at k * paths + p (structure of arrays): the diffusion
+ *   product runs over paths and is vectorized by the compiler.
+ *
+ * Brownian motions follow the same layout, with m values per path.
+ */
+typedef enum {LAYOUT_INTERLEAVED=1, LAYOUT_SOA} vector_layout;
+
+/*
+ * Given the time and a state (d contiguous values), stores the drift
+ * (d values) or the diffusion matrix (d x m values, row by row) in
+ * the third argument.
+ */
+typedef void (*vector_func)(double time, const double *pos, double *out);
+
+struct vector_sde
+{
+  unsigned int dimension;  /* d */
+  unsigned int factors;    /* m */
+  vector_func drift;
+  vector_func diffusion;
+  const double *cholesky;  /* m x m, lower triangular, row by row */
+  vector_layout layout;
+};
+
+typedef struct vector_sde vector_sde;
+
+extern int
+cholesky_factor(const double *matrix, unsigned int size, double *lower);
+
+extern void
+matrix_vector(unsigned int rows, unsigned int cols, const double *matrix,
+	      const double *vector, double *out);
+
+extern double *
+vector_brownian_into(const vector_sde *sde, prng_state *rng,
+		     double max_time, double brownian_prec,
+		     unsigned int paths, unsigned int p,
+		     double *brownian_motion);
+
+extern size_t
+vector_scratch_size(const vector_sde *sde, unsigned int paths);
+
+extern double *
+vector_euler_maruyama_into(const vector_sde *sde, double max_time,
+			   double d_time, unsigned int paths,
+			   const double *init, const double *brownian_motion,
+			   unsigned int factor, double *path,
+			   double *scratch);
+
+extern size_t
+vector_index(const vector_sde *sde, unsigned int paths, unsigned int width,
+	     unsigned int p, unsigned int k);
+
+
+#endif /* VECTOR_SDE_H */
@@ -0,0 +1,68 @@
+/*
+ * Filename: bin2csv.c
+ *
+ * Summary: print a binary file produced by compute_approximation (see
+ * binary_format.h) as CSV on the standard output.
+ *
+ * Usage: bin2csv.exe FILE [PRECISION]
+ *
+ * The output is the CSV file that compute_approximation would have
+ * produced with the COMMA format and FLOAT_PREC set to PRECISION
+ * (default: 10). The header is printed on the standard error.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binary_format.h"
+
+
+int
+main(int argc, char **argv)
+{
+  bin_file input;
+  int precision = 10;
+
+  if (argc < 2)
+  {
+    fprintf(stderr, "Usage: %s FILE [PRECISION]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (argc > 2)
+  {
+    precision = atoi(argv[2]);
+  }
+
+  if (bin_open(&input, argv[1]) != 0)
+  {
+    fprintf(stderr, "Fatal:   Cannot read binary file %s.\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  fprintf(stderr, "Path:    %llu\n", (unsigned long long)input.header.path);
+  fprintf(stderr, "Seed:    %llu\n", (unsigned long long)input.header.seed);
+  fprintf(stderr, "Step:    %.*f\n", precision, input.header.step);
+  fprintf(stderr, "Bound:   %.*f\n", precision, input.header.time_bound);
+  fprintf(stderr, "Columns: %u\n", input.header.columns);
+  fprintf(stderr, "Rows:    %llu\n", (unsigned long long)input.header.rows);
+
+  for (uint64_t j = 0; j < input.header.rows; ++j)
+  {
+    for (unsigned int c = 0; c < input.header.columns; ++c)
+    {
+      printf("%.*f,", precision, bin_column(&input, c)[j]);
+    }
+    printf("\n");
+  }
+
+  bin_close(&input);
+  
+  return EXIT_SUCCESS;
+} /* end of main */
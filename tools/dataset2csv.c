@@ -0,0 +1,95 @@
+/*
+ * Filename: dataset2csv.c
+ *
+ * Summary: print a path of a dataset produced by compute_approximation
+ * (see binary_format.h) as CSV on the standard output.
+ *
+ * Usage: dataset2csv.exe FILE [PATH [PRECISION]]
+ *
+ * PATH is numbered from 1, as the files 'data_PATH.csv'. The output
+ * is the CSV file that compute_approximation would have produced for
+ * it with the COMMA format and FLOAT_PREC set to PRECISION (default:
+ * 10). Without PATH, the index of the dataset is printed. The header
+ * is printed on the standard error.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "binary_format.h"
+
+
+int
+main(int argc, char **argv)
+{
+  bin_dataset input;
+  const double *columns;
+  uint64_t path, rows;
+  int precision = 10;
+
+  if (argc < 2)
+  {
+    fprintf(stderr, "Usage: %s FILE [PATH [PRECISION]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (argc > 3)
+  {
+    precision = atoi(argv[3]);
+  }
+
+  if (bin_dataset_open(&input, argv[1]) != 0)
+  {
+    fprintf(stderr, "Fatal:   Cannot read dataset %s.\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  fprintf(stderr, "Paths:   %llu\n", (unsigned long long)input.count);
+  fprintf(stderr, "Seed:    %llu\n", (unsigned long long)input.header.seed);
+  fprintf(stderr, "Step:    %.*f\n", precision, input.header.step);
+  fprintf(stderr, "Bound:   %.*f\n", precision, input.header.time_bound);
+  fprintf(stderr, "Columns: %u\n", input.header.columns);
+
+  if (argc < 3)
+  {
+    for (uint64_t k = 0; k < input.count; ++k)
+    {
+      path = bin_dataset_path(&input, k);
+      bin_dataset_find(&input, path, &rows);
+      printf("%llu,%llu,\n", (unsigned long long)path + 1,
+	     (unsigned long long)rows);
+    }
+    bin_dataset_close(&input);
+    return EXIT_SUCCESS;
+  }
+
+  path = strtoull(argv[2], NULL, 10);
+  columns = path > 0 ? bin_dataset_find(&input, path - 1, &rows) : NULL;
+  if (columns == NULL)
+  {
+    fprintf(stderr, "Fatal:   No path %s in dataset %s.\n", argv[2],
+	    argv[1]);
+    bin_dataset_close(&input);
+    return EXIT_FAILURE;
+  }
+
+  fprintf(stderr, "Rows:    %llu\n", (unsigned long long)rows);
+  for (uint64_t j = 0; j < rows; ++j)
+  {
+    for (unsigned int c = 0; c < input.header.columns; ++c)
+    {
+      printf("%.*f,", precision, columns[c * rows + j]);
+    }
+    printf("\n");
+  }
+
+  bin_dataset_close(&input);
+
+  return EXIT_SUCCESS;
+} /* end of main */
@@ -0,0 +1,316 @@
+/*
+ * Filename: merge_shards.c
+ *
+ * Summary: merge the outputs of the shards of a run (see --shard)
+ * into the outputs of the whole run.
+ *
+ * Usage: merge_shards.exe OUTPUT SHARD...
+ *
+ * Every SHARD is the output directory of a shard of the same run, in
+ * any order. Datasets (dataset.bin, see OUTPUT) are merged in the
+ * order of paths, and estimators (estimators.bin, see STATISTICS) in
+ * the order of blocks: OUTPUT then holds the dataset, or the summary
+ * and profile, that the run would have produced in a single process.
+ * Trajectory files (data_N.csv, data_N.bin) are numbered after the
+ * whole run already and are simply gathered in a single directory.
+ *
+ * Author: bdj <bdosse(at)student.uliege.be>
+ *
+ * Creation date: 2026-10-17
+ *
+ * License: see LICENSE file.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "binary_format.h"
+#include "statistics.h"
+
+
+#define NAME_SIZE 4096
+
+
+static int
+same_run(const stat_blocks *a, const stat_blocks *b)
+{
+  return a->seed == b->seed && a->iter == b->iter && a->step == b->step
+    && a->confidence == b->confidence && a->quantities == b->quantities
+    && a->profile_size == b->profile_size && a->blocks == b->blocks
+    && a->replicates == b->replicates && a->float_prec == b->float_prec
+    && a->precision == b->precision && a->functional == b->functional
+    && a->antithetic == b->antithetic && a->control == b->control
+    && a->strata == b->strata && a->control_mean == b->control_mean;
+} /* end of same_run function */
+
+
+static int
+merge_estimators(const char *output, char **shards, int count)
+{
+  /*
+   * Merge the blocks of every shard, which must be the blocks of a
+   * single run, each of them computed once. Returns the number of
+   * shards merged, -1 on error.
+   */
+
+  char filename[NAME_SIZE + 32];
+  stat_blocks run = {0}, shard;
+  accumulator *total;
+  size_t size;
+  int merged = 0;
+  unsigned int covered = 0;
+  unsigned char *done = NULL;
+
+  for (int s = 0; s < count; ++s)
+  {
+    snprintf(filename, sizeof filename, "%s/estimators.bin", shards[s]);
+    if (stat_blocks_load(filename, &shard) != 0)
+    {
+      continue;
+    }
+
+    if (merged == 0)
+    {
+      run = shard;
+      run.first = 0;
+      run.last = run.blocks;
+      done = calloc(run.blocks > 0 ? run.blocks : 1, 1);
+      if (stat_blocks_init(&run) != 0 || done == NULL)
+      {
+	fprintf(stderr, "Fatal:   Not enough memory.\n");
+	stat_blocks_free(&shard);
+	stat_blocks_free(&run);
+	free(done);
+	return -1;
+      }
+    }
+    else if (!same_run(&run, &shard))
+    {
+      fprintf(stderr, "Fatal:   %s is not a shard of the same run.\n",
+	      filename);
+      stat_blocks_free(&shard);
+      stat_blocks_free(&run);
+      free(done);
+      return -1;
+    }
+
+    size = stat_block_size(&shard);
+    for (unsigned int b = shard.first; b < shard.last; ++b)
+    {
+      if (done[b])
+      {
+	fprintf(stderr, "Fatal:   Block %u is in several shards (%s).\n",
+		b + 1, filename);
+	stat_blocks_free(&shard);
+	stat_blocks_free(&run);
+	free(done);
+	return -1;
+      }
+      done[b] = 1;
+      covered++;
+      memcpy(run.data + b * size, shard.data + b * size,
+	     size * sizeof *run.data);
+    }
+    stat_blocks_free(&shard);
+    merged++;
+  } /* end of for-loop */
+
+  if (merged == 0)
+  {
+    return 0;
+  }
+
+  if (covered < run.blocks)
+  {
+    fprintf(stderr, "Warn:    %u of %u blocks only: shards are missing.\n",
+	    covered, run.blocks);
+  }
+
+  total = malloc(stat_block_size(&run) * sizeof *total);
+  if (total != NULL)
+  {
+    stat_merge(&run, total);
+  }
+
+  if (total == NULL || stat_write_csv(output, &run, total) != 0)
+  {
+    fprintf(stderr, "Fatal:   Cannot store the estimators in %s.\n", output);
+    merged = -1;
+  }
+  else
+  {
+    printf("Success: %d shards merged in '%s/summary.csv'\n", merged,
+	   output);
+  }
+
+  free(total);
+  free(done);
+  stat_blocks_free(&run);
+
+  return merged;
+} /* end of merge_estimators function */
+
+
+static int
+compare_first_path(const void *a, const void *b)
+{
+  const bin_dataset *x = a, *y = b;
+  const uint64_t first_x = x->count > 0 ? bin_dataset_path(x, 0) : 0;
+  const uint64_t first_y = y->count > 0 ? bin_dataset_path(y, 0) : 0;
+
+  return (first_x > first_y) - (first_x < first_y);
+} /* end of compare_first_path function */
+
+
+static int
+merge_datasets(const char *output, char **shards, int count)
+{
+  /*
+   * Append the records of the dataset of every shard, by increasing
+   * path number, to a single dataset. Returns the number of shards
+   * merged, -1 on error.
+   */
+
+  char filename[NAME_SIZE + 32];
+  bin_dataset *sets = malloc(count * sizeof *sets);
+  bin_dataset merged;
+  const double *columns;
+  double *record;
+  uint64_t path, rows, next = 0;
+  int opened = 0, status = 0;
+
+  if (sets == NULL)
+  {
+    fprintf(stderr, "Fatal:   Not enough memory.\n");
+    return -1;
+  }
+
+  for (int s = 0; s < count; ++s)
+  {
+    snprintf(filename, sizeof filename, "%s/dataset.bin", shards[s]);
+    if (bin_dataset_open(&sets[opened], filename) == 0)
+    {
+      opened++;
+    }
+  }
+
+  if (opened == 0)
+  {
+    free(sets);
+    return 0;
+  }
+  qsort(sets, opened, sizeof *sets, &compare_first_path);
+
+  for (int s = 1; s < opened && status == 0; ++s)
+  {
+    if (sets[s].header.columns != sets[0].header.columns
+	|| sets[s].header.step != sets[0].header.step
+	|| sets[s].header.time_bound != sets[0].header.time_bound
+	|| sets[s].header.seed != sets[0].header.seed)
+    {
+      fprintf(stderr, "Fatal:   Datasets are not shards of the same run.\n");
+      status = -1;
+    }
+  }
+
+  snprintf(filename, sizeof filename, "%s/dataset.bin", output);
+  if (status == 0 && bin_dataset_create(&merged, filename, &sets[0].header)
+      != 0)
+  {
+    fprintf(stderr, "Fatal:   Cannot create dataset %s.\n", filename);
+    status = -1;
+  }
+
+  for (int s = 0; s < opened && status == 0; ++s)
+  {
+    for (uint64_t k = 0; k < sets[s].count && status == 0; ++k)
+    {
+      path = bin_dataset_path(&sets[s], k);
+      columns = bin_dataset_find(&sets[s], path, &rows);
+      if (path < next || columns == NULL)
+      {
+	fprintf(stderr, "Fatal:   Path %llu is in several shards.\n",
+		(unsigned long long)path + 1);
+	status = -1;
+	break;
+      }
+      next = path + 1;
+
+      record = bin_dataset_append(&merged, path, rows);
+      if (record == NULL)
+      {
+	fprintf(stderr, "Fatal:   Cannot write dataset %s.\n", filename);
+	status = -1;
+	break;
+      }
+      memcpy(record, columns,
+	     (size_t)sets[s].header.columns * rows * sizeof *record);
+    }
+  } /* end of for-loop */
+
+  if (status == 0 && bin_dataset_close(&merged) != 0)
+  {
+    fprintf(stderr, "Fatal:   Cannot complete dataset %s.\n", filename);
+    status = -1;
+  }
+  else if (status == 0)
+  {
+    printf("Success: %d shards merged in '%s'\n", opened, filename);
+  }
+
+  for (int s = 0; s < opened; ++s)
+  {
+    bin_dataset_close(&sets[s]);
+  }
+  free(sets);
+
+  return status == 0 ? opened : -1;
+} /* end of merge_datasets function */
+
+
+int
+main(int argc, char **argv)
+{
+  struct stat st;
+  int datasets, estimators;
+
+  if (argc < 3)
+  {
+    fprintf(stderr, "Usage: %s OUTPUT SHARD...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (strlen(argv[1]) >= NAME_SIZE
+      || (stat(argv[1], &st) == -1 && mkdir(argv[1], 0700) == -1))
+  {
+    fprintf(stderr, "Fatal:   Cannot create directory %s.\n", argv[1]);
+    return EXIT_FAILURE;
+  }
+
+  for (int s = 2; s < argc; ++s)
+  {
+    if (strlen(argv[s]) >= NAME_SIZE)
+    {
+      fprintf(stderr, "Fatal:   Path too long: %s.\n", argv[s]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  datasets = merge_datasets(argv[1], argv + 2, argc - 2);
+  estimators = merge_estimators(argv[1], argv + 2, argc - 2);
+
+  if (datasets < 0 || estimators < 0)
+  {
+    return EXIT_FAILURE;
+  }
+
+  if (datasets == 0 && estimators == 0)
+  {
+    fprintf(stderr, "Fatal:   No dataset.bin nor estimators.bin to merge.\n");
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+} /* end of main */